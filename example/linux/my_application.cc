@@ -5,6 +5,8 @@
 #include <gdk/gdkx.h>
 #endif
 
+#include <wayland_layer_shell/wayland_layer_shell_plugin.h>
+
 #include "flutter/generated_plugin_registrant.h"
 
 struct _MyApplication
@@ -55,6 +57,25 @@ static void my_application_activate(GApplication *application)
   }
 
   gtk_window_set_default_size(window, 1280, 720);
+
+  // Set up the layer surface before the engine starts so the first frame
+  // already shows up as a layer surface. The defaults match the initialize()
+  // call in main.dart and can be overridden with --layer-shell-* arguments.
+  WaylandLayerShellConfig layer_config;
+  wayland_layer_shell_config_init(&layer_config);
+  layer_config.width = 650;
+  layer_config.height = 600;
+  gboolean found = FALSE;
+  g_autoptr(GError) config_error = nullptr;
+  if (!wayland_layer_shell_config_load_args(
+          &layer_config, self->dart_entrypoint_arguments, &found,
+          &config_error))
+  {
+    g_warning("Invalid layer shell options: %s", config_error->message);
+  }
+  wayland_layer_shell_bootstrap(window, &layer_config);
+  wayland_layer_shell_config_clear(&layer_config);
+
   gtk_widget_realize(GTK_WIDGET(window));
 
   g_autoptr(FlDartProject) project = fl_dart_project_new();
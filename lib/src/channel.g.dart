@@ -0,0 +1,212 @@
+// GENERATED CODE - DO NOT MODIFY BY HAND.
+// Generated by tool/generate_channel.dart from tool/channel_schema.json.
+
+import 'package:flutter/services.dart';
+
+/// Typed client for the `wayland_layer_shell` method channel. Arguments are sent
+/// positionally, in schema order.
+class LayerShellChannel {
+  const LayerShellChannel(this.methodChannel);
+
+  final MethodChannel methodChannel;
+
+  Future<String?> getPlatformVersion() {
+    return methodChannel.invokeMethod<String>('getPlatformVersion');
+  }
+
+  Future<bool?> isSupported() {
+    return methodChannel.invokeMethod<bool>('isSupported');
+  }
+
+  Future<Map<Object?, Object?>?> getCapabilities() {
+    return methodChannel.invokeMethod<Map<Object?, Object?>>('getCapabilities');
+  }
+
+  Future<bool?> isFfiWindow() {
+    return methodChannel.invokeMethod<bool>('isFfiWindow');
+  }
+
+  Future<Map<Object?, Object?>?> initialize(int width, int height, String? monitor) {
+    return methodChannel.invokeMethod<Map<Object?, Object?>>('initialize', <Object?>[width, height, monitor]);
+  }
+
+  Future<bool?> showWindow() {
+    return methodChannel.invokeMethod<bool>('showWindow');
+  }
+
+  Future<bool?> prepare() {
+    return methodChannel.invokeMethod<bool>('prepare');
+  }
+
+  Future<bool?> present(bool exclusiveKeyboard) {
+    return methodChannel.invokeMethod<bool>('present', <Object?>[exclusiveKeyboard]);
+  }
+
+  Future<bool?> dismiss() {
+    return methodChannel.invokeMethod<bool>('dismiss');
+  }
+
+  Future<bool?> setLayer(int layer) {
+    return methodChannel.invokeMethod<bool>('setLayer', <Object?>[layer]);
+  }
+
+  Future<int?> getLayer() {
+    return methodChannel.invokeMethod<int>('getLayer');
+  }
+
+  Future<List<Object?>?> getMonitorList() {
+    return methodChannel.invokeMethod<List<Object?>>('getMonitorList');
+  }
+
+  Future<bool?> setMonitor(int id) {
+    return methodChannel.invokeMethod<bool>('setMonitor', <Object?>[id]);
+  }
+
+  Future<bool?> setAnchor(int edge, bool anchorToEdge) {
+    return methodChannel.invokeMethod<bool>('setAnchor', <Object?>[edge, anchorToEdge]);
+  }
+
+  Future<bool?> getAnchor(int edge) {
+    return methodChannel.invokeMethod<bool>('getAnchor', <Object?>[edge]);
+  }
+
+  Future<bool?> setMargin(int edge, int marginSize) {
+    return methodChannel.invokeMethod<bool>('setMargin', <Object?>[edge, marginSize]);
+  }
+
+  Future<int?> getMargin(int edge) {
+    return methodChannel.invokeMethod<int>('getMargin', <Object?>[edge]);
+  }
+
+  Future<bool?> setExclusiveZone(int exclusiveZone) {
+    return methodChannel.invokeMethod<bool>('setExclusiveZone', <Object?>[exclusiveZone]);
+  }
+
+  Future<int?> getExclusiveZone() {
+    return methodChannel.invokeMethod<int>('getExclusiveZone');
+  }
+
+  Future<bool?> enableAutoExclusiveZone() {
+    return methodChannel.invokeMethod<bool>('enableAutoExclusiveZone');
+  }
+
+  Future<bool?> isAutoExclusiveZoneEnabled() {
+    return methodChannel.invokeMethod<bool>('isAutoExclusiveZoneEnabled');
+  }
+
+  Future<bool?> setKeyboardMode(int keyboardMode) {
+    return methodChannel.invokeMethod<bool>('setKeyboardMode', <Object?>[keyboardMode]);
+  }
+
+  Future<int?> getKeyboardMode() {
+    return methodChannel.invokeMethod<int>('getKeyboardMode');
+  }
+
+  Future<bool?> setSize(int width, int height) {
+    return methodChannel.invokeMethod<bool>('setSize', <Object?>[width, height]);
+  }
+
+  Future<Map<Object?, Object?>?> applyConfig(int? layer, List<bool?>? anchors, List<int?>? margins, int? exclusiveZone, bool? autoExclusiveZone, int? keyboardMode) {
+    return methodChannel.invokeMethod<Map<Object?, Object?>>('applyConfig', <Object?>[layer, anchors, margins, exclusiveZone, autoExclusiveZone, keyboardMode]);
+  }
+
+  Future<bool?> flush() {
+    return methodChannel.invokeMethod<bool>('flush');
+  }
+
+  Future<Map<Object?, Object?>?> getCommitStats() {
+    return methodChannel.invokeMethod<Map<Object?, Object?>>('getCommitStats');
+  }
+
+  Future<bool?> setInputRegion(List<int>? rects) {
+    return methodChannel.invokeMethod<bool>('setInputRegion', <Object?>[rects]);
+  }
+
+  Future<bool?> setOpaqueRegion(List<int>? rects) {
+    return methodChannel.invokeMethod<bool>('setOpaqueRegion', <Object?>[rects]);
+  }
+
+  Future<int?> animateMargins(List<int?>? from, List<int?> to, int durationMs, int easing) {
+    return methodChannel.invokeMethod<int>('animateMargins', <Object?>[from, to, durationMs, easing]);
+  }
+
+  Future<int?> animateSize(List<int>? from, List<int> to, int durationMs, int easing) {
+    return methodChannel.invokeMethod<int>('animateSize', <Object?>[from, to, durationMs, easing]);
+  }
+
+  Future<bool?> cancelAnimations() {
+    return methodChannel.invokeMethod<bool>('cancelAnimations');
+  }
+
+  Future<bool?> setRenderPolicy(int policy, int? fpsCap) {
+    return methodChannel.invokeMethod<bool>('setRenderPolicy', <Object?>[policy, fpsCap]);
+  }
+
+  Future<bool?> setFrameRateCap(int fps) {
+    return methodChannel.invokeMethod<bool>('setFrameRateCap', <Object?>[fps]);
+  }
+
+  Future<bool?> setAutoHide(bool enabled, int edge, int stripSize, int revealDelayMs, int hideDelayMs) {
+    return methodChannel.invokeMethod<bool>('setAutoHide', <Object?>[enabled, edge, stripSize, revealDelayMs, hideDelayMs]);
+  }
+
+  Future<bool?> requestFrame() {
+    return methodChannel.invokeMethod<bool>('requestFrame');
+  }
+
+  Future<Map<Object?, Object?>?> getFrameStats() {
+    return methodChannel.invokeMethod<Map<Object?, Object?>>('getFrameStats');
+  }
+
+  Future<Map<Object?, Object?>?> getScaleInfo() {
+    return methodChannel.invokeMethod<Map<Object?, Object?>>('getScaleInfo');
+  }
+
+  Future<bool?> isPresentationSupported() {
+    return methodChannel.invokeMethod<bool>('isPresentationSupported');
+  }
+
+  Future<bool?> setLogLevel(int level) {
+    return methodChannel.invokeMethod<bool>('setLogLevel', <Object?>[level]);
+  }
+
+  Future<List<Object?>?> getLogRecords(int? maxRecords) {
+    return methodChannel.invokeMethod<List<Object?>>('getLogRecords', <Object?>[maxRecords]);
+  }
+
+  Future<Map<Object?, Object?>?> getStats() {
+    return methodChannel.invokeMethod<Map<Object?, Object?>>('getStats');
+  }
+
+  Future<bool?> resetStats() {
+    return methodChannel.invokeMethod<bool>('resetStats');
+  }
+
+  Future<bool?> startTracing(String? path) {
+    return methodChannel.invokeMethod<bool>('startTracing', <Object?>[path]);
+  }
+
+  Future<Map<Object?, Object?>?> stopTracing() {
+    return methodChannel.invokeMethod<Map<Object?, Object?>>('stopTracing');
+  }
+
+  Future<String?> listenControlSocket(String? path) {
+    return methodChannel.invokeMethod<String>('listenControlSocket', <Object?>[path]);
+  }
+
+  Future<bool?> closeControlSocket() {
+    return methodChannel.invokeMethod<bool>('closeControlSocket');
+  }
+
+  Future<bool?> activateToplevel(int id) {
+    return methodChannel.invokeMethod<bool>('activateToplevel', <Object?>[id]);
+  }
+
+  Future<bool?> setToplevelMinimized(int id, bool minimized) {
+    return methodChannel.invokeMethod<bool>('setToplevelMinimized', <Object?>[id, minimized]);
+  }
+
+  Future<bool?> closeToplevel(int id) {
+    return methodChannel.invokeMethod<bool>('closeToplevel', <Object?>[id]);
+  }
+}
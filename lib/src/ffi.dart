@@ -0,0 +1,136 @@
+import 'dart:ffi';
+
+import 'package:wayland_layer_shell/types.dart';
+
+typedef _GetNative = Int32 Function();
+typedef _Get = int Function();
+typedef _Get1Native = Int32 Function(Int32);
+typedef _Get1 = int Function(int);
+typedef _Set2Native = Int32 Function(Int32, Int32);
+typedef _Set2 = int Function(int, int);
+
+/// Synchronous bindings to the plugin's C API (linux/include/wayland_layer_shell/wayland_layer_shell_ffi.h).
+///
+/// Calls go straight to the plugin without encoding a message or waiting for the platform thread. They act on the first
+/// window the plugin manages in the process, whichever engine it belongs to.
+/// Getters read a snapshot the plugin keeps up to date, so they return the latest value set through
+/// either this API or the method channel. Setters are applied on the platform thread shortly after
+/// they return, through the same per-frame queue as the method channel.
+///
+/// Getters return null while no window is attached; setters return false then or when an argument is
+/// out of range.
+class WaylandLayerShellFfi {
+  WaylandLayerShellFfi._(DynamicLibrary library)
+      : _isAttached = library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_is_attached'),
+        _isSupported = library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_is_supported'),
+        _isInitialized = library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_is_initialized'),
+        _getLayer = library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_get_layer'),
+        _getAnchor = library.lookupFunction<_Get1Native, _Get1>('wayland_layer_shell_ffi_get_anchor'),
+        _getMargin = library.lookupFunction<_Get1Native, _Get1>('wayland_layer_shell_ffi_get_margin'),
+        _getExclusiveZone = library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_get_exclusive_zone'),
+        _isAutoExclusiveZoneEnabled =
+            library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_is_auto_exclusive_zone_enabled'),
+        _getKeyboardMode = library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_get_keyboard_mode'),
+        _setLayer = library.lookupFunction<_Get1Native, _Get1>('wayland_layer_shell_ffi_set_layer'),
+        _setAnchor = library.lookupFunction<_Set2Native, _Set2>('wayland_layer_shell_ffi_set_anchor'),
+        _setMargin = library.lookupFunction<_Set2Native, _Set2>('wayland_layer_shell_ffi_set_margin'),
+        _setExclusiveZone = library.lookupFunction<_Get1Native, _Get1>('wayland_layer_shell_ffi_set_exclusive_zone'),
+        _enableAutoExclusiveZone =
+            library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_enable_auto_exclusive_zone'),
+        _setKeyboardMode = library.lookupFunction<_Get1Native, _Get1>('wayland_layer_shell_ffi_set_keyboard_mode'),
+        _setSize = library.lookupFunction<_Set2Native, _Set2>('wayland_layer_shell_ffi_set_size'),
+        _setMonitor = library.lookupFunction<_Get1Native, _Get1>('wayland_layer_shell_ffi_set_monitor'),
+        _showWindow = library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_show_window'),
+        _flush = library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_flush');
+
+  /// The ABI version these bindings were written against.
+  static const int abiVersion = 1;
+
+  /// Loads the bindings, or returns null if the plugin library is not available (e.g. not on Linux)
+  /// or exports a different [abiVersion].
+  static WaylandLayerShellFfi? tryLoad() {
+    DynamicLibrary library;
+    try {
+      library = DynamicLibrary.open('libwayland_layer_shell_plugin.so');
+    } on ArgumentError {
+      library = DynamicLibrary.process();
+    }
+    try {
+      final version = library.lookupFunction<_GetNative, _Get>('wayland_layer_shell_ffi_abi_version');
+      if (version() != abiVersion) {
+        return null;
+      }
+      return WaylandLayerShellFfi._(library);
+    } on ArgumentError {
+      return null;
+    }
+  }
+
+  final _Get _isAttached;
+  final _Get _isSupported;
+  final _Get _isInitialized;
+  final _Get _getLayer;
+  final _Get1 _getAnchor;
+  final _Get1 _getMargin;
+  final _Get _getExclusiveZone;
+  final _Get _isAutoExclusiveZoneEnabled;
+  final _Get _getKeyboardMode;
+  final _Get1 _setLayer;
+  final _Set2 _setAnchor;
+  final _Set2 _setMargin;
+  final _Get1 _setExclusiveZone;
+  final _Get _enableAutoExclusiveZone;
+  final _Get1 _setKeyboardMode;
+  final _Set2 _setSize;
+  final _Get1 _setMonitor;
+  final _Get _showWindow;
+  final _Get _flush;
+
+  /// Whether the plugin attached the C API to a window yet.
+  bool get isAttached => _isAttached() == 1;
+
+  bool? get isLayerShellSupported => _bool(_isSupported());
+
+  bool? get isInitialized => _bool(_isInitialized());
+
+  ShellLayer? get layer => _enum(ShellLayer.values, _getLayer());
+
+  bool? getAnchor(ShellEdge edge) => _bool(_getAnchor(edge.index));
+
+  int? getMargin(ShellEdge edge) => isAttached ? _getMargin(edge.index) : null;
+
+  int? get exclusiveZone => isAttached ? _getExclusiveZone() : null;
+
+  bool? get isAutoExclusiveZoneEnabled => _bool(_isAutoExclusiveZoneEnabled());
+
+  ShellKeyboardMode? get keyboardMode => _enum(ShellKeyboardMode.values, _getKeyboardMode());
+
+  bool setLayer(ShellLayer layer) => _setLayer(layer.index) == 1;
+
+  bool setAnchor(ShellEdge edge, bool anchorToEdge) => _setAnchor(edge.index, anchorToEdge ? 1 : 0) == 1;
+
+  bool setMargin(ShellEdge edge, int marginSize) => _setMargin(edge.index, marginSize) == 1;
+
+  bool setExclusiveZone(int exclusiveZone) => _setExclusiveZone(exclusiveZone) == 1;
+
+  bool enableAutoExclusiveZone() => _enableAutoExclusiveZone() == 1;
+
+  bool setKeyboardMode(ShellKeyboardMode mode) => _setKeyboardMode(mode.index) == 1;
+
+  /// A dimension of 0 leaves it to the compositor, as [WaylandLayerShell.setSize] does.
+  bool setSize(int width, int height) => _setSize(width, height) == 1;
+
+  /// Moves the surface to the monitor with [id], as listed by [WaylandLayerShell.getMonitorList], or lets the
+  /// compositor choose with -1. An id without a connected monitor is only found out on the platform thread, which
+  /// logs it and ignores the call.
+  bool setMonitor(int id) => _setMonitor(id) == 1;
+
+  bool showWindow() => _showWindow() == 1;
+
+  /// Applies the changes set so far without waiting for the next frame.
+  bool flush() => _flush() == 1;
+
+  static bool? _bool(int value) => value < 0 ? null : value == 1;
+
+  static T? _enum<T>(List<T> values, int value) => value < 0 || value >= values.length ? null : values[value];
+}
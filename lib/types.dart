@@ -1,3 +1,5 @@
+import 'dart:ui';
+
 enum ShellLayer {
   layerBackground, // The background layer.
   layerBottom, // The bottom layer.
@@ -21,14 +23,703 @@ enum ShellKeyboardMode {
   keyboardModeEntryNumber, // Should not be used except to get the number of entries.
 }
 
+enum ShellEasing {
+  linear, // Constant speed.
+  easeIn, // Starts slowly and accelerates (cubic).
+  easeOut, // Starts quickly and decelerates (cubic).
+  easeInOut, // Accelerates, then decelerates (cubic).
+}
+
+enum ShellLogLevel {
+  off, // Log nothing.
+  error, // Failures that make a call fail.
+  warning, // Problems the plugin could recover from.
+  info, // Lifecycle events such as initialization.
+  debug, // Details of individual calls.
+}
+
+enum ShellRenderPolicy {
+  continuous, // Present every frame, up to the output refresh rate.
+  capped, // Present at most a fixed number of frames per second.
+  onDemand, // Present a frame only when requested.
+}
+
 class Monitor {
+  /// Stable id of this monitor. It does not change when other monitors are plugged in or out,
+  /// and a monitor that is reconnected gets its previous id back.
   final int id;
+
+  /// The model name of the monitor.
   final String name;
+  final String manufacturer;
+
+  /// Position and size of the monitor in application pixels.
+  final Rect geometry;
+
+  /// The part of [geometry] not covered by exclusive zones of panels.
+  final Rect workarea;
+  final int scaleFactor;
+
+  /// Refresh rate in Hz, or 0 if unknown.
+  final double refreshRate;
+  final int widthMm;
+  final int heightMm;
 
-  Monitor(this.id, this.name);
+  Monitor(
+    this.id,
+    this.name, {
+    this.manufacturer = '',
+    this.geometry = Rect.zero,
+    this.workarea = Rect.zero,
+    this.scaleFactor = 1,
+    this.refreshRate = 0,
+    this.widthMm = 0,
+    this.heightMm = 0,
+  });
+
+  factory Monitor.fromMap(Map<dynamic, dynamic> map) {
+    Rect rect(List<dynamic> values) =>
+        Rect.fromLTWH(values[0].toDouble(), values[1].toDouble(), values[2].toDouble(), values[3].toDouble());
+    return Monitor(
+      map['id'] as int,
+      map['model'] as String,
+      manufacturer: map['manufacturer'] as String,
+      geometry: rect(map['geometry']),
+      workarea: rect(map['workarea']),
+      scaleFactor: map['scale_factor'] as int,
+      refreshRate: (map['refresh_rate'] as int) / 1000.0,
+      widthMm: map['width_mm'] as int,
+      heightMm: map['height_mm'] as int,
+    );
+  }
 
   @override
   String toString() {
     return '$id:$name';
   }
 }
+
+enum MonitorEventKind {
+  added, // A monitor was connected.
+  changed, // A property (geometry, workarea, scale, refresh rate, ...) of a monitor changed.
+  removed, // A monitor was disconnected.
+}
+
+/// A change in the set of connected monitors, see [WaylandLayerShell.monitorEvents].
+class MonitorEvent {
+  final MonitorEventKind kind;
+
+  /// The id of the monitor that changed.
+  final int id;
+
+  /// The new state of the monitor; null for [MonitorEventKind.removed].
+  final Monitor? monitor;
+
+  MonitorEvent(this.kind, this.id, this.monitor);
+
+  factory MonitorEvent.fromMap(Map<dynamic, dynamic> map) {
+    return MonitorEvent(
+      MonitorEventKind.values.byName(map['event'] as String),
+      map['id'] as int,
+      map['monitor'] == null ? null : Monitor.fromMap(map['monitor']),
+    );
+  }
+
+  @override
+  String toString() {
+    return 'MonitorEvent($kind, $id, $monitor)';
+  }
+}
+
+enum SurfaceEventKind {
+  configured, // The compositor configured the surface; see [SurfaceEvent.width] and [SurfaceEvent.height].
+  mapped, // The surface was mapped.
+  unmapped, // The surface was unmapped.
+  state, // The layer, monitor, exclusive zone or keyboard mode changed.
+  closed, // The window is about to be destroyed, e.g. because the compositor closed its surface as its output went away.
+  focusGained, // The surface gained keyboard focus.
+  focusLost, // The surface lost keyboard focus.
+  hidden, // Auto-hide shrank the surface into its trigger strip, see [WaylandLayerShell.setAutoHide].
+  revealed, // Auto-hide restored the surface.
+  remapped, // The surface was unmapped and mapped again to apply a change; see [SurfaceEvent.remapReasons].
+}
+
+/// Changes that can make the plugin remap the surface, see [SurfaceEventKind.remapped].
+enum RemapReason {
+  layer, // The layer changed on a compositor that cannot change it in place.
+  monitor, // The surface moved to another monitor.
+}
+
+/// A change of the layer surface, see [WaylandLayerShell.surfaceEvents].
+class SurfaceEvent {
+  final SurfaceEventKind kind;
+
+  /// When the event was sent, on the monotonic clock that `Timeline.now` also reads.
+  final Duration time;
+
+  /// The configured size, for [SurfaceEventKind.configured].
+  final int? width;
+  final int? height;
+
+  /// When the last surface commit before a [SurfaceEventKind.configured] event happened, on the
+  /// same clock as [time]; `time - lastCommit` is the latency of the compositor's reply. Null before
+  /// the first commit.
+  final Duration? lastCommit;
+
+  /// The new state, for [SurfaceEventKind.state].
+  final ShellLayer? layer;
+
+  /// The [Monitor.id] of the monitor the surface is placed on, or -1 if the compositor decides.
+  final int? monitor;
+  final int? exclusiveZone;
+  final bool? autoExclusiveZone;
+  final ShellKeyboardMode? keyboardMode;
+
+  /// The changes that required the remap, for [SurfaceEventKind.remapped].
+  final Set<RemapReason>? remapReasons;
+
+  SurfaceEvent(
+    this.kind,
+    this.time, {
+    this.width,
+    this.height,
+    this.lastCommit,
+    this.layer,
+    this.monitor,
+    this.exclusiveZone,
+    this.autoExclusiveZone,
+    this.keyboardMode,
+    this.remapReasons,
+  });
+
+  factory SurfaceEvent.fromMap(Map<dynamic, dynamic> map) {
+    final lastCommit = map['last_commit_us'] as int?;
+    final reasons = map['reasons'] as List<Object?>?;
+    return SurfaceEvent(
+      SurfaceEventKind.values.byName(map['event'] as String),
+      Duration(microseconds: map['time_us'] as int),
+      width: map['width'] as int?,
+      height: map['height'] as int?,
+      lastCommit: lastCommit == null || lastCommit == 0 ? null : Duration(microseconds: lastCommit),
+      layer: map['layer'] == null ? null : ShellLayer.values[map['layer'] as int],
+      monitor: map['monitor'] as int?,
+      exclusiveZone: map['exclusive_zone'] as int?,
+      autoExclusiveZone: map['auto_exclusive_zone'] as bool?,
+      keyboardMode: map['keyboard_mode'] == null ? null : ShellKeyboardMode.values[map['keyboard_mode'] as int],
+      remapReasons:
+          reasons == null ? null : {for (final reason in reasons) RemapReason.values.byName(reason as String)},
+    );
+  }
+
+  @override
+  String toString() {
+    switch (kind) {
+      case SurfaceEventKind.configured:
+        return 'SurfaceEvent($kind, $time, ${width}x$height, lastCommit: $lastCommit)';
+      case SurfaceEventKind.state:
+        return 'SurfaceEvent($kind, $time, layer: $layer, monitor: $monitor, exclusiveZone: $exclusiveZone, '
+            'autoExclusiveZone: $autoExclusiveZone, keyboardMode: $keyboardMode)';
+      case SurfaceEventKind.remapped:
+        return 'SurfaceEvent($kind, $time, remapReasons: $remapReasons)';
+      default:
+        return 'SurfaceEvent($kind, $time)';
+    }
+  }
+}
+
+/// A complete (or partial) description of the layer surface state, applied at
+/// once with [WaylandLayerShell.applyConfig].
+///
+/// Fields that are null, and edges missing from [anchors] / [margins], are left
+/// unchanged when the config is applied.
+class LayerConfig {
+  final ShellLayer? layer;
+  final Map<ShellEdge, bool>? anchors;
+  final Map<ShellEdge, int>? margins;
+
+  /// A fixed exclusive zone. Takes precedence over [autoExclusiveZone].
+  final int? exclusiveZone;
+
+  /// Whether the exclusive zone follows the surface size. Only has an effect
+  /// when set to true and no fixed [exclusiveZone] is given.
+  final bool? autoExclusiveZone;
+  final ShellKeyboardMode? keyboardMode;
+
+  const LayerConfig({
+    this.layer,
+    this.anchors,
+    this.margins,
+    this.exclusiveZone,
+    this.autoExclusiveZone,
+    this.keyboardMode,
+  });
+
+  factory LayerConfig.fromMap(Map<dynamic, dynamic> map) {
+    final anchors = List<bool>.from(map['anchors']);
+    final margins = List<int>.from(map['margins']);
+    return LayerConfig(
+      layer: ShellLayer.values[map['layer'] as int],
+      anchors: {for (final edge in edges) edge: anchors[edge.index]},
+      margins: {for (final edge in edges) edge: margins[edge.index]},
+      exclusiveZone: map['exclusive_zone'] as int,
+      autoExclusiveZone: map['auto_exclusive_zone'] as bool,
+      keyboardMode: ShellKeyboardMode.values[map['keyboard_mode'] as int],
+    );
+  }
+
+  /// The edges in the order used for per-edge lists on the method channel.
+  static const edges = [ShellEdge.edgeLeft, ShellEdge.edgeRight, ShellEdge.edgeTop, ShellEdge.edgeBottom];
+
+  @override
+  String toString() {
+    return 'LayerConfig(layer: $layer, anchors: $anchors, margins: $margins, exclusiveZone: $exclusiveZone, '
+        'autoExclusiveZone: $autoExclusiveZone, keyboardMode: $keyboardMode)';
+  }
+}
+
+/// Counters for how many layer surface setter calls were received, how many of
+/// them changed nothing, and how many surface commits the rest were coalesced
+/// into.
+class CommitStats {
+  final int setterCalls;
+  final int elidedCalls;
+  final int commits;
+
+  /// How many of the [commits] had to remap the surface, see [SurfaceEventKind.remapped].
+  final int remaps;
+  final int regionUpdates;
+  final int elidedRegionUpdates;
+
+  CommitStats(
+      this.setterCalls, this.elidedCalls, this.commits, this.remaps, this.regionUpdates, this.elidedRegionUpdates);
+
+  factory CommitStats.fromMap(Map<dynamic, dynamic> map) {
+    return CommitStats(map['setter_calls'] as int, map['elided_calls'] as int, map['commits'] as int,
+        map['remaps'] as int, map['region_updates'] as int, map['elided_region_updates'] as int);
+  }
+
+  @override
+  String toString() {
+    return 'CommitStats(setterCalls: $setterCalls, elidedCalls: $elidedCalls, commits: $commits, remaps: $remaps, '
+        'regionUpdates: $regionUpdates, elidedRegionUpdates: $elidedRegionUpdates)';
+  }
+}
+
+/// What gtk-layer-shell and the compositor support, see [WaylandLayerShell.getCapabilities].
+class LayerShellCapabilities {
+  /// Version of the gtk-layer-shell library the app runs with, e.g. "0.8.2".
+  final String libraryVersion;
+
+  /// Version of zwlr_layer_shell_v1 the compositor offers; 0 if it does not support layer shell.
+  final int protocolVersion;
+
+  /// Whether [WaylandLayerShell.setLayer] changes the layer of a visible surface in place. If not, every layer change
+  /// remaps the surface.
+  final bool layerChangeInPlace;
+
+  /// Whether the edge an exclusive zone applies to can be chosen (protocol version 5 and gtk-layer-shell 0.9).
+  final bool exclusiveEdge;
+
+  /// The keyboard modes the compositor honors.
+  final Set<ShellKeyboardMode> keyboardModes;
+
+  LayerShellCapabilities(
+      this.libraryVersion, this.protocolVersion, this.layerChangeInPlace, this.exclusiveEdge, this.keyboardModes);
+
+  factory LayerShellCapabilities.fromMap(Map<dynamic, dynamic> map) {
+    return LayerShellCapabilities(
+      map['library_version'] as String,
+      map['protocol_version'] as int,
+      map['layer_change_in_place'] as bool,
+      map['exclusive_edge'] as bool,
+      {for (final mode in map['keyboard_modes'] as List<Object?>) ShellKeyboardMode.values[mode as int]},
+    );
+  }
+
+  @override
+  String toString() {
+    return 'LayerShellCapabilities(libraryVersion: $libraryVersion, protocolVersion: $protocolVersion, '
+        'layerChangeInPlace: $layerChangeInPlace, exclusiveEdge: $exclusiveEdge, keyboardModes: $keyboardModes)';
+  }
+}
+
+/// How long the steps of [WaylandLayerShell.initialize] took. Steps that were not needed are null.
+class InitializeTimings {
+  /// Hiding the already visible window.
+  final Duration? hide;
+
+  /// Setting up the layer surface.
+  final Duration? init;
+
+  /// Waiting for the compositor to configure the shown layer surface.
+  final Duration? firstConfigure;
+
+  InitializeTimings({this.hide, this.init, this.firstConfigure});
+
+  factory InitializeTimings.fromMap(Map<dynamic, dynamic> map) {
+    Duration? duration(String key) => map[key] == null ? null : Duration(microseconds: map[key] as int);
+    return InitializeTimings(
+      hide: duration('hide_us'),
+      init: duration('init_us'),
+      firstConfigure: duration('configure_us'),
+    );
+  }
+
+  @override
+  String toString() {
+    return 'InitializeTimings(hide: $hide, init: $init, firstConfigure: $firstConfigure)';
+  }
+}
+
+/// A record from the native log ring, see [WaylandLayerShell.getLogRecords].
+class LogRecord {
+  final DateTime time;
+  final ShellLogLevel level;
+  final String message;
+
+  LogRecord(this.time, this.level, this.message);
+
+  factory LogRecord.fromMap(Map<dynamic, dynamic> map) {
+    return LogRecord(
+      DateTime.fromMicrosecondsSinceEpoch(map['time_us'] as int),
+      ShellLogLevel.values[map['level'] as int],
+      map['message'] as String,
+    );
+  }
+
+  @override
+  String toString() {
+    return '$time [${level.name}] $message';
+  }
+}
+
+/// Frame statistics of the surface, see [WaylandLayerShell.getFrameStats].
+class FrameStats {
+  final ShellRenderPolicy policy;
+
+  /// The frame rate cap, 0 unless [policy] is [ShellRenderPolicy.capped].
+  final int requestedFps;
+
+  /// Frames per second presented since the policy was last set.
+  final double achievedFps;
+  final int frames;
+
+  /// How often a frame was held back by the policy.
+  final int heldFrames;
+  final Duration elapsed;
+
+  FrameStats(this.policy, this.requestedFps, this.achievedFps, this.frames, this.heldFrames, this.elapsed);
+
+  factory FrameStats.fromMap(Map<dynamic, dynamic> map) {
+    return FrameStats(
+      ShellRenderPolicy.values[map['policy'] as int],
+      map['requested_fps'] as int,
+      map['achieved_fps'] as double,
+      map['frames'] as int,
+      map['held_frames'] as int,
+      Duration(microseconds: map['elapsed_us'] as int),
+    );
+  }
+
+  @override
+  String toString() {
+    return 'FrameStats(policy: ${policy.name}, requestedFps: $requestedFps, achievedFps: $achievedFps, '
+        'frames: $frames, heldFrames: $heldFrames, elapsed: $elapsed)';
+  }
+}
+
+/// A trace file written by [WaylandLayerShell.stopTracing].
+class TraceResult {
+  final String path;
+  final int events;
+
+  /// Events overwritten because the trace outgrew the native buffer; the oldest go first.
+  final int droppedEvents;
+
+  TraceResult(this.path, this.events, this.droppedEvents);
+
+  factory TraceResult.fromMap(Map<dynamic, dynamic> map) {
+    return TraceResult(map['path'] as String, map['events'] as int, map['dropped_events'] as int);
+  }
+
+  @override
+  String toString() {
+    return 'TraceResult(path: $path, events: $events, droppedEvents: $droppedEvents)';
+  }
+}
+
+/// When a frame of the surface reached the screen, see [WaylandLayerShell.presentedFrames].
+class PresentedFrame {
+  /// False if the compositor discarded the frame without showing it; the other fields are then zero.
+  final bool presented;
+
+  /// When the frame turned into light, on the monotonic clock Flutter's timeline uses.
+  final Duration time;
+
+  /// From GTK painting the frame until [time].
+  final Duration latency;
+
+  /// Time until the next refresh of the output; zero if unknown or variable (e.g. adaptive sync).
+  final Duration refreshInterval;
+
+  /// Vertical retrace counter of the output, 0 if it has none.
+  final int sequence;
+
+  /// Whether presentation was synchronized to the vertical retrace, [time] came from the display hardware,
+  /// completion was signalled by the hardware, and the buffer was scanned out directly.
+  final bool vsync;
+  final bool hwClock;
+  final bool hwCompletion;
+  final bool zeroCopy;
+
+  /// The [Monitor.id] of the output the frame was shown on, or -1 if unknown.
+  final int monitorId;
+
+  PresentedFrame(this.presented, this.time, this.latency, this.refreshInterval, this.sequence, this.vsync, this.hwClock,
+      this.hwCompletion, this.zeroCopy, this.monitorId);
+
+  factory PresentedFrame.fromMap(Map<dynamic, dynamic> map) {
+    final flags = map['flags'] as int;
+    return PresentedFrame(
+      map['presented'] as bool,
+      Duration(microseconds: map['time_us'] as int),
+      Duration(microseconds: map['latency_us'] as int),
+      Duration(microseconds: (map['refresh_ns'] as int) ~/ 1000),
+      map['sequence'] as int,
+      flags & 0x1 != 0,
+      flags & 0x2 != 0,
+      flags & 0x4 != 0,
+      flags & 0x8 != 0,
+      map['monitor'] as int,
+    );
+  }
+
+  @override
+  String toString() {
+    return 'PresentedFrame(presented: $presented, time: $time, latency: $latency, '
+        'refreshInterval: $refreshInterval, sequence: $sequence, vsync: $vsync, monitorId: $monitorId)';
+  }
+}
+
+enum ToplevelEventKind {
+  added, // A window opened, or was there when listening started; all fields are set.
+  changed, // Some fields of a window changed; the others are null.
+  closed, // A window closed; all fields are null.
+}
+
+enum ToplevelState {
+  maximized,
+  minimized,
+  activated,
+  fullscreen,
+}
+
+/// A change to the windows of all apps, see [WaylandLayerShell.toplevelEvents].
+class ToplevelEvent {
+  final ToplevelEventKind kind;
+
+  /// Identifies the window for as long as the app runs.
+  final int id;
+  final String? appId;
+  final String? title;
+  final Set<ToplevelState>? state;
+
+  /// The [Monitor.id]s of the monitors the window is visible on.
+  final List<int>? monitorIds;
+
+  /// The [id] of the window this one is a dialog of, 0 if none.
+  final int? parentId;
+
+  ToplevelEvent(this.kind, this.id, this.appId, this.title, this.state, this.monitorIds, this.parentId);
+
+  factory ToplevelEvent.fromMap(Map<dynamic, dynamic> map) {
+    final state = map['state'] as int?;
+    return ToplevelEvent(
+      ToplevelEventKind.values.byName(map['event'] as String),
+      map['id'] as int,
+      map['app_id'] as String?,
+      map['title'] as String?,
+      state == null ? null : {for (final value in ToplevelState.values) if (state & (1 << value.index) != 0) value},
+      (map['monitors'] as List?)?.cast<int>(),
+      map['parent'] as int?,
+    );
+  }
+
+  @override
+  String toString() {
+    return 'ToplevelEvent($kind, $id, appId: $appId, title: $title, state: $state, monitorIds: $monitorIds, '
+        'parentId: $parentId)';
+  }
+}
+
+/// A command another process ran on the control socket, see [WaylandLayerShell.controlCommands].
+class ControlCommand {
+  /// The command, e.g. 'toggle' or 'setLayer'.
+  final String command;
+  final List<String> args;
+
+  ControlCommand(this.command, this.args);
+
+  factory ControlCommand.fromMap(Map<dynamic, dynamic> map) {
+    return ControlCommand(map['command'] as String, (map['args'] as List).cast<String>());
+  }
+
+  @override
+  String toString() {
+    return 'ControlCommand($command, $args)';
+  }
+}
+
+/// Scale of the surface, see [WaylandLayerShell.getScaleInfo].
+class ScaleInfo {
+  /// Whether the compositor offers wp_fractional_scale_v1 (and the plugin was built with it).
+  final bool fractionalScaleSupported;
+  final bool viewporterSupported;
+
+  /// The scale the compositor prefers for the surface, e.g. 1.5; 0 if unknown.
+  final double preferredScale;
+
+  /// The integer scale GTK renders the surface at.
+  final int bufferScale;
+  final int width;
+  final int height;
+
+  /// Pixels rasterized per frame at [bufferScale].
+  final int renderedPixels;
+
+  /// Pixels a frame at exactly [preferredScale] would need.
+  final int exactPixels;
+
+  ScaleInfo(this.fractionalScaleSupported, this.viewporterSupported, this.preferredScale, this.bufferScale, this.width,
+      this.height, this.renderedPixels, this.exactPixels);
+
+  factory ScaleInfo.fromMap(Map<dynamic, dynamic> map) {
+    return ScaleInfo(
+      map['fractional_scale_supported'] as bool,
+      map['viewporter_supported'] as bool,
+      map['preferred_scale'] as double,
+      map['buffer_scale'] as int,
+      map['width'] as int,
+      map['height'] as int,
+      map['rendered_pixels'] as int,
+      map['exact_pixels'] as int,
+    );
+  }
+
+  @override
+  String toString() {
+    return 'ScaleInfo(fractionalScaleSupported: $fractionalScaleSupported, viewporterSupported: $viewporterSupported, '
+        'preferredScale: $preferredScale, bufferScale: $bufferScale, size: ${width}x$height, '
+        'renderedPixels: $renderedPixels, exactPixels: $exactPixels)';
+  }
+}
+
+/// Call statistics of one method channel method, see [WaylandLayerShell.getStats].
+class MethodStats {
+  final int calls;
+  final int errors;
+  final Duration total;
+  final Duration max;
+
+  /// Latency percentiles, rounded up to the histogram bucket they fall into (at most 25% high).
+  final Duration p50;
+  final Duration p90;
+  final Duration p99;
+
+  /// Number of calls per latency bucket, keyed by the smallest latency in the bucket, in nanoseconds.
+  final Map<int, int> histogram;
+
+  MethodStats(this.calls, this.errors, this.total, this.max, this.p50, this.p90, this.p99, this.histogram);
+
+  factory MethodStats.fromMap(Map<dynamic, dynamic> map) {
+    Duration nanoseconds(String key) => Duration(microseconds: (map[key] as int) ~/ 1000);
+    return MethodStats(
+      map['calls'] as int,
+      map['errors'] as int,
+      nanoseconds('total_ns'),
+      nanoseconds('max_ns'),
+      nanoseconds('p50_ns'),
+      nanoseconds('p90_ns'),
+      nanoseconds('p99_ns'),
+      (map['histogram'] as Map<dynamic, dynamic>).cast<int, int>(),
+    );
+  }
+
+  @override
+  String toString() {
+    return 'MethodStats(calls: $calls, errors: $errors, p50: $p50, p99: $p99, max: $max)';
+  }
+}
+
+/// Auto-hide statistics, see [WaylandLayerShell.setAutoHide].
+class AutoHideStats {
+  final int hides;
+  final int reveals;
+
+  /// Time from the pointer entering the trigger strip until the compositor configured the full surface again,
+  /// reveal delay included.
+  final Duration lastReveal;
+  final Duration maxReveal;
+  final Duration meanReveal;
+
+  /// Wall time spent hidden, and the process CPU time used meanwhile.
+  final Duration hidden;
+  final Duration hiddenCpu;
+
+  AutoHideStats(
+      this.hides, this.reveals, this.lastReveal, this.maxReveal, this.meanReveal, this.hidden, this.hiddenCpu);
+
+  factory AutoHideStats.fromMap(Map<dynamic, dynamic> map) {
+    Duration microseconds(String key) => Duration(microseconds: map[key] as int);
+    return AutoHideStats(
+      map['hides'] as int,
+      map['reveals'] as int,
+      microseconds('last_reveal_us'),
+      microseconds('max_reveal_us'),
+      microseconds('mean_reveal_us'),
+      microseconds('hidden_us'),
+      microseconds('hidden_cpu_us'),
+    );
+  }
+
+  @override
+  String toString() {
+    return 'AutoHideStats(hides: $hides, reveals: $reveals, meanReveal: $meanReveal, hidden: $hidden, '
+        'hiddenCpu: $hiddenCpu)';
+  }
+}
+
+/// Snapshot of the native statistics, see [WaylandLayerShell.getStats].
+class PluginStats {
+  /// Whether the plugin was built with statistics; [methods] is empty otherwise.
+  final bool enabled;
+
+  /// Statistics per method channel method name, for the methods that were called.
+  final Map<String, MethodStats> methods;
+
+  /// Layer surface commits and monitor enumerations.
+  final int commits;
+  final int monitorEnumerations;
+
+  /// Auto-hide counters, kept whether or not the plugin was built with statistics.
+  final AutoHideStats autoHide;
+
+  PluginStats(this.enabled, this.methods, this.commits, this.monitorEnumerations, this.autoHide);
+
+  factory PluginStats.fromMap(Map<dynamic, dynamic> map) {
+    return PluginStats(
+      map['enabled'] as bool,
+      (map['methods'] as Map<dynamic, dynamic>)
+          .map((name, stats) => MapEntry(name as String, MethodStats.fromMap(stats as Map<dynamic, dynamic>))),
+      map['commits'] as int,
+      map['monitor_enumerations'] as int,
+      AutoHideStats.fromMap(map['auto_hide'] as Map<dynamic, dynamic>),
+    );
+  }
+
+  @override
+  String toString() {
+    return 'PluginStats(commits: $commits, monitorEnumerations: $monitorEnumerations, '
+        'autoHide: $autoHide, methods: $methods)';
+  }
+}
@@ -1,83 +1,190 @@
+import 'dart:async';
+import 'dart:ui';
+
+import 'package:flutter/scheduler.dart';
 import 'package:flutter/services.dart';
+import 'package:wayland_layer_shell/src/channel.g.dart';
+import 'package:wayland_layer_shell/src/ffi.dart';
 import 'package:wayland_layer_shell/types.dart';
 
+export 'package:wayland_layer_shell/src/ffi.dart' show WaylandLayerShellFfi;
+
 class WaylandLayerShell {
   final methodChannel = const MethodChannel('wayland_layer_shell');
 
+  /// Events pushed by the native side, each a map whose 'event' key names its kind.
+  static final Stream<Map<Object?, Object?>> _events = const EventChannel('wayland_layer_shell/events')
+      .receiveBroadcastStream()
+      .map((event) => event as Map<Object?, Object?>);
+
+  static final Stream<MonitorEvent> _monitorEvents = const EventChannel('wayland_layer_shell/monitors')
+      .receiveBroadcastStream()
+      .map((event) => MonitorEvent.fromMap(event as Map<dynamic, dynamic>));
+
+  static final Stream<SurfaceEvent> _surfaceEvents = const EventChannel('wayland_layer_shell/surface')
+      .receiveBroadcastStream()
+      .map((event) => SurfaceEvent.fromMap(event as Map<dynamic, dynamic>));
+
+  static final Stream<List<ToplevelEvent>> _toplevelEvents = const EventChannel('wayland_layer_shell/toplevels')
+      .receiveBroadcastStream()
+      .map((batch) => (batch as List).map((event) => ToplevelEvent.fromMap(event as Map<dynamic, dynamic>)).toList());
+
+  static final Stream<PresentedFrame> _presentedFrames = const EventChannel('wayland_layer_shell/presentation')
+      .receiveBroadcastStream()
+      .map((event) => PresentedFrame.fromMap(event as Map<dynamic, dynamic>));
+
+  /// Synchronous access to the layer surface state through dart:ffi, or null if the plugin's C API
+  /// is not available. The C API serves a single window per process, the first one the plugin manages. The getters
+  /// below use it when that is this engine's window and fall back to the method channel otherwise.
+  static final WaylandLayerShellFfi? ffi = WaylandLayerShellFfi.tryLoad();
+
+  /// Whether [ffi] is attached to this engine's window, asked once over the method channel. Each engine runs its
+  /// own isolate, so this is per engine.
+  static Future<bool>? _ffiIsOurs;
+
+  /// [ffi] if it answers for this engine's window.
+  Future<WaylandLayerShellFfi?> get _attachedFfi async {
+    final bindings = ffi;
+    if (bindings == null || !bindings.isAttached) {
+      return null;
+    }
+    final ours = await (_ffiIsOurs ??= _channel.isFfiWindow().then((value) => value ?? false));
+    return ours ? bindings : null;
+  }
+
+  /// Generated from tool/channel_schema.json; arguments are sent positionally.
+  LayerShellChannel get _channel => LayerShellChannel(methodChannel);
+
   Future<String?> getPlatformVersion() async {
-    final version = await methodChannel.invokeMethod<String>('getPlatformVersion');
-    return version;
+    return await _channel.getPlatformVersion();
   }
 
   /// Returns: 'true' if the platform is Wayland and Wayland compositor supports the
   /// zwlr_layer_shell_v1 protocol. If not supported, returns 'false' and initialize
   /// gtk window as normal window
   Future<bool> isLayerShellSupported() async {
-    return await methodChannel.invokeMethod('isSupported');
+    return (await _channel.isSupported()) ?? false;
+  }
+
+  /// Returns: the layer shell protocol version of the compositor and what it allows, probed once per process. Use it
+  /// to avoid changes that are expensive on the running compositor, e.g. switching layers where
+  /// [LayerShellCapabilities.layerChangeInPlace] is false.
+  Future<LayerShellCapabilities> getCapabilities() async {
+    return LayerShellCapabilities.fromMap((await _channel.getCapabilities())!);
   }
 
   /// @width: The width of the surface. default is 1280
   /// @height: The height of the surface. default is 720
+  /// @monitor: The [Monitor.toString] (or [Monitor.id] as a string) of the monitor to place the
+  /// surface on. Defaults to letting the compositor decide.
   ///
   /// Initialize the layer shell protocol.
   /// checks if the platform is Wayland and Wayland compositor supports the
   /// zwlr_layer_shell_v1 protocol so no need use isLayerShellSupported first.
   ///
+  /// If the window is already visible it is hidden for the setup and shown again afterwards; the
+  /// returned future then completes once the compositor configured the new layer surface. Throws a
+  /// [PlatformException] with code 'timeout' if that does not happen in time. How long each step
+  /// took is available from [initializeTimings] afterwards.
+  ///
+  /// If the runner already set the surface up with `wayland_layer_shell_bootstrap`, the existing
+  /// state is adopted as is and this returns right away; [width], [height] and [monitor] are not
+  /// applied then.
+  ///
   /// Returns: 'true' if platform is Wayland and Wayland compositor supports
   /// the zwlr_layer_shell_v1 protocol, if not supported, returns 'false' and initialize
   /// gtk window as normal window
   Future<bool> initialize(int width, int height, {String? monitor}) async {
-    final args = <String, dynamic>{
-      'width': width,
-      'height': height,
-      if (monitor != null) 'monitor': monitor,
-    };
-    final result = await methodChannel.invokeMethod('initialize', args);
-    return result ?? false;
+    final result = await _channel.initialize(width, height, monitor);
+    if (result == null) {
+      return false;
+    }
+    final timings = result['timings'];
+    if (timings != null) {
+      initializeTimings = InitializeTimings.fromMap(timings as Map<dynamic, dynamic>);
+    }
+    return result['initialized'] as bool;
   }
 
+  /// How long the steps of the last [initialize] call that set up the layer surface took.
+  InitializeTimings? initializeTimings;
+
   /// @layer: The [ShellLayer] on which this surface appears.
   ///
   /// Set the "layer" on which the surface appears (controls if it is over top of or below other surfaces). The layer may
   /// be changed on-the-fly in the current version of the layer shell protocol, but on compositors that only support an
-  /// older version the @window is remapped so the change can take effect.
+  /// older version the @window is remapped so the change can take effect; see
+  /// [LayerShellCapabilities.layerChangeInPlace]. Changes made together with it are applied in the same remap, which is
+  /// reported as a [SurfaceEventKind.remapped] event.
   ///
   /// Default is %GTK_LAYER_SHELL_LAYER_TOP
   Future<void> setLayer(ShellLayer layer) async {
-    final Map<String, dynamic> arguments = {
-      'layer': layer.index,
-    };
-    await methodChannel.invokeMethod('setLayer', arguments);
+    await _channel.setLayer(layer.index);
   }
 
   /// Returns: the current layer as [ShellLayer].
   Future<ShellLayer> getLayer() async {
-    return ShellLayer.values[(await methodChannel.invokeMethod('getLayer')) as int];
+    return (await _attachedFfi)?.layer ?? ShellLayer.values[(await _channel.getLayer())!];
   }
 
   /// Returns: the list of all [Monitor]s connected to the computer.
+  ///
+  /// The list comes from a native cache that follows monitor hotplug, so calling this is cheap.
   Future<List<Monitor>> getMonitorList() async {
-    List<String> monitors = List<String>.from(await methodChannel.invokeMethod('getMonitorList'));
-    return monitors.map((e) {
-      final i = e.indexOf(':');
-      return Monitor(int.parse(e.substring(0, i)), e.substring(i + 1));
-    }).toList();
+    final monitors = (await _channel.getMonitorList())!;
+    return monitors.map((e) => Monitor.fromMap(e as Map<dynamic, dynamic>)).toList();
   }
 
+  /// Monitors being connected, disconnected or changing geometry, workarea, scale or refresh rate.
+  /// Only the monitor that changed is sent.
+  Stream<MonitorEvent> get monitorEvents => _monitorEvents;
+
   /// @monitor: The [Monitor] that this surface will be placed on.
   /// (null to let the compositor decide)
   ///
-  /// Set the monitor this surface will be placed on.
+  /// Set the monitor this surface will be placed on. The monitor is looked up by its stable
+  /// [Monitor.id], so this keeps working after other monitors were plugged in or out. Moving a visible surface to
+  /// another monitor remaps it, together with any other change made in the same frame.
   Future<void> setMonitor(Monitor? monitor) async {
-    final Map<String, dynamic> arguments = {
-      'id': monitor == null ? -1 : monitor.id,
-    };
-    await methodChannel.invokeMethod('setMonitor', arguments);
+    await _channel.setMonitor(monitor == null ? -1 : monitor.id);
   }
 
   Future<bool> showWindow() async {
-    final result = await methodChannel.invokeMethod('showWindow');
-    return result ?? false;
+    return (await _channel.showWindow()) ?? false;
+  }
+
+  /// Map the surface out of sight so that [present] can show it without creating and configuring a new surface,
+  /// e.g. for a launcher summoned by a hotkey. Call it after [initialize] and after setting the surface up.
+  ///
+  /// The surface is moved just past the bottom edge of its output at its current size, without an exclusive zone or
+  /// keyboard interactivity; its previous anchors, margins, size, exclusive zone and keyboard mode are restored by
+  /// [present]. Layer surface setters called while prepared, including through the control socket, change what
+  /// [present] restores and read back that way; only [setLayer] and [setMonitor] move the off-screen surface right
+  /// away. The surface does not repaint while out of sight, so update the UI for the next [present] before [dismiss].
+  ///
+  /// Returns: false if the surface is not initialized. Completes once Flutter rendered a frame.
+  Future<bool> prepare() async {
+    final prepared = await _channel.prepare() ?? false;
+    if (prepared) {
+      await SchedulerBinding.instance.endOfFrame;
+    }
+    return prepared;
+  }
+
+  /// @exclusiveKeyboard: Whether to also take exclusive keyboard focus until [dismiss].
+  ///
+  /// Show a surface prepared with [prepare] or [dismiss], in a single commit.
+  ///
+  /// Returns: false if the surface is not prepared.
+  Future<bool> present({bool exclusiveKeyboard = false}) async {
+    return await _channel.present(exclusiveKeyboard) ?? false;
+  }
+
+  /// Return a presented surface to the prepared state without destroying it, see [prepare].
+  ///
+  /// Returns: false if the surface is not mapped or already prepared.
+  Future<bool> dismiss() async {
+    return await _channel.dismiss() ?? false;
   }
 
   /// @edge: A [ShellEdge] this layer surface may be anchored to.
@@ -89,18 +196,14 @@ class WaylandLayerShell {
   ///
   /// Default is %FALSE for each [ShellEdge]
   Future<void> setAnchor(ShellEdge edge, bool anchorToEdge) async {
-    final Map<String, dynamic> arguments = {'edge': edge.index, 'anchor_to_edge': anchorToEdge};
-    await methodChannel.invokeMethod('setAnchor', arguments);
+    await _channel.setAnchor(edge.index, anchorToEdge);
   }
 
   /// @edge: A [ShellEdge] this layer surface may be anchored to.
   ///
   /// Returns: if this surface is anchored to the given edge.
   Future<bool> getAnchor(ShellEdge edge) async {
-    final Map<String, dynamic> arguments = {
-      'edge': edge.index,
-    };
-    return await methodChannel.invokeMethod('getAnchor', arguments);
+    return (await _attachedFfi)?.getAnchor(edge) ?? (await _channel.getAnchor(edge.index))!;
   }
 
   /// @edge: The [ShellEdge] for which to set the margin.
@@ -111,18 +214,14 @@ class WaylandLayerShell {
   ///
   /// Default is 0 for each [ShellEdge]
   Future<void> setMargin(ShellEdge edge, int marginSize) async {
-    final Map<String, dynamic> arguments = {'edge': edge.index, 'margin_size': marginSize};
-    await methodChannel.invokeMethod('setMargin', arguments);
+    await _channel.setMargin(edge.index, marginSize);
   }
 
   /// @edge: The [ShellEdge] for which to get the margin.
   ///
   /// Returns: the size of the margin for the given edge.
   Future<int> getMargin(ShellEdge edge) async {
-    final Map<String, dynamic> arguments = {
-      'edge': edge.index,
-    };
-    return await methodChannel.invokeMethod('getMargin', arguments);
+    return (await _attachedFfi)?.getMargin(edge) ?? (await _channel.getMargin(edge.index))!;
   }
 
   /// @exclusiveZone: The size of the exclusive zone.
@@ -136,13 +235,12 @@ class WaylandLayerShell {
   ///
   /// Default is 0
   Future<void> setExclusiveZone(int exclusiveZone) async {
-    final Map<String, dynamic> arguments = {'exclusive_zone': exclusiveZone};
-    await methodChannel.invokeMethod('setExclusiveZone', arguments);
+    await _channel.setExclusiveZone(exclusiveZone);
   }
 
   /// Returns: the window's exclusive zone (which may have been set manually or automatically)
   Future<int> getExclusiveZone() async {
-    return await methodChannel.invokeMethod('getExclusiveZone');
+    return (await _attachedFfi)?.exclusiveZone ?? (await _channel.getExclusiveZone())!;
   }
 
   /// Enable auto exclusive zone
@@ -151,12 +249,12 @@ class WaylandLayerShell {
   /// size of the @window + relevant margin. To disable auto exclusive zone, just set the
   /// exclusive zone to 0 or any other fixed value.
   Future<void> enableAutoExclusiveZone() async {
-    await methodChannel.invokeMethod('enableAutoExclusiveZone');
+    await _channel.enableAutoExclusiveZone();
   }
 
   /// Returns: if the surface's exclusive zone is set to change based on the window's size
   Future<bool> isAutoExclusiveZoneEnabled() async {
-    return await methodChannel.invokeMethod('isAutoExclusiveZoneEnabled');
+    return (await _attachedFfi)?.isAutoExclusiveZoneEnabled ?? (await _channel.isAutoExclusiveZoneEnabled())!;
   }
 
   /// @mode: The type of keyboard interactivity requested.
@@ -166,12 +264,361 @@ class WaylandLayerShell {
   ///
   /// Default is [ShellKeyboardMode.keyboardModeNone]
   Future<void> setKeyboardMode(ShellKeyboardMode mode) async {
-    final Map<String, dynamic> arguments = {'keyboard_mode': mode.index};
-    await methodChannel.invokeMethod('setKeyboardMode', arguments);
+    await _channel.setKeyboardMode(mode.index);
   }
 
   /// Returns: current keyboard interactivity mode for window
   Future<ShellKeyboardMode> getKeyboardMode() async {
-    return ShellKeyboardMode.values[(await methodChannel.invokeMethod('getKeyboardMode')) as int];
+    return (await _attachedFfi)?.keyboardMode ?? ShellKeyboardMode.values[(await _channel.getKeyboardMode())!];
+  }
+
+  /// @width: The width of the surface, or 0 to leave it to the compositor.
+  /// @height: The height of the surface, or 0 to leave it to the compositor.
+  ///
+  /// Change the size of the surface after [initialize]. A dimension of 0 takes the size the
+  /// compositor configures when the surface is anchored to both opposite edges, and the content's
+  /// size otherwise. Like the other setters the resize is applied with the next frame, so several
+  /// calls in a row result in a single resize. Listen to [configuredSizes] to lay out at the size
+  /// the compositor actually chose.
+  Future<bool> setSize(int width, int height) async {
+    return await _channel.setSize(width, height) ?? false;
+  }
+
+  /// Changes of the layer surface as they happen natively: every configure, map and unmap, the
+  /// compositor closing the surface, keyboard focus changes, and [SurfaceEventKind.state] whenever
+  /// the layer, monitor, exclusive zone or keyboard mode change, whichever API changed them.
+  /// Listening starts with a [SurfaceEventKind.state] event with the current state, so these values
+  /// need not be polled.
+  Stream<SurfaceEvent> get surfaceEvents => _surfaceEvents;
+
+  /// The size the compositor configured the surface with, each time it changes.
+  Stream<Size> get configuredSizes => _events
+      .where((event) => event['event'] == 'configured')
+      .map((event) => Size((event['width'] as int).toDouble(), (event['height'] as int).toDouble()));
+
+  /// @config: The [LayerConfig] to apply.
+  ///
+  /// Apply layer, anchors, margins, exclusive zone and keyboard mode in a single call. All
+  /// changes reach the compositor in one surface commit, so no half-applied state is ever shown.
+  ///
+  /// Returns: the resulting [LayerConfig] with every field filled in.
+  Future<LayerConfig> applyConfig(LayerConfig config) async {
+    final result = await _channel.applyConfig(
+      config.layer?.index,
+      config.anchors == null ? null : [for (final edge in LayerConfig.edges) config.anchors![edge]],
+      config.margins == null ? null : [for (final edge in LayerConfig.edges) config.margins![edge]],
+      config.exclusiveZone,
+      config.autoExclusiveZone,
+      config.keyboardMode?.index,
+    );
+    return LayerConfig.fromMap(result!);
+  }
+
+  /// Apply any layer surface changes that are still waiting for the next frame.
+  ///
+  /// Setters ([setLayer], [setAnchor], [setMargin], [setExclusiveZone], [setKeyboardMode], ...)
+  /// are collected natively and applied together, once per frame, while the window is
+  /// mapped. Call this when a change has to reach the compositor right away.
+  Future<void> flush() async {
+    await _channel.flush();
+  }
+
+  /// Returns: how many setter calls were received, how many were skipped because they changed nothing, and how many
+  /// surface commits the rest resulted in; likewise for [setInputRegion] and [setOpaqueRegion] updates.
+  Future<CommitStats> getCommitStats() async {
+    return CommitStats.fromMap((await _channel.getCommitStats())!);
+  }
+
+  /// @rects: The parts of the surface that take pointer and touch input, in logical pixels. null
+  /// restores the default of the whole surface; an empty list lets all input through.
+  ///
+  /// Input outside of the region goes to whatever is below the surface, so transparent parts of an
+  /// overlay can be clicked through and do not wake the engine. Rectangles are rounded outwards to
+  /// whole pixels. Setting the same region again is not resent to the compositor.
+  Future<bool> setInputRegion(List<Rect>? rects) async {
+    final region = rects == null ? null : _regionToList(rects, outwards: true);
+    return await _channel.setInputRegion(region) ?? false;
+  }
+
+  /// @rects: The parts of the surface that are fully opaque, in logical pixels. null or an empty
+  /// list means none beyond what GTK reports for the window itself.
+  ///
+  /// The compositor can skip drawing what lies beneath opaque parts of the surface. Rectangles are
+  /// rounded inwards to whole pixels, so partly covered pixels are never reported as opaque.
+  /// Setting the same region again is not resent to the compositor.
+  Future<bool> setOpaqueRegion(List<Rect>? rects) async {
+    final region = rects == null || rects.isEmpty ? null : _regionToList(rects, outwards: false);
+    return await _channel.setOpaqueRegion(region) ?? false;
+  }
+
+  /// Flattens @rects into x, y, width, height quadruples of whole pixels.
+  static List<int> _regionToList(List<Rect> rects, {required bool outwards}) {
+    final values = <int>[];
+    for (final rect in rects) {
+      final left = outwards ? rect.left.floor() : rect.left.ceil();
+      final top = outwards ? rect.top.floor() : rect.top.ceil();
+      final right = outwards ? rect.right.ceil() : rect.right.floor();
+      final bottom = outwards ? rect.bottom.ceil() : rect.bottom.floor();
+      if (right > left && bottom > top) {
+        values.addAll([left, top, right - left, bottom - top]);
+      }
+    }
+    return values;
+  }
+
+  /// @to: The target margin for each [ShellEdge], which may be negative; edges that are missing keep their margin.
+  /// @from: The start margin for each [ShellEdge]; defaults to the current margins.
+  /// @duration: How long the animation runs.
+  /// @easing: The [ShellEasing] curve used to interpolate.
+  ///
+  /// Animate the margins natively, driven by the window's frame clock with one surface commit per
+  /// frame, so the animation does not depend on the Dart UI thread. Starting a new margin animation
+  /// while one is running continues from the current position (@from is then ignored).
+  ///
+  /// Returns: 'true' when the animation reached its target, 'false' if it was cancelled or replaced
+  /// by another animation.
+  Future<bool> animateMargins(Map<ShellEdge, int> to,
+      {Map<ShellEdge, int>? from, required Duration duration, ShellEasing easing = ShellEasing.easeInOut}) {
+    return _runAnimation(() => _channel.animateMargins(
+          from == null ? null : [for (final edge in LayerConfig.edges) from[edge]],
+          [for (final edge in LayerConfig.edges) to[edge]],
+          duration.inMilliseconds,
+          easing.index,
+        ));
+  }
+
+  /// @width: The target width of the surface.
+  /// @height: The target height of the surface.
+  /// @fromWidth, @fromHeight: The start size; defaults to the current size.
+  /// @duration: How long the animation runs.
+  /// @easing: The [ShellEasing] curve used to interpolate.
+  ///
+  /// Animate the size of the surface natively, like [animateMargins].
+  ///
+  /// Returns: 'true' when the animation reached its target, 'false' if it was cancelled or replaced
+  /// by another animation.
+  Future<bool> animateSize(int width, int height,
+      {int? fromWidth, int? fromHeight, required Duration duration, ShellEasing easing = ShellEasing.easeInOut}) {
+    return _runAnimation(() => _channel.animateSize(
+          fromWidth == null || fromHeight == null ? null : [fromWidth, fromHeight],
+          [width, height],
+          duration.inMilliseconds,
+          easing.index,
+        ));
+  }
+
+  /// Stop all running animations where they are.
+  Future<void> cancelAnimations() async {
+    await _channel.cancelAnimations();
+  }
+
+  /// @policy: How often the surface may present frames.
+  /// @fpsCap: The maximum frames per second for [ShellRenderPolicy.capped].
+  ///
+  /// Throttles how often the surface is repainted and committed to the compositor, e.g. for a status bar that changes
+  /// once a second. Changes made meanwhile are coalesced into the next presented frame. With
+  /// [ShellRenderPolicy.onDemand] the surface keeps showing its last frame until [requestFrame] is called. The policy
+  /// applies to what is presented; Flutter itself still produces frames whenever the UI changes.
+  Future<bool> setRenderPolicy(ShellRenderPolicy policy, {int? fpsCap}) async {
+    return await _channel.setRenderPolicy(policy.index, fpsCap) ?? false;
+  }
+
+  /// @fps: The maximum frames per second the surface presents; 0 removes the cap.
+  ///
+  /// Shorthand for [setRenderPolicy] with [ShellRenderPolicy.capped] (or [ShellRenderPolicy.continuous] for 0).
+  Future<bool> setFrameRateCap(int fps) async {
+    return await _channel.setFrameRateCap(fps) ?? false;
+  }
+
+  /// @enabled: Whether the surface hides while the pointer is elsewhere.
+  /// @edge: The edge the surface hides into; it should be anchored to it.
+  /// @stripSize: The size in pixels of the strip that stays visible and reveals the surface on hover, 1 to 32.
+  /// @revealDelay: How long the pointer has to rest on the strip before the surface is revealed.
+  /// @hideDelay: How long after the pointer left the surface it is hidden.
+  ///
+  /// Hides the surface into a thin strip along [edge], e.g. for a dock or panel, without a round trip to Dart: the
+  /// plugin shrinks the surface, presents one frame at the strip size and then stops presenting frames until the
+  /// pointer enters the strip. Sizes set with [setSize] while hidden are applied on reveal; an [animateSize] still
+  /// running when the surface hides is cancelled and its target size applied on reveal. The exclusive zone is left
+  /// as it is. [SurfaceEventKind.hidden] and [SurfaceEventKind.revealed] are sent on [surfaceEvents]; wrap the UI in
+  /// a `TickerMode(enabled: false)` while hidden so animations stop producing frames as well.
+  Future<bool> setAutoHide(bool enabled,
+      {ShellEdge edge = ShellEdge.edgeBottom,
+      int stripSize = 2,
+      Duration revealDelay = const Duration(milliseconds: 150),
+      Duration hideDelay = const Duration(milliseconds: 500)}) async {
+    return await _channel.setAutoHide(
+            enabled, edge.index, stripSize, revealDelay.inMilliseconds, hideDelay.inMilliseconds) ??
+        false;
+  }
+
+  /// Present the current content once, while the render policy is [ShellRenderPolicy.onDemand]. Call it after the
+  /// UI changed, e.g. from a post-frame callback.
+  Future<bool> requestFrame() async {
+    return await _channel.requestFrame() ?? false;
+  }
+
+  /// Returns: the preferred fractional scale of the surface next to the integer scale GTK renders at, and the pixels
+  /// per frame each needs. GTK3 can only render at integer scales, so on a 1.5x output the surface is rendered at 2x
+  /// and scaled down by the compositor; use [ScaleInfo.preferredScale] e.g. to snap content to device pixels.
+  Future<ScaleInfo> getScaleInfo() async {
+    return ScaleInfo.fromMap((await _channel.getScaleInfo())!);
+  }
+
+  /// The preferred fractional scale of the surface, each time the compositor changes it. Only sent when the
+  /// compositor supports wp_fractional_scale_v1.
+  Stream<double> get scaleChanges =>
+      _events.where((event) => event['event'] == 'scaleChanged').map((event) => event['scale'] as double);
+
+  /// When each frame of the surface reached the screen, from the compositor's wp_presentation feedback, with the
+  /// output's refresh interval at that time. Feedback is only requested while this stream is listened to. Use it
+  /// to measure the real latency of frames, or to line animation ticks up with the next refresh (the last
+  /// [PresentedFrame.time] plus [PresentedFrame.refreshInterval]). Nothing is sent when the compositor does not
+  /// support wp_presentation; see [isPresentationSupported].
+  Stream<PresentedFrame> get presentedFrames => _presentedFrames;
+
+  /// Returns: whether the compositor offers wp_presentation (and the plugin was built with it).
+  Future<bool> isPresentationSupported() async {
+    return await _channel.isPresentationSupported() ?? false;
+  }
+
+  /// Returns: the render policy with the requested and the achieved frame rate since it was set.
+  Future<FrameStats> getFrameStats() async {
+    return FrameStats.fromMap((await _channel.getFrameStats())!);
+  }
+
+  /// Returns: call counts, error counts and latencies of every method called since the last
+  /// [resetStats], plus how many surface commits and monitor enumerations happened. Empty when the
+  /// plugin was built with WAYLAND_LAYER_SHELL_STATS off.
+  Future<PluginStats> getStats() async {
+    return PluginStats.fromMap((await _channel.getStats())!);
+  }
+
+  /// Starts the counters reported by [getStats] over.
+  Future<void> resetStats() async {
+    await _channel.resetStats();
+  }
+
+  /// @path: The file the trace is written to, defaults to a file in the temporary directory.
+  ///
+  /// Starts recording native trace events: a span per method call and surface commit, and instant
+  /// events for configures, monitor changes and map/unmap. They are kept in memory until
+  /// [stopTracing]; tracing can also be started for the whole run by setting the
+  /// WAYLAND_LAYER_SHELL_TRACE environment variable to a file name.
+  ///
+  /// Returns: 'false' if the plugin was built with WAYLAND_LAYER_SHELL_TRACE off.
+  Future<bool> startTracing({String? path}) async {
+    return (await _channel.startTracing(path)) ?? false;
+  }
+
+  /// Stops recording and writes the trace in the Chrome trace event format. Timestamps use the
+  /// same monotonic clock as Flutter's timeline, so the file can be opened in Perfetto next to a
+  /// timeline exported from DevTools. Throws a [PlatformException] if tracing was not running.
+  Future<TraceResult> stopTracing() async {
+    return TraceResult.fromMap((await _channel.stopTracing())!);
+  }
+
+  /// @path: The socket file, defaults to wayland_layer_shell-<pid>.sock in the user's runtime directory.
+  ///
+  /// Listens for commands from other processes, e.g. a compositor keybinding running
+  /// wayland_layer_shell_ctl, on a Unix domain socket only the user can access. Commands such as
+  /// 'toggle' or 'setLayer overlay' are applied natively and committed before the client gets its
+  /// reply, without a round trip through Dart; [controlCommands] reports them afterwards. Replaces
+  /// a socket that is already listening. Listening can also be started for the whole run by setting
+  /// the WAYLAND_LAYER_SHELL_CONTROL_SOCKET environment variable to a path.
+  ///
+  /// Returns: the path of the socket. Throws a [PlatformException] if it could not be created.
+  Future<String> listenControlSocket({String? path}) async {
+    return (await _channel.listenControlSocket(path))!;
+  }
+
+  /// Stops listening for control commands and removes the socket file.
+  ///
+  /// Returns: 'false' if the control socket was not listening.
+  Future<bool> closeControlSocket() async {
+    return (await _channel.closeControlSocket()) ?? false;
+  }
+
+  /// The commands run on the control socket, each after it has been applied.
+  Stream<ControlCommand> get controlCommands => _events
+      .where((event) => event['event'] == 'controlCommand')
+      .map((event) => ControlCommand.fromMap(event));
+
+  /// The windows of all apps, for taskbars, through the compositor's zwlr_foreign_toplevel_manager_v1. The
+  /// table is kept natively and only changes are sent: listening starts with a batch that adds every open window,
+  /// and after that each batch holds the windows that opened, changed or closed since the previous one, with only
+  /// the fields that changed. Changes the compositor sends together arrive as one batch. Tracking stops when the
+  /// last listener cancels. Emits a [PlatformException] with the code 'no_foreign_toplevel' if the compositor does
+  /// not support the protocol.
+  Stream<List<ToplevelEvent>> get toplevelEvents => _toplevelEvents;
+
+  /// @id: The [ToplevelEvent.id] of the window.
+  ///
+  /// Asks the compositor to focus the window, on the default seat.
+  ///
+  /// Returns: 'false' if there is no such window or [toplevelEvents] is not listened to.
+  Future<bool> activateToplevel(int id) async {
+    return await _channel.activateToplevel(id) ?? false;
+  }
+
+  /// @id: The [ToplevelEvent.id] of the window.
+  /// @minimized: Whether to minimize or restore the window.
+  ///
+  /// Returns: 'false' if there is no such window or [toplevelEvents] is not listened to.
+  Future<bool> setToplevelMinimized(int id, bool minimized) async {
+    return await _channel.setToplevelMinimized(id, minimized) ?? false;
+  }
+
+  /// @id: The [ToplevelEvent.id] of the window.
+  ///
+  /// Asks the window to close; it may ask the user first, or refuse.
+  ///
+  /// Returns: 'false' if there is no such window or [toplevelEvents] is not listened to.
+  Future<bool> closeToplevel(int id) async {
+    return await _channel.closeToplevel(id) ?? false;
+  }
+
+  /// @level: The most verbose [ShellLogLevel] the native side writes to stderr and keeps for
+  /// [getLogRecords]. Defaults to [ShellLogLevel.warning], or to the WAYLAND_LAYER_SHELL_LOG
+  /// environment variable ('off', 'error', 'warning', 'info' or 'debug').
+  Future<void> setLogLevel(ShellLogLevel level) async {
+    await _channel.setLogLevel(level.index);
+  }
+
+  /// @maxRecords: How many records to return at most; defaults to all that are kept.
+  ///
+  /// Returns: the most recent native log records, oldest first. Useful to attach to bug reports.
+  Future<List<LogRecord>> getLogRecords({int? maxRecords}) async {
+    final records = await _channel.getLogRecords(maxRecords) ?? const [];
+    return records.map((record) => LogRecord.fromMap(record as Map<dynamic, dynamic>)).toList();
+  }
+
+  /// Starts an animation and completes once its 'animationDone' event arrives.
+  Future<bool> _runAnimation(Future<int?> Function() start) async {
+    final early = <int, bool>{};
+    final completer = Completer<bool>();
+    int? id;
+    // Listen before starting, so a completion can't be missed.
+    final subscription = _events.where((event) => event['event'] == 'animationDone').listen((event) {
+      final eventId = event['id'] as int;
+      final finished = !(event['cancelled'] as bool);
+      if (id == null) {
+        early[eventId] = finished;
+      } else if (eventId == id && !completer.isCompleted) {
+        completer.complete(finished);
+      }
+    });
+    try {
+      id = await start();
+      if (id == null) {
+        return false;
+      }
+      if (early.containsKey(id)) {
+        completer.complete(early[id]);
+      }
+      return await completer.future;
+    } finally {
+      await subscription.cancel();
+    }
   }
 }
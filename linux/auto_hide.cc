@@ -0,0 +1,266 @@
+#include "auto_hide.h"
+
+#include <time.h>
+
+#include "plugin_log.h"
+#include "plugin_trace.h"
+
+static gint64 process_cpu_time_us() {
+  struct timespec now;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return static_cast<gint64>(now.tv_sec) * G_USEC_PER_SEC +
+         now.tv_nsec / 1000;
+}
+
+static gboolean is_vertical(GtkLayerShellEdge edge) {
+  return edge == GTK_LAYER_SHELL_EDGE_TOP ||
+         edge == GTK_LAYER_SHELL_EDGE_BOTTOM;
+}
+
+static void cancel_timer(AutoHide *self) {
+  if (self->timer_id != 0) {
+    g_source_remove(self->timer_id);
+    self->timer_id = 0;
+  }
+}
+
+static void hide(AutoHide *self) {
+  if (self->hidden) {
+    return;
+  }
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(&self->window_state->queue, &state);
+  self->width = state.width;
+  self->height = state.height;
+
+  self->hidden = TRUE;
+  self->hidden_since = g_get_monotonic_time();
+  self->hidden_cpu_since = process_cpu_time_us();
+  self->stats.hides++;
+  PLUGIN_TRACE_INSTANT("auto_hide", "strip", self->strip_size);
+
+  layer_surface_queue_set_size(
+      &self->window_state->queue,
+      is_vertical(self->edge) ? self->width : self->strip_size,
+      is_vertical(self->edge) ? self->strip_size : self->height);
+  surface_regions_suspend_input(&self->window_state->regions, TRUE);
+  frame_governor_set_paused(&self->window_state->governor, TRUE);
+  if (self->changed_func != nullptr) {
+    self->changed_func(TRUE, self->user_data);
+  }
+}
+
+static void reveal(AutoHide *self) {
+  if (!self->hidden) {
+    return;
+  }
+  self->hidden = FALSE;
+  self->stats.reveals++;
+  self->stats.hidden_us += g_get_monotonic_time() - self->hidden_since;
+  self->stats.hidden_cpu_us += process_cpu_time_us() - self->hidden_cpu_since;
+  PLUGIN_TRACE_INSTANT("auto_reveal");
+
+  frame_governor_set_paused(&self->window_state->governor, FALSE);
+  surface_regions_suspend_input(&self->window_state->regions, FALSE);
+  layer_surface_queue_set_size(&self->window_state->queue, self->width,
+                               self->height);
+  if (self->changed_func != nullptr) {
+    self->changed_func(FALSE, self->user_data);
+  }
+}
+
+static gboolean hide_cb(gpointer user_data) {
+  AutoHide *self = static_cast<AutoHide *>(user_data);
+  self->timer_id = 0;
+  hide(self);
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean reveal_cb(gpointer user_data) {
+  AutoHide *self = static_cast<AutoHide *>(user_data);
+  self->timer_id = 0;
+  reveal(self);
+  return G_SOURCE_REMOVE;
+}
+
+static void schedule_hide(AutoHide *self) {
+  cancel_timer(self);
+  self->timer_id = g_timeout_add(self->hide_delay_ms, hide_cb, self);
+}
+
+// Whether the pointer is over the surface right now. For when there was no
+// crossing event to tell, e.g. as auto-hide gets enabled.
+static gboolean pointer_inside(AutoHide *self) {
+  GdkWindow *window = gtk_widget_get_window(GTK_WIDGET(self->window));
+  if (window == nullptr) {
+    return FALSE;
+  }
+  GdkSeat *seat = gdk_display_get_default_seat(gdk_window_get_display(window));
+  GdkDevice *pointer = seat != nullptr ? gdk_seat_get_pointer(seat) : nullptr;
+  if (pointer == nullptr) {
+    return FALSE;
+  }
+  GdkWindow *under =
+      gdk_device_get_window_at_position(pointer, nullptr, nullptr);
+  return under != nullptr && gdk_window_get_toplevel(under) == window;
+}
+
+// Crossings into and out of child windows (such as the Flutter view's) do not
+// move the pointer on or off the surface.
+static gboolean enter_cb(GtkWidget *widget, GdkEvent *event,
+                         gpointer user_data) {
+  AutoHide *self = static_cast<AutoHide *>(user_data);
+  if (event->crossing.detail == GDK_NOTIFY_INFERIOR) {
+    return FALSE;
+  }
+  cancel_timer(self);
+  if (self->hidden) {
+    self->enter_time = g_get_monotonic_time();
+    if (self->reveal_delay_ms == 0) {
+      reveal(self);
+    } else {
+      self->timer_id = g_timeout_add(self->reveal_delay_ms, reveal_cb, self);
+    }
+  }
+  return FALSE;
+}
+
+static gboolean leave_cb(GtkWidget *widget, GdkEvent *event,
+                         gpointer user_data) {
+  AutoHide *self = static_cast<AutoHide *>(user_data);
+  if (event->crossing.detail == GDK_NOTIFY_INFERIOR) {
+    return FALSE;
+  }
+  if (self->hidden) {
+    // The pointer only brushed the strip.
+    cancel_timer(self);
+    self->enter_time = 0;
+  } else {
+    schedule_hide(self);
+  }
+  return FALSE;
+}
+
+// A reveal is complete once the compositor configured the surface beyond the
+// strip again.
+static gboolean configure_cb(GtkWidget *widget, GdkEvent *event,
+                             gpointer user_data) {
+  AutoHide *self = static_cast<AutoHide *>(user_data);
+  if (self->enter_time == 0 || self->hidden) {
+    return FALSE;
+  }
+  int size = is_vertical(self->edge) ? event->configure.height
+                                     : event->configure.width;
+  if (size <= self->strip_size) {
+    return FALSE;
+  }
+
+  guint64 latency = g_get_monotonic_time() - self->enter_time;
+  self->enter_time = 0;
+  self->stats.reveal_latency_total_us += latency;
+  self->stats.reveal_latency_max_us =
+      MAX(self->stats.reveal_latency_max_us, latency);
+  self->stats.reveal_latency_last_us = latency;
+  PLUGIN_LOG_D("Revealed in %" G_GUINT64_FORMAT " us", latency);
+  return FALSE;
+}
+
+static void disconnect(AutoHide *self) {
+  cancel_timer(self);
+  if (self->enter_handler_id != 0) {
+    g_signal_handler_disconnect(self->window, self->enter_handler_id);
+    g_signal_handler_disconnect(self->window, self->leave_handler_id);
+    g_signal_handler_disconnect(self->window, self->configure_handler_id);
+    self->enter_handler_id = 0;
+    self->leave_handler_id = 0;
+    self->configure_handler_id = 0;
+  }
+  if (self->window_state->auto_hide == self) {
+    self->window_state->auto_hide = nullptr;
+  }
+}
+
+void auto_hide_init(AutoHide *self, GtkWindow *window,
+                    LayerWindowState *window_state,
+                    AutoHideChangedFunc changed_func, gpointer user_data) {
+  *self = {};
+  self->window = window;
+  self->window_state = window_state;
+  self->changed_func = changed_func;
+  self->user_data = user_data;
+}
+
+void auto_hide_clear(AutoHide *self) {
+  if (self->window == nullptr) {
+    return;
+  }
+  disconnect(self);
+  self->window = nullptr;
+}
+
+void auto_hide_configure(AutoHide *self, gboolean enabled,
+                         GtkLayerShellEdge edge, int strip_size,
+                         guint reveal_delay_ms, guint hide_delay_ms) {
+  if (self->window == nullptr) {
+    return;
+  }
+  if (!enabled) {
+    disconnect(self);
+    self->enter_time = 0;
+    reveal(self);
+    self->enabled = FALSE;
+    return;
+  }
+
+  // A hidden surface is revealed to take on a new edge or strip, and hidden
+  // again after the hide delay.
+  if (self->hidden && (edge != self->edge || strip_size != self->strip_size)) {
+    reveal(self);
+  }
+  self->enabled = TRUE;
+  self->edge = edge;
+  self->strip_size = strip_size;
+  self->reveal_delay_ms = reveal_delay_ms;
+  self->hide_delay_ms = hide_delay_ms;
+
+  if (self->enter_handler_id == 0) {
+    gtk_widget_add_events(GTK_WIDGET(self->window),
+                          GDK_ENTER_NOTIFY_MASK | GDK_LEAVE_NOTIFY_MASK);
+    self->enter_handler_id = g_signal_connect(
+        self->window, "enter-notify-event", G_CALLBACK(enter_cb), self);
+    self->leave_handler_id = g_signal_connect(
+        self->window, "leave-notify-event", G_CALLBACK(leave_cb), self);
+    self->configure_handler_id = g_signal_connect(
+        self->window, "configure-event", G_CALLBACK(configure_cb), self);
+  }
+  self->window_state->auto_hide = self;
+  // Hidden once the pointer leaves, if it is over the surface already.
+  if (!self->hidden && !pointer_inside(self)) {
+    schedule_hide(self);
+  }
+}
+
+gboolean auto_hide_set_size(AutoHide *self, int width, int height) {
+  if (!self->hidden) {
+    return FALSE;
+  }
+  self->width = width > 0 ? width : -1;
+  self->height = height > 0 ? height : -1;
+  return TRUE;
+}
+
+void auto_hide_get_stats(const AutoHide *self, AutoHideStats *stats) {
+  *stats = self->stats;
+  if (self->hidden) {
+    stats->hidden_us += g_get_monotonic_time() - self->hidden_since;
+    stats->hidden_cpu_us += process_cpu_time_us() - self->hidden_cpu_since;
+  }
+}
+
+void auto_hide_reset_stats(AutoHide *self) {
+  self->stats = {};
+  if (self->hidden) {
+    self->hidden_since = g_get_monotonic_time();
+    self->hidden_cpu_since = process_cpu_time_us();
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef WAYLAND_LAYER_SHELL_AUTO_HIDE_H_
+#define WAYLAND_LAYER_SHELL_AUTO_HIDE_H_
+
+#include <gtk/gtk.h>
+
+#include "layer_window_state.h"
+
+// Called when the surface was hidden (@hidden TRUE) or revealed.
+typedef void (*AutoHideChangedFunc)(gboolean hidden, gpointer user_data);
+
+typedef struct {
+  guint64 hides;
+  guint64 reveals;
+  // From the pointer entering the trigger strip until the compositor
+  // configured the full surface again, reveal delay included.
+  guint64 reveal_latency_total_us;
+  guint64 reveal_latency_max_us;
+  guint64 reveal_latency_last_us;
+  // Wall and process CPU time spent hidden.
+  guint64 hidden_us;
+  guint64 hidden_cpu_us;
+} AutoHideStats;
+
+// Hides a layer surface into a thin trigger strip on one edge while the
+// pointer is elsewhere, and reveals it when the pointer enters the strip.
+//
+// Hiding sets the size request across @edge to the strip size through the
+// LayerSurfaceQueue, lets the frame governor present one frame at that size
+// and then holds all frames until the surface is revealed. The exclusive zone
+// is left alone: an automatic one follows the strip, a fixed one stays. A
+// custom input region is suspended while hidden, so the strip always takes
+// the pointer. Size changes requested while hidden are kept for the reveal.
+typedef struct _AutoHide {
+  GtkWindow *window;
+  LayerWindowState *window_state;
+  AutoHideChangedFunc changed_func;
+  gpointer user_data;
+
+  gboolean enabled;
+  GtkLayerShellEdge edge;
+  int strip_size;
+  guint reveal_delay_ms;
+  guint hide_delay_ms;
+
+  gboolean hidden;
+  // Size request to restore on reveal.
+  int width;
+  int height;
+  // Pending hide or reveal.
+  guint timer_id;
+  gulong enter_handler_id;
+  gulong leave_handler_id;
+  gulong configure_handler_id;
+
+  // g_get_monotonic_time() the pointer entered the strip at, while a reveal
+  // is on its way; 0 otherwise.
+  gint64 enter_time;
+  // When the current hidden period started, in wall and CPU time.
+  gint64 hidden_since;
+  gint64 hidden_cpu_since;
+  AutoHideStats stats;
+} AutoHide;
+
+void auto_hide_init(AutoHide *auto_hide, GtkWindow *window,
+                    LayerWindowState *window_state,
+                    AutoHideChangedFunc changed_func, gpointer user_data);
+
+// Stops auto-hiding without restoring the surface or reporting anything.
+void auto_hide_clear(AutoHide *auto_hide);
+
+// Enables auto-hide on @edge with a @strip_size pixel trigger strip, or
+// disables it (revealing the surface if hidden). Enabling hides the surface
+// after @hide_delay_ms unless the pointer enters it first; with the pointer
+// over it already, it hides @hide_delay_ms after the pointer leaves.
+void auto_hide_configure(AutoHide *auto_hide, gboolean enabled,
+                         GtkLayerShellEdge edge, int strip_size,
+                         guint reveal_delay_ms, guint hide_delay_ms);
+
+// Sets the size request the surface gets when revealed. Returns FALSE if the
+// surface is not hidden, in which case the caller applies the size itself.
+gboolean auto_hide_set_size(AutoHide *auto_hide, int width, int height);
+
+// Copies the statistics, including the current hidden period, to @stats.
+void auto_hide_get_stats(const AutoHide *auto_hide, AutoHideStats *stats);
+
+void auto_hide_reset_stats(AutoHide *auto_hide);
+
+#endif  // WAYLAND_LAYER_SHELL_AUTO_HIDE_H_
@@ -0,0 +1,505 @@
+// GENERATED CODE - DO NOT MODIFY BY HAND.
+// Generated by tool/generate_channel.dart from tool/channel_schema.json.
+
+#ifndef WAYLAND_LAYER_SHELL_CHANNEL_API_G_H_
+#define WAYLAND_LAYER_SHELL_CHANNEL_API_G_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Method table for the "wayland_layer_shell" method channel.
+namespace channel_api {
+
+// 32-bit FNV-1a, also evaluated at compile time for the case labels in
+// lookup_method().
+constexpr uint32_t method_hash(const char *name) {
+  uint32_t hash = 2166136261u;
+  while (*name != '\0') {
+    hash = (hash ^ static_cast<uint8_t>(*name++)) * 16777619u;
+  }
+  return hash;
+}
+
+enum class Method {
+  kGetPlatformVersion,
+  kIsSupported,
+  kGetCapabilities,
+  kIsFfiWindow,
+  kInitialize,
+  kShowWindow,
+  kPrepare,
+  kPresent,
+  kDismiss,
+  kSetLayer,
+  kGetLayer,
+  kGetMonitorList,
+  kSetMonitor,
+  kSetAnchor,
+  kGetAnchor,
+  kSetMargin,
+  kGetMargin,
+  kSetExclusiveZone,
+  kGetExclusiveZone,
+  kEnableAutoExclusiveZone,
+  kIsAutoExclusiveZoneEnabled,
+  kSetKeyboardMode,
+  kGetKeyboardMode,
+  kSetSize,
+  kApplyConfig,
+  kFlush,
+  kGetCommitStats,
+  kSetInputRegion,
+  kSetOpaqueRegion,
+  kAnimateMargins,
+  kAnimateSize,
+  kCancelAnimations,
+  kSetRenderPolicy,
+  kSetFrameRateCap,
+  kSetAutoHide,
+  kRequestFrame,
+  kGetFrameStats,
+  kGetScaleInfo,
+  kIsPresentationSupported,
+  kSetLogLevel,
+  kGetLogRecords,
+  kGetStats,
+  kResetStats,
+  kStartTracing,
+  kStopTracing,
+  kListenControlSocket,
+  kCloseControlSocket,
+  kActivateToplevel,
+  kSetToplevelMinimized,
+  kCloseToplevel,
+  kUnknown,
+};
+
+constexpr size_t kMethodCount = 50;
+
+// Method names, indexed by Method.
+constexpr const char *kMethodNames[kMethodCount] = {
+    "getPlatformVersion",
+    "isSupported",
+    "getCapabilities",
+    "isFfiWindow",
+    "initialize",
+    "showWindow",
+    "prepare",
+    "present",
+    "dismiss",
+    "setLayer",
+    "getLayer",
+    "getMonitorList",
+    "setMonitor",
+    "setAnchor",
+    "getAnchor",
+    "setMargin",
+    "getMargin",
+    "setExclusiveZone",
+    "getExclusiveZone",
+    "enableAutoExclusiveZone",
+    "isAutoExclusiveZoneEnabled",
+    "setKeyboardMode",
+    "getKeyboardMode",
+    "setSize",
+    "applyConfig",
+    "flush",
+    "getCommitStats",
+    "setInputRegion",
+    "setOpaqueRegion",
+    "animateMargins",
+    "animateSize",
+    "cancelAnimations",
+    "setRenderPolicy",
+    "setFrameRateCap",
+    "setAutoHide",
+    "requestFrame",
+    "getFrameStats",
+    "getScaleInfo",
+    "isPresentationSupported",
+    "setLogLevel",
+    "getLogRecords",
+    "getStats",
+    "resetStats",
+    "startTracing",
+    "stopTracing",
+    "listenControlSocket",
+    "closeControlSocket",
+    "activateToplevel",
+    "setToplevelMinimized",
+    "closeToplevel",
+};
+
+// Number of positional arguments of each method, indexed by Method.
+constexpr size_t kArgCounts[kMethodCount] = {
+    0,
+    0,
+    0,
+    0,
+    3,
+    0,
+    0,
+    1,
+    0,
+    1,
+    0,
+    0,
+    1,
+    2,
+    1,
+    2,
+    1,
+    1,
+    0,
+    0,
+    0,
+    1,
+    0,
+    2,
+    6,
+    0,
+    0,
+    1,
+    1,
+    4,
+    4,
+    0,
+    2,
+    1,
+    5,
+    0,
+    0,
+    0,
+    0,
+    1,
+    1,
+    0,
+    0,
+    1,
+    0,
+    1,
+    0,
+    1,
+    2,
+    1,
+};
+
+// initialize(int width, int height, String? monitor)
+namespace initialize {
+constexpr size_t kWidth = 0;
+constexpr size_t kHeight = 1;
+constexpr size_t kMonitor = 2;
+}  // namespace initialize
+
+// present(bool exclusiveKeyboard)
+namespace present {
+constexpr size_t kExclusiveKeyboard = 0;
+}  // namespace present
+
+// setLayer(int layer)
+namespace set_layer {
+constexpr size_t kLayer = 0;
+}  // namespace set_layer
+
+// setMonitor(int id)
+namespace set_monitor {
+constexpr size_t kId = 0;
+}  // namespace set_monitor
+
+// setAnchor(int edge, bool anchorToEdge)
+namespace set_anchor {
+constexpr size_t kEdge = 0;
+constexpr size_t kAnchorToEdge = 1;
+}  // namespace set_anchor
+
+// getAnchor(int edge)
+namespace get_anchor {
+constexpr size_t kEdge = 0;
+}  // namespace get_anchor
+
+// setMargin(int edge, int marginSize)
+namespace set_margin {
+constexpr size_t kEdge = 0;
+constexpr size_t kMarginSize = 1;
+}  // namespace set_margin
+
+// getMargin(int edge)
+namespace get_margin {
+constexpr size_t kEdge = 0;
+}  // namespace get_margin
+
+// setExclusiveZone(int exclusiveZone)
+namespace set_exclusive_zone {
+constexpr size_t kExclusiveZone = 0;
+}  // namespace set_exclusive_zone
+
+// setKeyboardMode(int keyboardMode)
+namespace set_keyboard_mode {
+constexpr size_t kKeyboardMode = 0;
+}  // namespace set_keyboard_mode
+
+// setSize(int width, int height)
+namespace set_size {
+constexpr size_t kWidth = 0;
+constexpr size_t kHeight = 1;
+}  // namespace set_size
+
+// applyConfig(int? layer, List<bool?>? anchors, List<int?>? margins, int? exclusiveZone, bool? autoExclusiveZone, int? keyboardMode)
+namespace apply_config {
+constexpr size_t kLayer = 0;
+constexpr size_t kAnchors = 1;
+constexpr size_t kMargins = 2;
+constexpr size_t kExclusiveZone = 3;
+constexpr size_t kAutoExclusiveZone = 4;
+constexpr size_t kKeyboardMode = 5;
+}  // namespace apply_config
+
+// setInputRegion(List<int>? rects)
+namespace set_input_region {
+constexpr size_t kRects = 0;
+}  // namespace set_input_region
+
+// setOpaqueRegion(List<int>? rects)
+namespace set_opaque_region {
+constexpr size_t kRects = 0;
+}  // namespace set_opaque_region
+
+// animateMargins(List<int?>? from, List<int?> to, int durationMs, int easing)
+namespace animate_margins {
+constexpr size_t kFrom = 0;
+constexpr size_t kTo = 1;
+constexpr size_t kDurationMs = 2;
+constexpr size_t kEasing = 3;
+}  // namespace animate_margins
+
+// animateSize(List<int>? from, List<int> to, int durationMs, int easing)
+namespace animate_size {
+constexpr size_t kFrom = 0;
+constexpr size_t kTo = 1;
+constexpr size_t kDurationMs = 2;
+constexpr size_t kEasing = 3;
+}  // namespace animate_size
+
+// setRenderPolicy(int policy, int? fpsCap)
+namespace set_render_policy {
+constexpr size_t kPolicy = 0;
+constexpr size_t kFpsCap = 1;
+}  // namespace set_render_policy
+
+// setFrameRateCap(int fps)
+namespace set_frame_rate_cap {
+constexpr size_t kFps = 0;
+}  // namespace set_frame_rate_cap
+
+// setAutoHide(bool enabled, int edge, int stripSize, int revealDelayMs, int hideDelayMs)
+namespace set_auto_hide {
+constexpr size_t kEnabled = 0;
+constexpr size_t kEdge = 1;
+constexpr size_t kStripSize = 2;
+constexpr size_t kRevealDelayMs = 3;
+constexpr size_t kHideDelayMs = 4;
+}  // namespace set_auto_hide
+
+// setLogLevel(int level)
+namespace set_log_level {
+constexpr size_t kLevel = 0;
+}  // namespace set_log_level
+
+// getLogRecords(int? maxRecords)
+namespace get_log_records {
+constexpr size_t kMaxRecords = 0;
+}  // namespace get_log_records
+
+// startTracing(String? path)
+namespace start_tracing {
+constexpr size_t kPath = 0;
+}  // namespace start_tracing
+
+// listenControlSocket(String? path)
+namespace listen_control_socket {
+constexpr size_t kPath = 0;
+}  // namespace listen_control_socket
+
+// activateToplevel(int id)
+namespace activate_toplevel {
+constexpr size_t kId = 0;
+}  // namespace activate_toplevel
+
+// setToplevelMinimized(int id, bool minimized)
+namespace set_toplevel_minimized {
+constexpr size_t kId = 0;
+constexpr size_t kMinimized = 1;
+}  // namespace set_toplevel_minimized
+
+// closeToplevel(int id)
+namespace close_toplevel {
+constexpr size_t kId = 0;
+}  // namespace close_toplevel
+
+// Resolves a method name with one hash and a switch. Colliding names would
+// produce duplicate case labels and fail to compile.
+inline Method lookup_method(const char *name) {
+  Method method;
+  switch (method_hash(name)) {
+    case method_hash("getPlatformVersion"):
+      method = Method::kGetPlatformVersion;
+      break;
+    case method_hash("isSupported"):
+      method = Method::kIsSupported;
+      break;
+    case method_hash("getCapabilities"):
+      method = Method::kGetCapabilities;
+      break;
+    case method_hash("isFfiWindow"):
+      method = Method::kIsFfiWindow;
+      break;
+    case method_hash("initialize"):
+      method = Method::kInitialize;
+      break;
+    case method_hash("showWindow"):
+      method = Method::kShowWindow;
+      break;
+    case method_hash("prepare"):
+      method = Method::kPrepare;
+      break;
+    case method_hash("present"):
+      method = Method::kPresent;
+      break;
+    case method_hash("dismiss"):
+      method = Method::kDismiss;
+      break;
+    case method_hash("setLayer"):
+      method = Method::kSetLayer;
+      break;
+    case method_hash("getLayer"):
+      method = Method::kGetLayer;
+      break;
+    case method_hash("getMonitorList"):
+      method = Method::kGetMonitorList;
+      break;
+    case method_hash("setMonitor"):
+      method = Method::kSetMonitor;
+      break;
+    case method_hash("setAnchor"):
+      method = Method::kSetAnchor;
+      break;
+    case method_hash("getAnchor"):
+      method = Method::kGetAnchor;
+      break;
+    case method_hash("setMargin"):
+      method = Method::kSetMargin;
+      break;
+    case method_hash("getMargin"):
+      method = Method::kGetMargin;
+      break;
+    case method_hash("setExclusiveZone"):
+      method = Method::kSetExclusiveZone;
+      break;
+    case method_hash("getExclusiveZone"):
+      method = Method::kGetExclusiveZone;
+      break;
+    case method_hash("enableAutoExclusiveZone"):
+      method = Method::kEnableAutoExclusiveZone;
+      break;
+    case method_hash("isAutoExclusiveZoneEnabled"):
+      method = Method::kIsAutoExclusiveZoneEnabled;
+      break;
+    case method_hash("setKeyboardMode"):
+      method = Method::kSetKeyboardMode;
+      break;
+    case method_hash("getKeyboardMode"):
+      method = Method::kGetKeyboardMode;
+      break;
+    case method_hash("setSize"):
+      method = Method::kSetSize;
+      break;
+    case method_hash("applyConfig"):
+      method = Method::kApplyConfig;
+      break;
+    case method_hash("flush"):
+      method = Method::kFlush;
+      break;
+    case method_hash("getCommitStats"):
+      method = Method::kGetCommitStats;
+      break;
+    case method_hash("setInputRegion"):
+      method = Method::kSetInputRegion;
+      break;
+    case method_hash("setOpaqueRegion"):
+      method = Method::kSetOpaqueRegion;
+      break;
+    case method_hash("animateMargins"):
+      method = Method::kAnimateMargins;
+      break;
+    case method_hash("animateSize"):
+      method = Method::kAnimateSize;
+      break;
+    case method_hash("cancelAnimations"):
+      method = Method::kCancelAnimations;
+      break;
+    case method_hash("setRenderPolicy"):
+      method = Method::kSetRenderPolicy;
+      break;
+    case method_hash("setFrameRateCap"):
+      method = Method::kSetFrameRateCap;
+      break;
+    case method_hash("setAutoHide"):
+      method = Method::kSetAutoHide;
+      break;
+    case method_hash("requestFrame"):
+      method = Method::kRequestFrame;
+      break;
+    case method_hash("getFrameStats"):
+      method = Method::kGetFrameStats;
+      break;
+    case method_hash("getScaleInfo"):
+      method = Method::kGetScaleInfo;
+      break;
+    case method_hash("isPresentationSupported"):
+      method = Method::kIsPresentationSupported;
+      break;
+    case method_hash("setLogLevel"):
+      method = Method::kSetLogLevel;
+      break;
+    case method_hash("getLogRecords"):
+      method = Method::kGetLogRecords;
+      break;
+    case method_hash("getStats"):
+      method = Method::kGetStats;
+      break;
+    case method_hash("resetStats"):
+      method = Method::kResetStats;
+      break;
+    case method_hash("startTracing"):
+      method = Method::kStartTracing;
+      break;
+    case method_hash("stopTracing"):
+      method = Method::kStopTracing;
+      break;
+    case method_hash("listenControlSocket"):
+      method = Method::kListenControlSocket;
+      break;
+    case method_hash("closeControlSocket"):
+      method = Method::kCloseControlSocket;
+      break;
+    case method_hash("activateToplevel"):
+      method = Method::kActivateToplevel;
+      break;
+    case method_hash("setToplevelMinimized"):
+      method = Method::kSetToplevelMinimized;
+      break;
+    case method_hash("closeToplevel"):
+      method = Method::kCloseToplevel;
+      break;
+    default:
+      return Method::kUnknown;
+  }
+  return strcmp(name, kMethodNames[static_cast<size_t>(method)]) == 0
+             ? method
+             : Method::kUnknown;
+}
+
+}  // namespace channel_api
+
+#endif  // WAYLAND_LAYER_SHELL_CHANNEL_API_G_H_
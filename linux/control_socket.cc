@@ -0,0 +1,206 @@
+#include "control_socket.h"
+
+#include <gio/gunixsocketaddress.h>
+#include <glib/gstdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "plugin_log.h"
+#include "plugin_trace.h"
+
+struct _ControlSocket {
+  GSocketService *service;
+  gchar *path;
+  ControlCommandFunc func;
+  gpointer user_data;
+  // Cancels the pending reads of all connections when the socket goes away.
+  GCancellable *cancellable;
+};
+
+typedef struct {
+  // Only valid while @cancellable, the socket's, is not cancelled.
+  ControlSocket *socket;
+  GCancellable *cancellable;
+  GSocketConnection *connection;
+  GDataInputStream *input;
+} ControlConnection;
+
+static void read_next_line(ControlConnection *connection);
+
+static void connection_free(ControlConnection *connection) {
+  g_object_unref(connection->input);
+  g_object_unref(connection->connection);
+  g_object_unref(connection->cancellable);
+  g_free(connection);
+}
+
+// Sends @text without blocking the main loop. A client that lets its replies
+// pile up in the socket buffer is dropped instead of waited for.
+static gboolean send_reply(ControlConnection *connection, const gchar *text) {
+  GOutputStream *output =
+      g_io_stream_get_output_stream(G_IO_STREAM(connection->connection));
+  gssize length = strlen(text);
+  g_autoptr(GError) error = nullptr;
+  gssize written = g_pollable_output_stream_write_nonblocking(
+      G_POLLABLE_OUTPUT_STREAM(output), text, length, nullptr, &error);
+  if (written != length) {
+    PLUGIN_LOG_W("Dropping control client: %s",
+                 error != nullptr ? error->message : "reply did not fit");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// Runs the command on @line and replies to it. Returns FALSE if the
+// connection should be closed.
+static gboolean handle_line(ControlConnection *connection, const gchar *line) {
+  ControlSocket *self = connection->socket;
+  g_auto(GStrv) argv = nullptr;
+  g_autoptr(GError) error = nullptr;
+  if (!g_shell_parse_argv(line, nullptr, &argv, &error)) {
+    // Blank lines are not commands and get no reply.
+    if (g_error_matches(error, G_SHELL_ERROR, G_SHELL_ERROR_EMPTY_STRING)) {
+      return TRUE;
+    }
+    g_autofree gchar *reply = g_strdup_printf("error %s\n", error->message);
+    return send_reply(connection, reply);
+  }
+
+  guint64 trace_start = PLUGIN_TRACE_BEGIN();
+  gboolean ok = self->func(argv, &error, self->user_data);
+  PLUGIN_TRACE_END(trace_start, "control_command");
+  if (ok) {
+    return send_reply(connection, "ok\n");
+  }
+  PLUGIN_LOG_D("Control command %s failed: %s", argv[0], error->message);
+  g_autofree gchar *reply = g_strdup_printf("error %s\n", error->message);
+  return send_reply(connection, reply);
+}
+
+static void line_cb(GObject *source, GAsyncResult *result, gpointer user_data) {
+  ControlConnection *connection = static_cast<ControlConnection *>(user_data);
+  g_autoptr(GError) error = nullptr;
+  g_autofree gchar *line = g_data_input_stream_read_line_finish_utf8(
+      G_DATA_INPUT_STREAM(source), result, nullptr, &error);
+  if (g_cancellable_is_cancelled(connection->cancellable)) {
+    connection_free(connection);
+    return;
+  }
+  if (line == nullptr) {
+    // The client hung up or sent invalid UTF-8.
+    if (error != nullptr) {
+      PLUGIN_LOG_D("Control client dropped: %s", error->message);
+    }
+    connection_free(connection);
+    return;
+  }
+
+  if (!handle_line(connection, line)) {
+    connection_free(connection);
+    return;
+  }
+  read_next_line(connection);
+}
+
+static void read_next_line(ControlConnection *connection) {
+  g_data_input_stream_read_line_async(connection->input, G_PRIORITY_DEFAULT,
+                                      connection->cancellable, line_cb,
+                                      connection);
+}
+
+static gboolean incoming_cb(GSocketService *service,
+                            GSocketConnection *socket_connection,
+                            GObject *source_object, gpointer user_data) {
+  ControlSocket *self = static_cast<ControlSocket *>(user_data);
+  ControlConnection *connection = g_new0(ControlConnection, 1);
+  connection->socket = self;
+  connection->cancellable = G_CANCELLABLE(g_object_ref(self->cancellable));
+  connection->connection =
+      G_SOCKET_CONNECTION(g_object_ref(socket_connection));
+  connection->input = g_data_input_stream_new(
+      g_io_stream_get_input_stream(G_IO_STREAM(socket_connection)));
+  g_data_input_stream_set_newline_type(connection->input,
+                                       G_DATA_STREAM_NEWLINE_TYPE_ANY);
+  PLUGIN_LOG_D("Control client connected");
+  read_next_line(connection);
+  return TRUE;
+}
+
+// Removes a socket file left behind by a process that is gone, so binding to
+// @path can succeed. Fails if something else lives at @path.
+static gboolean remove_stale_socket(const gchar *path,
+                                    GSocketAddress *address,
+                                    GError **error) {
+  GStatBuf stat_buf;
+  if (g_lstat(path, &stat_buf) != 0) {
+    return TRUE;
+  }
+  if (!S_ISSOCK(stat_buf.st_mode)) {
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_EXISTS,
+                "%s exists and is not a socket", path);
+    return FALSE;
+  }
+
+  g_autoptr(GSocketClient) client = g_socket_client_new();
+  g_autoptr(GSocketConnection) connection = g_socket_client_connect(
+      client, G_SOCKET_CONNECTABLE(address), nullptr, nullptr);
+  if (connection != nullptr) {
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_ADDRESS_IN_USE,
+                "%s is in use by another process", path);
+    return FALSE;
+  }
+  g_unlink(path);
+  return TRUE;
+}
+
+ControlSocket *control_socket_new(const gchar *path, ControlCommandFunc func,
+                                  gpointer user_data, GError **error) {
+  g_autofree gchar *socket_path =
+      path != nullptr
+          ? g_strdup(path)
+          : g_strdup_printf("%s/wayland_layer_shell-%d.sock",
+                            g_get_user_runtime_dir(), getpid());
+  g_autoptr(GSocketAddress) address =
+      g_unix_socket_address_new(socket_path);
+  if (!remove_stale_socket(socket_path, address, error)) {
+    return nullptr;
+  }
+
+  g_autoptr(GSocketService) service = g_socket_service_new();
+  if (!g_socket_listener_add_address(
+          G_SOCKET_LISTENER(service), address, G_SOCKET_TYPE_STREAM,
+          G_SOCKET_PROTOCOL_DEFAULT, nullptr, nullptr, error)) {
+    return nullptr;
+  }
+  g_chmod(socket_path, 0600);
+
+  ControlSocket *self = g_new0(ControlSocket, 1);
+  self->service = static_cast<GSocketService *>(g_steal_pointer(&service));
+  self->path = static_cast<gchar *>(g_steal_pointer(&socket_path));
+  self->func = func;
+  self->user_data = user_data;
+  self->cancellable = g_cancellable_new();
+  g_signal_connect(self->service, "incoming", G_CALLBACK(incoming_cb), self);
+  g_socket_service_start(self->service);
+  PLUGIN_LOG_I("Listening for control commands on %s", self->path);
+  return self;
+}
+
+void control_socket_free(ControlSocket *self) {
+  g_signal_handlers_disconnect_by_data(self->service, self);
+  g_socket_service_stop(self->service);
+  g_socket_listener_close(G_SOCKET_LISTENER(self->service));
+  g_clear_object(&self->service);
+  // The connections free themselves once their reads are cancelled.
+  g_cancellable_cancel(self->cancellable);
+  g_clear_object(&self->cancellable);
+  g_unlink(self->path);
+  g_free(self->path);
+  g_free(self);
+}
+
+const gchar *control_socket_get_path(const ControlSocket *self) {
+  return self->path;
+}
@@ -0,0 +1,34 @@
+#ifndef WAYLAND_LAYER_SHELL_CONTROL_SOCKET_H_
+#define WAYLAND_LAYER_SHELL_CONTROL_SOCKET_H_
+
+#include <gio/gio.h>
+
+// Runs the command in @argv (the words of one request line, nullptr
+// terminated and never empty). Returns FALSE with @error set if it failed.
+typedef gboolean (*ControlCommandFunc)(gchar **argv, GError **error,
+                                       gpointer user_data);
+
+// Unix domain socket that lets other processes, e.g. a keybinding helper,
+// control the surface without going through Dart.
+//
+// Clients send one command per line, as words separated by spaces, and get
+// one line back for each: "ok", or "error" followed by a message. Commands
+// are read by a GSocketService on the main context and run right away, so a
+// command is handled within one main loop iteration of arriving. Any number
+// of clients may be connected at once.
+typedef struct _ControlSocket ControlSocket;
+
+// Listens on @path, or on wayland_layer_shell-<pid>.sock in the user's runtime
+// directory if @path is nullptr. A stale socket file left at @path by a
+// process that is gone is replaced; one that still accepts connections is
+// not. The socket is only accessible to the user. Returns nullptr with @error
+// set on failure.
+ControlSocket *control_socket_new(const gchar *path, ControlCommandFunc func,
+                                  gpointer user_data, GError **error);
+
+// Closes the socket and all connections, and removes the socket file.
+void control_socket_free(ControlSocket *socket);
+
+const gchar *control_socket_get_path(const ControlSocket *socket);
+
+#endif  // WAYLAND_LAYER_SHELL_CONTROL_SOCKET_H_
@@ -0,0 +1,392 @@
+#include "foreign_toplevels.h"
+
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+#include <gdk/gdkwayland.h>
+#include <wayland-client.h>
+
+#include <algorithm>
+
+#include "wlr-foreign-toplevel-management-unstable-v1-client-protocol.h"
+#endif
+
+#include "plugin_log.h"
+#include "plugin_trace.h"
+#include "wayland_globals.h"
+
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+
+// Version 3 adds the parent event.
+static constexpr uint32_t kManagerVersion = 3;
+
+// Shared by all trackers, so a tracker started after another one was freed
+// (Dart cancelling and listening again) never hands out an old id.
+static guint next_id = 1;
+
+struct Toplevel {
+  ForeignToplevels *owner;
+  struct zwlr_foreign_toplevel_handle_v1 *handle;
+  // As last reported.
+  ToplevelInfo info;
+  // As the compositor is describing it, until its next "done".
+  ToplevelInfo pending;
+  // Fields changed by "done" events since the last batch.
+  guint changed_fields;
+  bool reported;
+  bool closed;
+  bool dirty;
+};
+
+struct ForeignToplevels {
+  GdkDisplay *display;
+  struct zwlr_foreign_toplevel_manager_v1 *manager;
+  std::vector<Toplevel *> toplevels;
+  // Toplevels with changes for the next batch, in the order they changed.
+  std::vector<Toplevel *> dirty;
+  guint batch_idle_id;
+  ToplevelsChangedFunc changed_func;
+  gpointer user_data;
+  // Set by foreign_toplevels_free() once it asked the compositor to stop;
+  // the tracker then lives on without a listener until "finished".
+  bool stopping;
+};
+
+static void toplevel_free(Toplevel *toplevel) {
+  zwlr_foreign_toplevel_handle_v1_destroy(toplevel->handle);
+  delete toplevel;
+}
+
+static Toplevel *find_toplevel(ForeignToplevels *self, guint id) {
+  for (Toplevel *toplevel : self->toplevels) {
+    if (toplevel->info.id == id && !toplevel->closed) {
+      return toplevel;
+    }
+  }
+  return nullptr;
+}
+
+static GdkMonitor *find_monitor(GdkDisplay *display, struct wl_output *output) {
+  for (int i = 0; i < gdk_display_get_n_monitors(display); i++) {
+    GdkMonitor *monitor = gdk_display_get_monitor(display, i);
+    if (gdk_wayland_monitor_get_wl_output(monitor) == output) {
+      return monitor;
+    }
+  }
+  return nullptr;
+}
+
+// Reports the changes made since the last batch, once GTK has dispatched all
+// the events it read from the display.
+static gboolean batch_idle_cb(gpointer user_data) {
+  ForeignToplevels *self = static_cast<ForeignToplevels *>(user_data);
+  self->batch_idle_id = 0;
+
+  std::vector<ToplevelUpdate> updates;
+  for (Toplevel *toplevel : self->dirty) {
+    toplevel->dirty = false;
+    ToplevelUpdate update = {};
+    update.info = &toplevel->info;
+    if (toplevel->closed) {
+      if (!toplevel->reported) {
+        continue;
+      }
+      update.change = TOPLEVEL_CLOSED;
+    } else if (!toplevel->reported) {
+      update.change = TOPLEVEL_ADDED;
+      update.fields = TOPLEVEL_FIELD_ALL;
+      toplevel->reported = true;
+    } else {
+      update.change = TOPLEVEL_CHANGED;
+      update.fields = toplevel->changed_fields;
+    }
+    toplevel->changed_fields = 0;
+    updates.push_back(update);
+  }
+  self->dirty.clear();
+
+  PLUGIN_TRACE_INSTANT("toplevel_batch", "updates", updates.size());
+  if (!updates.empty()) {
+    self->changed_func(updates.data(), updates.size(), self->user_data);
+  }
+
+  // Closed toplevels were only kept for their last update.
+  auto closed = std::remove_if(
+      self->toplevels.begin(), self->toplevels.end(), [](Toplevel *toplevel) {
+        if (!toplevel->closed) {
+          return false;
+        }
+        toplevel_free(toplevel);
+        return true;
+      });
+  self->toplevels.erase(closed, self->toplevels.end());
+  return G_SOURCE_REMOVE;
+}
+
+static void mark_dirty(Toplevel *toplevel) {
+  ForeignToplevels *self = toplevel->owner;
+  if (!toplevel->dirty) {
+    toplevel->dirty = true;
+    self->dirty.push_back(toplevel);
+  }
+  if (self->batch_idle_id == 0) {
+    self->batch_idle_id =
+        g_idle_add_full(G_PRIORITY_HIGH_IDLE, batch_idle_cb, self, nullptr);
+  }
+}
+
+static void title_cb(void *data,
+                     struct zwlr_foreign_toplevel_handle_v1 *handle,
+                     const char *title) {
+  static_cast<Toplevel *>(data)->pending.title = title;
+}
+
+static void app_id_cb(void *data,
+                      struct zwlr_foreign_toplevel_handle_v1 *handle,
+                      const char *app_id) {
+  static_cast<Toplevel *>(data)->pending.app_id = app_id;
+}
+
+static void output_enter_cb(void *data,
+                            struct zwlr_foreign_toplevel_handle_v1 *handle,
+                            struct wl_output *output) {
+  Toplevel *toplevel = static_cast<Toplevel *>(data);
+  GdkMonitor *monitor = find_monitor(toplevel->owner->display, output);
+  std::vector<GdkMonitor *> &monitors = toplevel->pending.monitors;
+  if (monitor != nullptr &&
+      std::find(monitors.begin(), monitors.end(), monitor) == monitors.end()) {
+    monitors.push_back(monitor);
+  }
+}
+
+static void output_leave_cb(void *data,
+                            struct zwlr_foreign_toplevel_handle_v1 *handle,
+                            struct wl_output *output) {
+  Toplevel *toplevel = static_cast<Toplevel *>(data);
+  GdkMonitor *monitor = find_monitor(toplevel->owner->display, output);
+  std::vector<GdkMonitor *> &monitors = toplevel->pending.monitors;
+  monitors.erase(std::remove(monitors.begin(), monitors.end(), monitor),
+                 monitors.end());
+}
+
+static void state_cb(void *data, struct zwlr_foreign_toplevel_handle_v1 *handle,
+                     struct wl_array *states) {
+  guint32 state = 0;
+  const uint32_t *entries = static_cast<const uint32_t *>(states->data);
+  for (size_t i = 0; i < states->size / sizeof(uint32_t); i++) {
+    switch (entries[i]) {
+    case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MAXIMIZED:
+      state |= TOPLEVEL_STATE_MAXIMIZED;
+      break;
+    case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_MINIMIZED:
+      state |= TOPLEVEL_STATE_MINIMIZED;
+      break;
+    case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_ACTIVATED:
+      state |= TOPLEVEL_STATE_ACTIVATED;
+      break;
+    case ZWLR_FOREIGN_TOPLEVEL_HANDLE_V1_STATE_FULLSCREEN:
+      state |= TOPLEVEL_STATE_FULLSCREEN;
+      break;
+    }
+  }
+  static_cast<Toplevel *>(data)->pending.state = state;
+}
+
+static void parent_cb(void *data,
+                      struct zwlr_foreign_toplevel_handle_v1 *handle,
+                      struct zwlr_foreign_toplevel_handle_v1 *parent) {
+  Toplevel *parent_toplevel =
+      parent != nullptr ? static_cast<Toplevel *>(wl_proxy_get_user_data(
+                              reinterpret_cast<struct wl_proxy *>(parent)))
+                        : nullptr;
+  static_cast<Toplevel *>(data)->pending.parent_id =
+      parent_toplevel != nullptr ? parent_toplevel->info.id : 0;
+}
+
+// Applies what the compositor sent since the last "done", noting which
+// fields actually changed.
+static void done_cb(void *data,
+                    struct zwlr_foreign_toplevel_handle_v1 *handle) {
+  Toplevel *toplevel = static_cast<Toplevel *>(data);
+  const ToplevelInfo &pending = toplevel->pending;
+  ToplevelInfo &info = toplevel->info;
+  guint fields = 0;
+  if (pending.app_id != info.app_id) {
+    fields |= TOPLEVEL_FIELD_APP_ID;
+  }
+  if (pending.title != info.title) {
+    fields |= TOPLEVEL_FIELD_TITLE;
+  }
+  if (pending.state != info.state) {
+    fields |= TOPLEVEL_FIELD_STATE;
+  }
+  if (pending.monitors != info.monitors) {
+    fields |= TOPLEVEL_FIELD_MONITORS;
+  }
+  if (pending.parent_id != info.parent_id) {
+    fields |= TOPLEVEL_FIELD_PARENT;
+  }
+  if (fields == 0 && toplevel->reported) {
+    return;
+  }
+  info = pending;
+  toplevel->changed_fields |= fields;
+  mark_dirty(toplevel);
+}
+
+static void closed_cb(void *data,
+                      struct zwlr_foreign_toplevel_handle_v1 *handle) {
+  Toplevel *toplevel = static_cast<Toplevel *>(data);
+  toplevel->closed = true;
+  mark_dirty(toplevel);
+}
+
+static const struct zwlr_foreign_toplevel_handle_v1_listener handle_listener =
+    {
+        title_cb,        app_id_cb, output_enter_cb, output_leave_cb,
+        state_cb,        done_cb,   closed_cb,       parent_cb,
+};
+
+static void toplevel_cb(void *data,
+                        struct zwlr_foreign_toplevel_manager_v1 *manager,
+                        struct zwlr_foreign_toplevel_handle_v1 *handle) {
+  ForeignToplevels *self = static_cast<ForeignToplevels *>(data);
+  // The compositor may still announce windows until it acknowledges stop.
+  if (self->stopping) {
+    zwlr_foreign_toplevel_handle_v1_destroy(handle);
+    return;
+  }
+  Toplevel *toplevel = new Toplevel();
+  toplevel->owner = self;
+  toplevel->handle = handle;
+  toplevel->info.id = toplevel->pending.id = next_id++;
+  self->toplevels.push_back(toplevel);
+  zwlr_foreign_toplevel_handle_v1_add_listener(handle, &handle_listener,
+                                               toplevel);
+}
+
+static void finished_cb(void *data,
+                        struct zwlr_foreign_toplevel_manager_v1 *manager) {
+  ForeignToplevels *self = static_cast<ForeignToplevels *>(data);
+  zwlr_foreign_toplevel_manager_v1_destroy(self->manager);
+  self->manager = nullptr;
+  if (self->stopping) {
+    g_object_unref(self->display);
+    delete self;
+    return;
+  }
+  PLUGIN_LOG_W("The compositor stopped sending toplevels");
+}
+
+static const struct zwlr_foreign_toplevel_manager_v1_listener
+    manager_listener = {
+        toplevel_cb,
+        finished_cb,
+};
+
+#else
+
+struct ForeignToplevels {};
+
+#endif  // WAYLAND_LAYER_SHELL_PROTOCOLS
+
+gboolean foreign_toplevels_is_supported(GdkDisplay *display) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  return wayland_globals_get(display)->foreign_toplevel_name != 0;
+#else
+  return FALSE;
+#endif
+}
+
+ForeignToplevels *foreign_toplevels_new(GdkDisplay *display,
+                                        ToplevelsChangedFunc changed_func,
+                                        gpointer user_data) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  const WaylandGlobals *globals = wayland_globals_get(display);
+  if (globals->foreign_toplevel_name == 0) {
+    return nullptr;
+  }
+  ForeignToplevels *self = new ForeignToplevels();
+  self->display = GDK_DISPLAY(g_object_ref(display));
+  self->changed_func = changed_func;
+  self->user_data = user_data;
+  self->manager = static_cast<struct zwlr_foreign_toplevel_manager_v1 *>(
+      wayland_globals_bind(
+          display, globals->foreign_toplevel_name,
+          &zwlr_foreign_toplevel_manager_v1_interface,
+          std::min(globals->foreign_toplevel_version, kManagerVersion)));
+  zwlr_foreign_toplevel_manager_v1_add_listener(self->manager,
+                                                &manager_listener, self);
+  PLUGIN_LOG_D("Tracking toplevels");
+  return self;
+#else
+  return nullptr;
+#endif
+}
+
+void foreign_toplevels_free(ForeignToplevels *self) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  if (self->batch_idle_id != 0) {
+    g_source_remove(self->batch_idle_id);
+    self->batch_idle_id = 0;
+  }
+  for (Toplevel *toplevel : self->toplevels) {
+    toplevel_free(toplevel);
+  }
+  self->toplevels.clear();
+  self->dirty.clear();
+  // The manager may only be destroyed once the compositor acknowledged stop
+  // with finished, so finished_cb frees the rest.
+  if (self->manager != nullptr) {
+    self->stopping = true;
+    zwlr_foreign_toplevel_manager_v1_stop(self->manager);
+    return;
+  }
+  g_object_unref(self->display);
+#endif
+  delete self;
+}
+
+gboolean foreign_toplevels_activate(ForeignToplevels *self, guint id) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  Toplevel *toplevel = find_toplevel(self, id);
+  GdkSeat *seat = gdk_display_get_default_seat(self->display);
+  if (toplevel == nullptr || seat == nullptr) {
+    return FALSE;
+  }
+  zwlr_foreign_toplevel_handle_v1_activate(toplevel->handle,
+                                           gdk_wayland_seat_get_wl_seat(seat));
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
+gboolean foreign_toplevels_set_minimized(ForeignToplevels *self, guint id,
+                                         gboolean minimized) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  Toplevel *toplevel = find_toplevel(self, id);
+  if (toplevel == nullptr) {
+    return FALSE;
+  }
+  if (minimized) {
+    zwlr_foreign_toplevel_handle_v1_set_minimized(toplevel->handle);
+  } else {
+    zwlr_foreign_toplevel_handle_v1_unset_minimized(toplevel->handle);
+  }
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
+gboolean foreign_toplevels_close(ForeignToplevels *self, guint id) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  Toplevel *toplevel = find_toplevel(self, id);
+  if (toplevel == nullptr) {
+    return FALSE;
+  }
+  zwlr_foreign_toplevel_handle_v1_close(toplevel->handle);
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
@@ -0,0 +1,93 @@
+#ifndef WAYLAND_LAYER_SHELL_FOREIGN_TOPLEVELS_H_
+#define WAYLAND_LAYER_SHELL_FOREIGN_TOPLEVELS_H_
+
+#include <gtk/gtk.h>
+
+#include <string>
+#include <vector>
+
+// ToplevelInfo::state bits.
+enum {
+  TOPLEVEL_STATE_MAXIMIZED = 1 << 0,
+  TOPLEVEL_STATE_MINIMIZED = 1 << 1,
+  TOPLEVEL_STATE_ACTIVATED = 1 << 2,
+  TOPLEVEL_STATE_FULLSCREEN = 1 << 3,
+};
+
+// ToplevelUpdate::fields bits, one per ToplevelInfo field.
+enum {
+  TOPLEVEL_FIELD_APP_ID = 1 << 0,
+  TOPLEVEL_FIELD_TITLE = 1 << 1,
+  TOPLEVEL_FIELD_STATE = 1 << 2,
+  TOPLEVEL_FIELD_MONITORS = 1 << 3,
+  TOPLEVEL_FIELD_PARENT = 1 << 4,
+  TOPLEVEL_FIELD_ALL = (1 << 5) - 1,
+};
+
+// A window of any app, as the compositor describes it.
+struct ToplevelInfo {
+  // Unique for as long as the plugin runs. Never 0.
+  guint id;
+  std::string app_id;
+  std::string title;
+  guint32 state;
+  // The monitors the window is visible on.
+  std::vector<GdkMonitor *> monitors;
+  // Id of the window this one is a dialog of, or 0.
+  guint parent_id;
+};
+
+typedef enum {
+  TOPLEVEL_ADDED,
+  TOPLEVEL_CHANGED,
+  TOPLEVEL_CLOSED,
+} ToplevelChange;
+
+typedef struct {
+  ToplevelChange change;
+  // The fields that changed; TOPLEVEL_FIELD_ALL for TOPLEVEL_ADDED, 0 for
+  // TOPLEVEL_CLOSED.
+  guint fields;
+  const ToplevelInfo *info;
+} ToplevelUpdate;
+
+// Called with the changes of one batch, in the order they happened.
+typedef void (*ToplevelsChangedFunc)(const ToplevelUpdate *updates,
+                                     size_t n_updates, gpointer user_data);
+
+// Keeps a table of all windows on the display through
+// zwlr_foreign_toplevel_manager_v1, for taskbars.
+//
+// The compositor describes each window once when tracking starts, and after
+// that only sends what changed; a title that changes every second is one
+// title event. Changes are applied to the table as the compositor's "done"
+// events make them complete, and reported together from an idle callback
+// once GTK has dispatched everything it read from the display, so a burst of
+// changes to several windows makes a single batch. A window that opens and
+// closes within one batch is not reported.
+//
+// Without the protocol (compositor or build) the table stays empty.
+struct ForeignToplevels;
+
+// Starts tracking the windows of @display. Returns nullptr if the compositor
+// does not offer zwlr_foreign_toplevel_manager_v1.
+ForeignToplevels *foreign_toplevels_new(GdkDisplay *display,
+                                        ToplevelsChangedFunc changed_func,
+                                        gpointer user_data);
+
+// Stops tracking and drops the table. The compositor may still be sending
+// toplevels; they are discarded until it confirms it stopped.
+void foreign_toplevels_free(ForeignToplevels *toplevels);
+
+// Whether the compositor offers zwlr_foreign_toplevel_manager_v1. FALSE when
+// built without protocol support.
+gboolean foreign_toplevels_is_supported(GdkDisplay *display);
+
+// Requests for the window with @id. Each returns FALSE if there is no such
+// window; the compositor may still ignore the request.
+gboolean foreign_toplevels_activate(ForeignToplevels *toplevels, guint id);
+gboolean foreign_toplevels_set_minimized(ForeignToplevels *toplevels,
+                                         guint id, gboolean minimized);
+gboolean foreign_toplevels_close(ForeignToplevels *toplevels, guint id);
+
+#endif  // WAYLAND_LAYER_SHELL_FOREIGN_TOPLEVELS_H_
@@ -0,0 +1,140 @@
+#include "fractional_scale.h"
+
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+#include <gdk/gdkwayland.h>
+#include <wayland-client.h>
+
+#include "fractional-scale-v1-client-protocol.h"
+#endif
+
+#include "plugin_log.h"
+#include "wayland_globals.h"
+
+struct _FractionalScale {
+  GtkWindow *window;
+  FractionalScaleChangedFunc changed_func;
+  gpointer user_data;
+  double preferred;
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  struct wp_fractional_scale_v1 *object;
+  gulong map_handler_id;
+  gulong unmap_handler_id;
+#endif
+};
+
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+
+// wp_fractional_scale_v1 sends scales as multiples of 1/120.
+static constexpr double kScaleDenominator = 120.0;
+
+static void preferred_scale_cb(void *data,
+                               struct wp_fractional_scale_v1 *object,
+                               uint32_t scale) {
+  FractionalScale *self = static_cast<FractionalScale *>(data);
+  double preferred = scale / kScaleDenominator;
+  if (preferred == self->preferred) {
+    return;
+  }
+  self->preferred = preferred;
+  PLUGIN_LOG_D("Preferred scale %.3f", preferred);
+  if (self->changed_func != nullptr) {
+    self->changed_func(preferred, self->user_data);
+  }
+}
+
+static const struct wp_fractional_scale_v1_listener fractional_scale_listener =
+    {
+        preferred_scale_cb,
+};
+
+static void destroy_object(FractionalScale *self) {
+  g_clear_pointer(&self->object, wp_fractional_scale_v1_destroy);
+}
+
+// GTK3 creates the wl_surface when the window is shown, and gtk-layer-shell
+// its layer surface, so this is the first point where the surface exists.
+static void map_cb(GtkWidget *widget, gpointer user_data) {
+  FractionalScale *self = static_cast<FractionalScale *>(user_data);
+  GdkWindow *gdk_window = gtk_widget_get_window(widget);
+  struct wp_fractional_scale_manager_v1 *manager =
+      wayland_globals_get(gtk_widget_get_display(widget))
+          ->fractional_scale_manager;
+  if (manager == nullptr || self->object != nullptr ||
+      gdk_window == nullptr || !GDK_IS_WAYLAND_WINDOW(gdk_window)) {
+    return;
+  }
+
+  struct wl_surface *surface = gdk_wayland_window_get_wl_surface(gdk_window);
+  if (surface == nullptr) {
+    return;
+  }
+  self->object =
+      wp_fractional_scale_manager_v1_get_fractional_scale(manager, surface);
+  wp_fractional_scale_v1_add_listener(self->object, &fractional_scale_listener,
+                                      self);
+}
+
+// The wl_surface is gone once the window is hidden. Destroying the scale
+// object afterwards is still allowed.
+static void unmap_cb(GtkWidget *widget, gpointer user_data) {
+  destroy_object(static_cast<FractionalScale *>(user_data));
+}
+
+#endif  // WAYLAND_LAYER_SHELL_PROTOCOLS
+
+FractionalScale *fractional_scale_new(GtkWindow *window,
+                                      FractionalScaleChangedFunc changed_func,
+                                      gpointer user_data) {
+  FractionalScale *self = g_new0(FractionalScale, 1);
+  self->window = window;
+  self->changed_func = changed_func;
+  self->user_data = user_data;
+
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  if (wayland_globals_get(gtk_widget_get_display(GTK_WIDGET(window)))
+          ->fractional_scale_manager != nullptr) {
+    self->map_handler_id =
+        g_signal_connect_after(window, "map", G_CALLBACK(map_cb), self);
+    self->unmap_handler_id =
+        g_signal_connect_after(window, "unmap", G_CALLBACK(unmap_cb), self);
+    if (gtk_widget_get_mapped(GTK_WIDGET(window))) {
+      map_cb(GTK_WIDGET(window), self);
+    }
+  }
+#endif
+
+  return self;
+}
+
+void fractional_scale_free(FractionalScale *self) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  destroy_object(self);
+  if (self->map_handler_id != 0) {
+    g_signal_handler_disconnect(self->window, self->map_handler_id);
+    g_signal_handler_disconnect(self->window, self->unmap_handler_id);
+  }
+#endif
+  g_free(self);
+}
+
+gboolean fractional_scale_is_supported(FractionalScale *self) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  return wayland_globals_get(gtk_widget_get_display(GTK_WIDGET(self->window)))
+             ->fractional_scale_manager != nullptr;
+#else
+  return FALSE;
+#endif
+}
+
+gboolean fractional_scale_has_viewporter(FractionalScale *self) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  return wayland_globals_get(gtk_widget_get_display(GTK_WIDGET(self->window)))
+             ->viewporter != nullptr;
+#else
+  return FALSE;
+#endif
+}
+
+double fractional_scale_get_preferred(FractionalScale *self) {
+  return self->preferred;
+}
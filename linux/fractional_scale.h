@@ -0,0 +1,39 @@
+#ifndef WAYLAND_LAYER_SHELL_FRACTIONAL_SCALE_H_
+#define WAYLAND_LAYER_SHELL_FRACTIONAL_SCALE_H_
+
+#include <gtk/gtk.h>
+
+// Called with the scale the compositor prefers for the surface, e.g. 1.25.
+typedef void (*FractionalScaleChangedFunc)(double scale, gpointer user_data);
+
+// Tracks the preferred fractional scale of a window's wl_surface through
+// wp_fractional_scale_v1.
+//
+// GTK3 only knows integer scales: on a 1.5x output it renders at 2x and the
+// compositor scales the buffer down. The protocol object is created whenever
+// the window is mapped (GTK3 creates a new wl_surface each time) and reports
+// the exact scale, which tells how many of the rendered pixels end up being
+// thrown away. The buffer itself stays GTK's, so it is not rendered at the
+// fractional scale; wp_viewporter is only probed for.
+//
+// Without the protocols (compositor or build) the scale reads 0 and no
+// changes are reported.
+typedef struct _FractionalScale FractionalScale;
+
+// Starts tracking @window. Does not take a reference; free the tracker before
+// the window goes away.
+FractionalScale *fractional_scale_new(GtkWindow *window,
+                                      FractionalScaleChangedFunc changed_func,
+                                      gpointer user_data);
+
+void fractional_scale_free(FractionalScale *fractional_scale);
+
+// Whether the compositor offers wp_fractional_scale_manager_v1 and
+// wp_viewporter. Both FALSE when built without protocol support.
+gboolean fractional_scale_is_supported(FractionalScale *fractional_scale);
+gboolean fractional_scale_has_viewporter(FractionalScale *fractional_scale);
+
+// The last preferred scale, or 0 if none was received.
+double fractional_scale_get_preferred(FractionalScale *fractional_scale);
+
+#endif  // WAYLAND_LAYER_SHELL_FRACTIONAL_SCALE_H_
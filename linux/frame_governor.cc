@@ -0,0 +1,187 @@
+#include "frame_governor.h"
+
+static void hold(FrameGovernor *governor) {
+  GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(governor->window));
+  if (governor->frozen_window != nullptr || gdk_window == nullptr) {
+    return;
+  }
+  gdk_window_freeze_updates(gdk_window);
+  governor->frozen_window = gdk_window;
+  governor->held_frames++;
+}
+
+static void release(FrameGovernor *governor) {
+  if (governor->thaw_id != 0) {
+    g_source_remove(governor->thaw_id);
+    governor->thaw_id = 0;
+  }
+  if (governor->frozen_window != nullptr) {
+    // Thawing schedules a paint if anything was invalidated meanwhile.
+    gdk_window_thaw_updates(governor->frozen_window);
+    governor->frozen_window = nullptr;
+  }
+}
+
+static gboolean thaw_cb(gpointer user_data) {
+  FrameGovernor *governor = static_cast<FrameGovernor *>(user_data);
+  governor->thaw_id = 0;
+  release(governor);
+  return G_SOURCE_REMOVE;
+}
+
+static void after_paint_cb(GdkFrameClock *frame_clock, gpointer user_data) {
+  FrameGovernor *governor = static_cast<FrameGovernor *>(user_data);
+  if (governor->frozen_window != nullptr) {
+    // A frame that ran for other reasons (e.g. tick callbacks) while the
+    // window was held; nothing was painted.
+    return;
+  }
+  governor->frames++;
+
+  if (governor->paused) {
+    hold(governor);
+    return;
+  }
+
+  switch (governor->policy) {
+  case FRAME_POLICY_CAPPED: {
+    gint64 interval = G_USEC_PER_SEC / governor->fps_cap;
+    gint64 elapsed =
+        g_get_monotonic_time() - gdk_frame_clock_get_frame_time(frame_clock);
+    gint64 remaining = interval - elapsed;
+    if (remaining <= 0) {
+      return;
+    }
+    hold(governor);
+    governor->thaw_id =
+        g_timeout_add((remaining + 999) / 1000, thaw_cb, governor);
+    break;
+  }
+  case FRAME_POLICY_ON_DEMAND:
+    hold(governor);
+    break;
+  case FRAME_POLICY_CONTINUOUS:
+    break;
+  }
+}
+
+static void detach_frame_clock(FrameGovernor *governor) {
+  release(governor);
+  if (governor->frame_clock != nullptr) {
+    g_signal_handler_disconnect(governor->frame_clock,
+                                governor->after_paint_handler_id);
+    governor->after_paint_handler_id = 0;
+    g_clear_object(&governor->frame_clock);
+  }
+}
+
+static void attach_frame_clock(FrameGovernor *governor) {
+  GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(governor->window));
+  if (governor->frame_clock != nullptr || gdk_window == nullptr) {
+    return;
+  }
+  governor->frame_clock =
+      GDK_FRAME_CLOCK(g_object_ref(gdk_window_get_frame_clock(gdk_window)));
+  governor->after_paint_handler_id =
+      g_signal_connect(governor->frame_clock, "after-paint",
+                       G_CALLBACK(after_paint_cb), governor);
+}
+
+static void realize_cb(GtkWidget *widget, gpointer user_data) {
+  attach_frame_clock(static_cast<FrameGovernor *>(user_data));
+}
+
+// The GdkWindow and its frame clock go away with the widget's realization.
+static void unrealize_cb(GtkWidget *widget, gpointer user_data) {
+  detach_frame_clock(static_cast<FrameGovernor *>(user_data));
+}
+
+static void connect_window_handlers(FrameGovernor *governor) {
+  if (governor->realize_handler_id != 0) {
+    return;
+  }
+  governor->realize_handler_id = g_signal_connect(
+      governor->window, "realize", G_CALLBACK(realize_cb), governor);
+  governor->unrealize_handler_id = g_signal_connect(
+      governor->window, "unrealize", G_CALLBACK(unrealize_cb), governor);
+}
+
+void frame_governor_init(FrameGovernor *governor, GtkWindow *window) {
+  *governor = {};
+  governor->window = window;
+  governor->policy = FRAME_POLICY_CONTINUOUS;
+  governor->stats_start = g_get_monotonic_time();
+}
+
+void frame_governor_clear(FrameGovernor *governor) {
+  if (governor->window == nullptr) {
+    return;
+  }
+  detach_frame_clock(governor);
+  if (governor->realize_handler_id != 0) {
+    g_signal_handler_disconnect(governor->window,
+                                governor->realize_handler_id);
+    g_signal_handler_disconnect(governor->window,
+                                governor->unrealize_handler_id);
+  }
+  governor->window = nullptr;
+}
+
+void frame_governor_set_policy(FrameGovernor *governor, FramePolicy policy,
+                               int fps_cap) {
+  governor->policy = policy;
+  governor->fps_cap = policy == FRAME_POLICY_CAPPED ? fps_cap : 0;
+  governor->frames = 0;
+  governor->held_frames = 0;
+  governor->stats_start = g_get_monotonic_time();
+
+  // While paused the policy only takes effect once resumed.
+  if (governor->paused) {
+    return;
+  }
+  if (policy == FRAME_POLICY_CONTINUOUS) {
+    detach_frame_clock(governor);
+    return;
+  }
+
+  // A held frame may have been waiting for a different interval or for a
+  // request that will no longer come.
+  release(governor);
+  connect_window_handlers(governor);
+  attach_frame_clock(governor);
+  if (policy == FRAME_POLICY_ON_DEMAND) {
+    hold(governor);
+  }
+}
+
+void frame_governor_set_paused(FrameGovernor *governor, gboolean paused) {
+  if (governor->paused == paused) {
+    return;
+  }
+  governor->paused = paused;
+
+  // Either way one frame goes through: the last one before pausing, or the
+  // first one after resuming, which also brings the policy back.
+  release(governor);
+  if (paused) {
+    connect_window_handlers(governor);
+    attach_frame_clock(governor);
+  }
+  gtk_widget_queue_draw(GTK_WIDGET(governor->window));
+}
+
+void frame_governor_request_frame(FrameGovernor *governor) {
+  if (governor->policy != FRAME_POLICY_ON_DEMAND) {
+    return;
+  }
+  release(governor);
+  gtk_widget_queue_draw(GTK_WIDGET(governor->window));
+}
+
+double frame_governor_achieved_fps(const FrameGovernor *governor) {
+  gint64 elapsed = g_get_monotonic_time() - governor->stats_start;
+  if (elapsed <= 0) {
+    return 0.0;
+  }
+  return governor->frames * static_cast<double>(G_USEC_PER_SEC) / elapsed;
+}
@@ -0,0 +1,70 @@
+#ifndef WAYLAND_LAYER_SHELL_FRAME_GOVERNOR_H_
+#define WAYLAND_LAYER_SHELL_FRAME_GOVERNOR_H_
+
+#include <gtk/gtk.h>
+
+// How often a window may present frames, matching the ShellRenderPolicy enum
+// on the Dart side.
+typedef enum {
+  // Every frame GTK paints is presented, up to the output refresh rate.
+  FRAME_POLICY_CONTINUOUS,
+  // At most FrameGovernor.fps_cap frames per second.
+  FRAME_POLICY_CAPPED,
+  // Only when frame_governor_request_frame() asks for one.
+  FRAME_POLICY_ON_DEMAND,
+} FramePolicy;
+
+// Throttles how often a window presents frames to the compositor.
+//
+// After each frame of the window's GdkFrameClock the governor freezes updates
+// on the GdkWindow, which keeps GTK from painting and committing the surface;
+// anything invalidated meanwhile is coalesced into the next frame. Capped
+// windows are thawed again once the frame interval has passed, on-demand
+// windows only when a frame is requested. An idle window costs no wakeups:
+// the timer only runs after a frame was actually painted.
+typedef struct {
+  GtkWindow *window;
+  FramePolicy policy;
+  int fps_cap;
+  GdkFrameClock *frame_clock;
+  gulong after_paint_handler_id;
+  gulong realize_handler_id;
+  gulong unrealize_handler_id;
+  // The GdkWindow whose updates the governor holds frozen, if any.
+  GdkWindow *frozen_window;
+  guint thaw_id;
+  // Holds every frame after the next one, whatever the policy.
+  gboolean paused;
+
+  // Frames painted since stats_start (monotonic time, in microseconds).
+  guint64 frames;
+  // Frames the governor held back from painting right away.
+  guint64 held_frames;
+  gint64 stats_start;
+} FrameGovernor;
+
+// Starts governing @window, initially with FRAME_POLICY_CONTINUOUS. Does not
+// take a reference; call frame_governor_clear() before the window goes away.
+void frame_governor_init(FrameGovernor *governor, GtkWindow *window);
+
+// Stops governing and lets any held frame through.
+void frame_governor_clear(FrameGovernor *governor);
+
+// Switches to @policy and restarts the statistics. @fps_cap is only used by
+// FRAME_POLICY_CAPPED and must be positive then.
+void frame_governor_set_policy(FrameGovernor *governor, FramePolicy policy,
+                               int fps_cap);
+
+// Lets one frame through in FRAME_POLICY_ON_DEMAND and makes sure the window
+// gets repainted. Does nothing in the other policies.
+void frame_governor_request_frame(FrameGovernor *governor);
+
+// Pauses or resumes presenting frames. Pausing lets one more frame through,
+// so the surface gets painted at its current size first, and holds all frames
+// after it until resumed.
+void frame_governor_set_paused(FrameGovernor *governor, gboolean paused);
+
+// Returns the frames per second painted since the statistics were restarted.
+double frame_governor_achieved_fps(const FrameGovernor *governor);
+
+#endif  // WAYLAND_LAYER_SHELL_FRAME_GOVERNOR_H_
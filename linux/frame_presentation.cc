@@ -0,0 +1,184 @@
+#include "frame_presentation.h"
+
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+#include <gdk/gdkwayland.h>
+#include <wayland-client.h>
+
+#include "presentation-time-client-protocol.h"
+#endif
+
+#include "plugin_log.h"
+#include "plugin_trace.h"
+#include "wayland_globals.h"
+
+struct _FramePresentation {
+  GtkWindow *window;
+  FramePresentedFunc presented_func;
+  gpointer user_data;
+  gboolean enabled;
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  struct wp_presentation *presentation;
+  clockid_t clock;
+  // Feedback requested for frames the compositor has not reported yet.
+  GPtrArray *pending;
+  gulong draw_handler_id;
+#endif
+};
+
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+
+typedef struct {
+  FramePresentation *owner;
+  struct wp_presentation_feedback *object;
+  gint64 paint_us;
+  GdkMonitor *monitor;
+} Feedback;
+
+static void feedback_free(gpointer data) {
+  Feedback *feedback = static_cast<Feedback *>(data);
+  wp_presentation_feedback_destroy(feedback->object);
+  g_free(feedback);
+}
+
+// Converts a wp_presentation timestamp to the monotonic clock GLib and
+// Flutter use.
+static gint64 to_monotonic_us(FramePresentation *self, guint64 seconds,
+                              guint32 nanoseconds) {
+  gint64 time_us = seconds * G_USEC_PER_SEC + nanoseconds / 1000;
+  if (self->clock == CLOCK_MONOTONIC) {
+    return time_us;
+  }
+  struct timespec now;
+  clock_gettime(self->clock, &now);
+  return time_us - (now.tv_sec * G_USEC_PER_SEC + now.tv_nsec / 1000) +
+         g_get_monotonic_time();
+}
+
+static void sync_output_cb(void *data,
+                           struct wp_presentation_feedback *object,
+                           struct wl_output *output) {
+  Feedback *feedback = static_cast<Feedback *>(data);
+  GdkDisplay *display =
+      gtk_widget_get_display(GTK_WIDGET(feedback->owner->window));
+  for (int i = 0; i < gdk_display_get_n_monitors(display); i++) {
+    GdkMonitor *monitor = gdk_display_get_monitor(display, i);
+    if (gdk_wayland_monitor_get_wl_output(monitor) == output) {
+      feedback->monitor = monitor;
+      return;
+    }
+  }
+}
+
+static void presented_cb(void *data, struct wp_presentation_feedback *object,
+                         uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                         uint32_t tv_nsec, uint32_t refresh, uint32_t seq_hi,
+                         uint32_t seq_lo, uint32_t flags) {
+  Feedback *feedback = static_cast<Feedback *>(data);
+  FramePresentation *self = feedback->owner;
+  PresentedFrame frame = {};
+  frame.presented = TRUE;
+  frame.time_us = to_monotonic_us(
+      self, (static_cast<guint64>(tv_sec_hi) << 32) | tv_sec_lo, tv_nsec);
+  frame.latency_us = frame.time_us - feedback->paint_us;
+  frame.refresh_ns = refresh;
+  frame.sequence = (static_cast<guint64>(seq_hi) << 32) | seq_lo;
+  frame.flags = flags;
+  frame.monitor = feedback->monitor;
+  PLUGIN_TRACE_INSTANT("frame_presented", "latency_us", frame.latency_us);
+  // Removing the feedback frees it.
+  g_ptr_array_remove(self->pending, feedback);
+  self->presented_func(&frame, self->user_data);
+}
+
+static void discarded_cb(void *data,
+                         struct wp_presentation_feedback *object) {
+  Feedback *feedback = static_cast<Feedback *>(data);
+  FramePresentation *self = feedback->owner;
+  PLUGIN_TRACE_INSTANT("frame_discarded");
+  g_ptr_array_remove(self->pending, feedback);
+  PresentedFrame frame = {};
+  self->presented_func(&frame, self->user_data);
+}
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+    sync_output_cb,
+    presented_cb,
+    discarded_cb,
+};
+
+// GTK paints the whole window from within the frame clock's paint phase and
+// commits the surface right after, so feedback requested here belongs to
+// this frame's commit.
+static gboolean draw_cb(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+  FramePresentation *self = static_cast<FramePresentation *>(user_data);
+  GdkWindow *gdk_window = gtk_widget_get_window(widget);
+  if (!self->enabled || gdk_window == nullptr ||
+      !GDK_IS_WAYLAND_WINDOW(gdk_window)) {
+    return FALSE;
+  }
+  struct wl_surface *surface = gdk_wayland_window_get_wl_surface(gdk_window);
+  if (surface == nullptr) {
+    return FALSE;
+  }
+
+  Feedback *feedback = g_new0(Feedback, 1);
+  feedback->owner = self;
+  feedback->object = wp_presentation_feedback(self->presentation, surface);
+  feedback->paint_us = g_get_monotonic_time();
+  wp_presentation_feedback_add_listener(feedback->object, &feedback_listener,
+                                        feedback);
+  g_ptr_array_add(self->pending, feedback);
+  return FALSE;
+}
+
+#endif  // WAYLAND_LAYER_SHELL_PROTOCOLS
+
+FramePresentation *frame_presentation_new(GtkWindow *window,
+                                          FramePresentedFunc presented_func,
+                                          gpointer user_data) {
+  FramePresentation *self = g_new0(FramePresentation, 1);
+  self->window = window;
+  self->presented_func = presented_func;
+  self->user_data = user_data;
+
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  const WaylandGlobals *globals =
+      wayland_globals_get(gtk_widget_get_display(GTK_WIDGET(window)));
+  self->presentation = globals->presentation;
+  self->clock = globals->presentation_clock;
+  self->pending = g_ptr_array_new_with_free_func(feedback_free);
+  if (self->presentation != nullptr) {
+    self->draw_handler_id =
+        g_signal_connect_after(window, "draw", G_CALLBACK(draw_cb), self);
+  }
+#endif
+
+  return self;
+}
+
+void frame_presentation_free(FramePresentation *self) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  if (self->draw_handler_id != 0) {
+    g_signal_handler_disconnect(self->window, self->draw_handler_id);
+  }
+  g_ptr_array_unref(self->pending);
+#endif
+  g_free(self);
+}
+
+gboolean frame_presentation_is_supported(FramePresentation *self) {
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+  return self->presentation != nullptr;
+#else
+  return FALSE;
+#endif
+}
+
+void frame_presentation_set_enabled(FramePresentation *self,
+                                    gboolean enabled) {
+  if (self->enabled == enabled) {
+    return;
+  }
+  self->enabled = enabled;
+  PLUGIN_LOG_D("Presentation feedback %s", enabled ? "enabled" : "disabled");
+}
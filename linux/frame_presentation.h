@@ -0,0 +1,58 @@
+#ifndef WAYLAND_LAYER_SHELL_FRAME_PRESENTATION_H_
+#define WAYLAND_LAYER_SHELL_FRAME_PRESENTATION_H_
+
+#include <gtk/gtk.h>
+
+// How one frame of the window reached the screen, or that it did not.
+typedef struct {
+  // FALSE if the compositor discarded the frame; the other fields are 0.
+  gboolean presented;
+  // When the frame turned into light, in g_get_monotonic_time() microseconds.
+  gint64 time_us;
+  // From painting the frame until @time_us.
+  gint64 latency_us;
+  // Nanoseconds until the next refresh of the output, 0 if unknown or
+  // variable.
+  guint32 refresh_ns;
+  // Vertical retrace counter of the output, 0 if it has none.
+  guint64 sequence;
+  // wp_presentation_feedback kind flags: vsync, hw_clock, hw_completion and
+  // zero_copy.
+  guint32 flags;
+  // The output the frame was presented on, or nullptr if unknown.
+  GdkMonitor *monitor;
+} PresentedFrame;
+
+typedef void (*FramePresentedFunc)(const PresentedFrame *frame,
+                                   gpointer user_data);
+
+// Reports when each frame GTK paints for a window is shown, through
+// wp_presentation.
+//
+// While enabled, a presentation feedback is requested with each frame the
+// window paints and reported once the compositor sends it, one frame or more
+// later. Feedback for frames that were never committed, e.g. because the
+// window was hidden, is dropped.
+//
+// Without wp_presentation (compositor or build) nothing is reported.
+typedef struct _FramePresentation FramePresentation;
+
+// Starts tracking @window, disabled. Does not take a reference; free the
+// tracker before the window goes away.
+FramePresentation *frame_presentation_new(GtkWindow *window,
+                                          FramePresentedFunc presented_func,
+                                          gpointer user_data);
+
+void frame_presentation_free(FramePresentation *frame_presentation);
+
+// Whether the compositor offers wp_presentation. FALSE when built without
+// protocol support.
+gboolean frame_presentation_is_supported(
+    FramePresentation *frame_presentation);
+
+// Starts or stops requesting feedback. Frames painted before stopping are
+// still reported.
+void frame_presentation_set_enabled(FramePresentation *frame_presentation,
+                                    gboolean enabled);
+
+#endif  // WAYLAND_LAYER_SHELL_FRAME_PRESENTATION_H_
@@ -0,0 +1,93 @@
+#ifndef FLUTTER_PLUGIN_WAYLAND_LAYER_SHELL_FFI_H_
+#define FLUTTER_PLUGIN_WAYLAND_LAYER_SHELL_FFI_H_
+
+// Plain C API of the plugin, for dart:ffi (see lib/src/ffi.dart).
+//
+// The functions act on the window of the first plugin instance, and may be
+// called from any thread, e.g. Flutter's UI thread:
+//  - Getters read a snapshot of the layer surface state that the GTK main
+//    thread publishes whenever the state changes, so they never touch GTK.
+//  - Setters update that snapshot right away, so a getter called afterwards
+//    sees the new value, and hand the change to the GTK main thread, where
+//    it goes through the same per-frame queue as the method channel setters.
+//
+// Enum values match the Dart ShellLayer, ShellEdge and ShellKeyboardMode
+// enums. Getters return -1 and setters 0 while no window is attached or when
+// an argument is out of range; setters return 1 otherwise. Margins and the
+// exclusive zone can be -1 themselves, so check
+// wayland_layer_shell_ffi_is_attached() before reading those.
+//
+// Everything that returns structured data or completes asynchronously
+// (initialize, the monitor list, animations, statistics) is only available
+// through the method channel.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef FLUTTER_PLUGIN_IMPL
+#define WAYLAND_LAYER_SHELL_FFI_EXPORT __attribute__((visibility("default")))
+#else
+#define WAYLAND_LAYER_SHELL_FFI_EXPORT
+#endif
+
+// Bumped whenever a function changes in an incompatible way.
+#define WAYLAND_LAYER_SHELL_FFI_ABI_VERSION 1
+
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_abi_version(void);
+
+// 1 once a window is attached.
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_is_attached(void);
+
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_is_supported(void);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_is_initialized(void);
+
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t wayland_layer_shell_ffi_get_layer(void);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_get_anchor(int32_t edge);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_get_margin(int32_t edge);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_get_exclusive_zone(void);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_is_auto_exclusive_zone_enabled(void);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_get_keyboard_mode(void);
+
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_set_layer(int32_t layer);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_set_anchor(int32_t edge, int32_t anchor_to_edge);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_set_margin(int32_t edge, int32_t margin_size);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_set_exclusive_zone(int32_t exclusive_zone);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_enable_auto_exclusive_zone(void);
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_set_keyboard_mode(int32_t keyboard_mode);
+// 0 leaves a dimension to the compositor, as setSize does.
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_set_size(int32_t width, int32_t height);
+// Moves the surface to the monitor with @id, as listed by getMonitorList, or
+// lets the compositor choose with -1. An id without a connected monitor is
+// only found out on the GTK main thread, which logs it and ignores the call.
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_set_monitor(int32_t id);
+// Shows the window, as showWindow does.
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t
+wayland_layer_shell_ffi_show_window(void);
+// Applies the queued changes without waiting for the next frame.
+WAYLAND_LAYER_SHELL_FFI_EXPORT int32_t wayland_layer_shell_ffi_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FLUTTER_PLUGIN_WAYLAND_LAYER_SHELL_FFI_H_
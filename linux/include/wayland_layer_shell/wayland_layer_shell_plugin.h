@@ -21,6 +21,61 @@ FLUTTER_PLUGIN_EXPORT GType wayland_layer_shell_plugin_get_type();
 FLUTTER_PLUGIN_EXPORT void wayland_layer_shell_plugin_register_with_registrar(
     FlPluginRegistrar* registrar);
 
+// Layer surface setup for wayland_layer_shell_bootstrap(). Enum values match
+// the Dart ShellLayer, ShellEdge and ShellKeyboardMode enums; per-edge arrays
+// are indexed by ShellEdge (left, right, top, bottom).
+typedef struct {
+  // Size request of the window, -1 to leave it unset.
+  int width;
+  int height;
+  int layer;
+  gboolean anchors[4];
+  int margins[4];
+  // Ignored while auto_exclusive_zone is set.
+  int exclusive_zone;
+  gboolean auto_exclusive_zone;
+  int keyboard_mode;
+  // Monitor.id, or a monitor model name; nullptr lets the compositor decide.
+  // Ids are assigned in the display's monitor order at startup, so 1 is the
+  // first monitor. Owned by the config, see wayland_layer_shell_config_clear().
+  gchar* monitor;
+} WaylandLayerShellConfig;
+
+// Fills @config with the defaults initialize() uses: top layer, anchored to
+// the left, right and bottom edges, no margins, auto exclusive zone and
+// on-demand keyboard focus.
+FLUTTER_PLUGIN_EXPORT void wayland_layer_shell_config_init(
+    WaylandLayerShellConfig* config);
+
+FLUTTER_PLUGIN_EXPORT void wayland_layer_shell_config_clear(
+    WaylandLayerShellConfig* config);
+
+// Applies the [layer-shell] group of the key file at @path to @config. Keys:
+//   width, height, layer (background|bottom|top|overlay),
+//   anchors (list of left|right|top|bottom), margins (left;right;top;bottom),
+//   exclusive-zone (a number or "auto"), keyboard-mode
+//   (none|exclusive|on-demand) and monitor.
+FLUTTER_PLUGIN_EXPORT gboolean wayland_layer_shell_config_load_file(
+    WaylandLayerShellConfig* config, const gchar* path, GError** error);
+
+// Applies the "--layer-shell-<key>=<value>" options in @args (e.g. the Dart
+// entrypoint arguments) to @config, using the keys of the config file, and
+// loads "--layer-shell-config=<path>" first if present. Other arguments are
+// ignored. Sets *@found to whether any such option was present.
+FLUTTER_PLUGIN_EXPORT gboolean wayland_layer_shell_config_load_args(
+    WaylandLayerShellConfig* config, gchar** args, gboolean* found,
+    GError** error);
+
+// Turns @window into a layer surface configured by @config, before the
+// Flutter engine starts, so its first frame already appears as a layer
+// surface. Call it before the window is realized. initialize() called from
+// Dart later adopts the surface as is.
+//
+// Returns FALSE, leaving the window untouched, if the compositor does not
+// support layer shell.
+FLUTTER_PLUGIN_EXPORT gboolean wayland_layer_shell_bootstrap(
+    GtkWindow* window, const WaylandLayerShellConfig* config);
+
 G_END_DECLS
 
 #endif  // FLUTTER_PLUGIN_WAYLAND_LAYER_SHELL_PLUGIN_H_
@@ -0,0 +1,268 @@
+#include "layer_animator.h"
+
+#include <cmath>
+
+double layer_easing_apply(LayerEasing easing, double t) {
+  switch (easing) {
+  case LAYER_EASING_EASE_IN:
+    return t * t * t;
+  case LAYER_EASING_EASE_OUT: {
+    double u = 1.0 - t;
+    return 1.0 - u * u * u;
+  }
+  case LAYER_EASING_EASE_IN_OUT:
+    if (t < 0.5) {
+      return 4.0 * t * t * t;
+    } else {
+      double u = -2.0 * t + 2.0;
+      return 1.0 - u * u * u / 2.0;
+    }
+  case LAYER_EASING_LINEAR:
+  default:
+    return t;
+  }
+}
+
+static void apply_margins(LayerAnimator *animator) {
+  for (int edge = 0; edge < animator->margins.count; edge++) {
+    layer_surface_queue_set_margin(
+        animator->queue, static_cast<GtkLayerShellEdge>(edge),
+        static_cast<int>(lround(animator->margins.current[edge])));
+  }
+  layer_surface_queue_flush(animator->queue);
+}
+
+static void apply_size(LayerAnimator *animator) {
+  layer_surface_queue_set_size(
+      animator->queue, static_cast<int>(lround(animator->size.current[0])),
+      static_cast<int>(lround(animator->size.current[1])));
+  layer_surface_queue_flush(animator->queue);
+}
+
+// Advances @tween to @frame_time. Returns TRUE once it reached its target.
+static gboolean tween_step(LayerTween *tween, gint64 frame_time) {
+  if (tween->start_time == 0) {
+    tween->start_time = frame_time;
+  }
+
+  double t = 1.0;
+  if (tween->duration > 0) {
+    t = CLAMP(static_cast<double>(frame_time - tween->start_time) /
+                  tween->duration,
+              0.0, 1.0);
+  }
+  double eased = layer_easing_apply(tween->easing, t);
+  for (int i = 0; i < tween->count; i++) {
+    tween->current[i] =
+        tween->from[i] + (tween->to[i] - tween->from[i]) * eased;
+  }
+  return t >= 1.0;
+}
+
+static void tween_jump_to_end(LayerTween *tween) {
+  for (int i = 0; i < tween->count; i++) {
+    tween->current[i] = tween->to[i];
+  }
+}
+
+static void tween_finish(LayerAnimator *animator, LayerTween *tween,
+                         gboolean cancelled) {
+  gint64 id = tween->id;
+  tween->id = 0;
+  if (id != 0 && animator->done_func != nullptr) {
+    animator->done_func(id, cancelled, animator->user_data);
+  }
+}
+
+static gboolean tick_cb(GtkWidget *widget, GdkFrameClock *frame_clock,
+                        gpointer user_data) {
+  LayerAnimator *animator = static_cast<LayerAnimator *>(user_data);
+  gint64 frame_time = gdk_frame_clock_get_frame_time(frame_clock);
+
+  if (animator->margins.id != 0) {
+    gboolean done = tween_step(&animator->margins, frame_time);
+    apply_margins(animator);
+    if (done) {
+      tween_finish(animator, &animator->margins, FALSE);
+    }
+  }
+  if (animator->size.id != 0) {
+    gboolean done = tween_step(&animator->size, frame_time);
+    apply_size(animator);
+    if (done) {
+      tween_finish(animator, &animator->size, FALSE);
+    }
+  }
+
+  if (animator->margins.id == 0 && animator->size.id == 0) {
+    animator->tick_id = 0;
+    return G_SOURCE_REMOVE;
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+// Without a mapped window there are no frames to animate on, so animations
+// jump to their target. Completion is still reported asynchronously, after
+// the caller has received the animation id.
+static gboolean finish_idle_cb(gpointer user_data) {
+  LayerAnimator *animator = static_cast<LayerAnimator *>(user_data);
+  animator->finish_idle_id = 0;
+  if (animator->margins.id != 0) {
+    tween_jump_to_end(&animator->margins);
+    apply_margins(animator);
+    tween_finish(animator, &animator->margins, FALSE);
+  }
+  if (animator->size.id != 0) {
+    tween_jump_to_end(&animator->size);
+    apply_size(animator);
+    tween_finish(animator, &animator->size, FALSE);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+// Animations in flight when the window unmaps would never see another frame;
+// they finish like ones started on an unmapped window.
+static void unmap_cb(GtkWidget *widget, gpointer user_data) {
+  LayerAnimator *animator = static_cast<LayerAnimator *>(user_data);
+  if (animator->tick_id != 0) {
+    gtk_widget_remove_tick_callback(widget, animator->tick_id);
+    animator->tick_id = 0;
+  }
+  if ((animator->margins.id != 0 || animator->size.id != 0) &&
+      animator->finish_idle_id == 0) {
+    animator->finish_idle_id = g_idle_add(finish_idle_cb, animator);
+  }
+}
+
+static void start(LayerAnimator *animator) {
+  GtkWidget *widget = GTK_WIDGET(animator->window);
+  if (!gtk_widget_get_mapped(widget)) {
+    if (animator->finish_idle_id == 0) {
+      animator->finish_idle_id = g_idle_add(finish_idle_cb, animator);
+    }
+    return;
+  }
+
+  if (animator->tick_id == 0) {
+    animator->tick_id =
+        gtk_widget_add_tick_callback(widget, tick_cb, animator, nullptr);
+  }
+}
+
+// Prepares @tween for a new animation. An animation already in flight is
+// reported as cancelled and the new one starts from where it currently is.
+static gboolean tween_restart(LayerAnimator *animator, LayerTween *tween,
+                              gint64 duration_ms, LayerEasing easing) {
+  gboolean in_flight = tween->id != 0;
+  tween_finish(animator, tween, TRUE);
+
+  tween->id = ++animator->next_id;
+  tween->start_time = 0;
+  tween->duration = duration_ms * 1000;
+  tween->easing = easing;
+  return in_flight;
+}
+
+void layer_animator_init(LayerAnimator *animator, GtkWindow *window,
+                         LayerSurfaceQueue *queue,
+                         LayerAnimationDoneFunc done_func, gpointer user_data) {
+  *animator = {};
+  animator->window = window;
+  animator->queue = queue;
+  animator->done_func = done_func;
+  animator->user_data = user_data;
+  animator->unmap_handler_id =
+      g_signal_connect(window, "unmap", G_CALLBACK(unmap_cb), animator);
+}
+
+void layer_animator_clear(LayerAnimator *animator) {
+  if (animator->window == nullptr) {
+    return;
+  }
+
+  if (animator->tick_id != 0) {
+    gtk_widget_remove_tick_callback(GTK_WIDGET(animator->window),
+                                    animator->tick_id);
+  }
+  if (animator->finish_idle_id != 0) {
+    g_source_remove(animator->finish_idle_id);
+  }
+  g_signal_handler_disconnect(animator->window, animator->unmap_handler_id);
+  *animator = {};
+}
+
+gint64 layer_animator_animate_margins(LayerAnimator *animator, const int *from,
+                                      guint from_mask, const int *to,
+                                      guint to_mask, gint64 duration_ms,
+                                      LayerEasing easing) {
+  LayerTween *tween = &animator->margins;
+  gboolean in_flight = tween_restart(animator, tween, duration_ms, easing);
+
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(animator->queue, &state);
+
+  tween->count = GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER;
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    double current = in_flight ? tween->current[edge] : state.margins[edge];
+    if (!in_flight && (from_mask & (1u << edge))) {
+      current = from[edge];
+    }
+    tween->from[edge] = current;
+    tween->current[edge] = current;
+    tween->to[edge] = (to_mask & (1u << edge)) ? to[edge] : current;
+  }
+
+  start(animator);
+  return tween->id;
+}
+
+gint64 layer_animator_animate_size(LayerAnimator *animator, const int *from,
+                                   const int *to, gint64 duration_ms,
+                                   LayerEasing easing) {
+  LayerTween *tween = &animator->size;
+  gboolean in_flight = tween_restart(animator, tween, duration_ms, easing);
+
+  // An unset size request (-1) starts from the allocated size instead.
+  GtkWidget *widget = GTK_WIDGET(animator->window);
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(animator->queue, &state);
+  int size[2] = {state.width, state.height};
+  if (size[0] < 0) {
+    size[0] = gtk_widget_get_allocated_width(widget);
+  }
+  if (size[1] < 0) {
+    size[1] = gtk_widget_get_allocated_height(widget);
+  }
+
+  tween->count = 2;
+  for (int i = 0; i < 2; i++) {
+    double current = in_flight ? tween->current[i] : size[i];
+    if (!in_flight && from != nullptr) {
+      current = from[i];
+    }
+    tween->from[i] = current;
+    tween->current[i] = current;
+    tween->to[i] = to[i];
+  }
+
+  start(animator);
+  return tween->id;
+}
+
+void layer_animator_cancel(LayerAnimator *animator) {
+  if (animator->tick_id != 0) {
+    gtk_widget_remove_tick_callback(GTK_WIDGET(animator->window),
+                                    animator->tick_id);
+    animator->tick_id = 0;
+  }
+  if (animator->finish_idle_id != 0) {
+    g_source_remove(animator->finish_idle_id);
+    animator->finish_idle_id = 0;
+  }
+  tween_finish(animator, &animator->margins, TRUE);
+  tween_finish(animator, &animator->size, TRUE);
+}
+
+void layer_animator_cancel_size(LayerAnimator *animator) {
+  tween_finish(animator, &animator->size, TRUE);
+}
@@ -0,0 +1,86 @@
+#ifndef WAYLAND_LAYER_SHELL_LAYER_ANIMATOR_H_
+#define WAYLAND_LAYER_SHELL_LAYER_ANIMATOR_H_
+
+#include <gtk/gtk.h>
+
+#include "layer_surface_queue.h"
+
+// Easing curves, matching the ShellEasing enum on the Dart side.
+typedef enum {
+  LAYER_EASING_LINEAR,
+  LAYER_EASING_EASE_IN,
+  LAYER_EASING_EASE_OUT,
+  LAYER_EASING_EASE_IN_OUT,
+} LayerEasing;
+
+// Interpolation of up to four values between two frame times.
+typedef struct {
+  gint64 id; // 0 when idle
+  gint64 start_time;
+  gint64 duration;
+  LayerEasing easing;
+  int count;
+  double from[GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER];
+  double to[GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER];
+  double current[GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER];
+} LayerTween;
+
+// Called when an animation reaches its target (@cancelled FALSE) or is
+// cancelled or replaced by a new animation (@cancelled TRUE).
+typedef void (*LayerAnimationDoneFunc)(gint64 id, gboolean cancelled,
+                                       gpointer user_data);
+
+// Animates the margins and the size request of a layer surface natively.
+//
+// The interpolation runs from a tick callback on the window's GdkFrameClock,
+// i.e. in the clock's update phase, so each frame sets the new values and
+// flushes them through the LayerSurfaceQueue in exactly one commit. Starting a
+// new animation while one is in flight retargets it from the current
+// interpolated value, so there is never a jump. Unmapping the window stops
+// the frames, so animations in flight then jump to their target.
+typedef struct {
+  GtkWindow *window;
+  LayerSurfaceQueue *queue;
+  LayerTween margins;
+  LayerTween size;
+  guint tick_id;
+  guint finish_idle_id;
+  gulong unmap_handler_id;
+  gint64 next_id;
+  LayerAnimationDoneFunc done_func;
+  gpointer user_data;
+} LayerAnimator;
+
+void layer_animator_init(LayerAnimator *animator, GtkWindow *window,
+                         LayerSurfaceQueue *queue,
+                         LayerAnimationDoneFunc done_func, gpointer user_data);
+
+// Stops all animations without reporting them.
+void layer_animator_clear(LayerAnimator *animator);
+
+// Animates the margin of each edge from @from to @to. Bit (1 << edge) of
+// @from_mask and @to_mask tells whether the edge has an entry: edges without
+// a @from entry start from the current margin, edges without a @to entry are
+// left alone. Margins may be negative. Returns the id reported to the done
+// callback.
+gint64 layer_animator_animate_margins(LayerAnimator *animator, const int *from,
+                                      guint from_mask, const int *to,
+                                      guint to_mask, gint64 duration_ms,
+                                      LayerEasing easing);
+
+// Animates the size request from @from to @to, both {width, height}. A null
+// @from starts from the current size request.
+gint64 layer_animator_animate_size(LayerAnimator *animator, const int *from,
+                                   const int *to, gint64 duration_ms,
+                                   LayerEasing easing);
+
+// Stops all animations where they are and reports them as cancelled.
+void layer_animator_cancel(LayerAnimator *animator);
+
+// Stops the size animation where it is and reports it as cancelled.
+void layer_animator_cancel_size(LayerAnimator *animator);
+
+// Exposed for unit testing.
+double layer_easing_apply(LayerEasing easing, double t);
+
+#endif  // WAYLAND_LAYER_SHELL_LAYER_ANIMATOR_H_
@@ -0,0 +1,151 @@
+#include "layer_presenter.h"
+
+#include "plugin_log.h"
+#include "plugin_trace.h"
+
+// Returns the height the compositor will give an unmapped surface in
+// @state, as well as it can be told before the first configure.
+static int estimate_height(GtkWindow *window, const LayerSurfaceState *state) {
+  if (state->height > 0) {
+    return state->height;
+  }
+  if (state->anchors[GTK_LAYER_SHELL_EDGE_TOP] &&
+      state->anchors[GTK_LAYER_SHELL_EDGE_BOTTOM]) {
+    GdkDisplay *display = gtk_widget_get_display(GTK_WIDGET(window));
+    GdkMonitor *monitor = state->monitor != nullptr
+                              ? state->monitor
+                              : gdk_display_get_monitor(display, 0);
+    if (monitor != nullptr) {
+      GdkRectangle geometry;
+      gdk_monitor_get_geometry(monitor, &geometry);
+      return geometry.height - state->margins[GTK_LAYER_SHELL_EDGE_TOP] -
+             state->margins[GTK_LAYER_SHELL_EDGE_BOTTOM];
+    }
+  }
+  int natural_height = 0;
+  gtk_widget_get_preferred_height(GTK_WIDGET(window), nullptr,
+                                  &natural_height);
+  return natural_height;
+}
+
+// Applies the off-screen state for a surface @height pixels high: anchored
+// to the bottom edge only and pushed just below it, at a fixed height so
+// dropping the top anchor does not resize it.
+static void move_out_of_sight(LayerPresenter *self, int height) {
+  LayerSurfaceState state = self->presented;
+  state.anchors[GTK_LAYER_SHELL_EDGE_TOP] = FALSE;
+  state.anchors[GTK_LAYER_SHELL_EDGE_BOTTOM] = TRUE;
+  state.margins[GTK_LAYER_SHELL_EDGE_BOTTOM] = -height;
+  state.height = height;
+  state.exclusive_zone = 0;
+  state.auto_exclusive_zone = FALSE;
+  state.keyboard_mode = GTK_LAYER_SHELL_KEYBOARD_MODE_NONE;
+  self->height = height;
+  layer_surface_queue_set_state(&self->window_state->queue, &state);
+  layer_surface_queue_flush(&self->window_state->queue);
+}
+
+// Follows the height the compositor actually configured, in case the
+// estimate was off or the content changed size.
+static gboolean configure_cb(GtkWidget *widget, GdkEvent *event,
+                             gpointer user_data) {
+  LayerPresenter *self = static_cast<LayerPresenter *>(user_data);
+  int height = event->configure.height;
+  if (height > 0 && height != self->height) {
+    PLUGIN_LOG_D("Prepared surface is %d pixels high", height);
+    move_out_of_sight(self, height);
+  }
+  return FALSE;
+}
+
+static void disconnect(LayerPresenter *self) {
+  if (self->configure_handler_id != 0) {
+    g_signal_handler_disconnect(self->window, self->configure_handler_id);
+    self->configure_handler_id = 0;
+  }
+}
+
+void layer_presenter_init(LayerPresenter *self, GtkWindow *window,
+                          LayerWindowState *window_state) {
+  *self = {};
+  self->window = window;
+  self->window_state = window_state;
+  self->keyboard_mode_before = -1;
+}
+
+void layer_presenter_clear(LayerPresenter *self) {
+  if (self->window == nullptr) {
+    return;
+  }
+  disconnect(self);
+  if (self->prepared) {
+    layer_surface_queue_hold(&self->window_state->queue, nullptr);
+    self->prepared = FALSE;
+  }
+  self->window = nullptr;
+}
+
+gboolean layer_presenter_prepare(LayerPresenter *self) {
+  if (self->window == nullptr || !gtk_layer_is_layer_window(self->window)) {
+    return FALSE;
+  }
+  if (self->prepared) {
+    return TRUE;
+  }
+  PLUGIN_TRACE_INSTANT("prepare");
+
+  LayerSurfaceQueue *queue = &self->window_state->queue;
+  layer_surface_queue_get_state(queue, &self->presented);
+  if (self->keyboard_mode_before >= 0) {
+    self->presented.keyboard_mode =
+        static_cast<GtkLayerShellKeyboardMode>(self->keyboard_mode_before);
+    self->keyboard_mode_before = -1;
+  }
+
+  GtkWidget *widget = GTK_WIDGET(self->window);
+  gboolean mapped = gtk_widget_get_mapped(widget);
+  int height = mapped ? gtk_widget_get_allocated_height(widget)
+                      : estimate_height(self->window, &self->presented);
+  self->prepared = TRUE;
+  self->was_prepared = TRUE;
+  layer_surface_queue_hold(queue, &self->presented);
+  move_out_of_sight(self, height);
+  self->configure_handler_id = g_signal_connect(
+      self->window, "configure-event", G_CALLBACK(configure_cb), self);
+  if (!mapped) {
+    gtk_widget_show(widget);
+  }
+  return TRUE;
+}
+
+gboolean layer_presenter_present(LayerPresenter *self,
+                                 gboolean exclusive_keyboard) {
+  if (!self->prepared) {
+    return FALSE;
+  }
+  PLUGIN_TRACE_INSTANT("present", "exclusive_keyboard", exclusive_keyboard);
+  disconnect(self);
+  self->prepared = FALSE;
+
+  LayerSurfaceState state = self->presented;
+  if (exclusive_keyboard &&
+      state.keyboard_mode != GTK_LAYER_SHELL_KEYBOARD_MODE_EXCLUSIVE) {
+    self->keyboard_mode_before = state.keyboard_mode;
+    state.keyboard_mode = GTK_LAYER_SHELL_KEYBOARD_MODE_EXCLUSIVE;
+  }
+  LayerSurfaceQueue *queue = &self->window_state->queue;
+  layer_surface_queue_set_state(queue, &state);
+  layer_surface_queue_flush(queue);
+  layer_surface_queue_hold(queue, nullptr);
+  // Anything the app changed while prepared was not painted yet.
+  gtk_widget_queue_draw(GTK_WIDGET(self->window));
+  return TRUE;
+}
+
+gboolean layer_presenter_dismiss(LayerPresenter *self) {
+  if (self->prepared || self->window == nullptr ||
+      !gtk_widget_get_mapped(GTK_WIDGET(self->window))) {
+    return FALSE;
+  }
+  return layer_presenter_prepare(self);
+}
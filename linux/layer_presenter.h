@@ -0,0 +1,62 @@
+#ifndef WAYLAND_LAYER_SHELL_LAYER_PRESENTER_H_
+#define WAYLAND_LAYER_SHELL_LAYER_PRESENTER_H_
+
+#include <gtk/gtk.h>
+
+#include "layer_window_state.h"
+
+// Keeps a layer surface mapped but out of sight, so it can be shown without
+// creating and configuring a new surface.
+//
+// A prepared surface is anchored to the bottom edge only and pushed just past
+// it with a negative margin, at its configured size, with no exclusive zone
+// and no keyboard interactivity. It stays mapped with its last frame
+// attached, so presenting it is a single commit that restores the anchors,
+// margins, size, exclusive zone and keyboard mode it had before; the size
+// does not change, so the compositor needs no new buffer. Compositors do not
+// send frame callbacks to a surface that is on no output, so a prepared
+// surface does not repaint either.
+//
+// The state to restore is held in the window's queue while prepared (see
+// layer_surface_queue_hold()), so layer surface setters called meanwhile,
+// from any source, change what present() commits instead of moving the
+// off-screen surface. Only the layer and monitor change right away.
+typedef struct {
+  GtkWindow *window;
+  LayerWindowState *window_state;
+
+  gboolean prepared;
+  // Whether the surface was ever prepared.
+  gboolean was_prepared;
+  // The state to restore on present, held in the queue while prepared.
+  LayerSurfaceState presented;
+  // Height the surface was moved out of sight with.
+  int height;
+  // Keyboard mode from before a present that took exclusive focus, restored
+  // when dismissed; -1 if the present did not change it.
+  int keyboard_mode_before;
+  gulong configure_handler_id;
+} LayerPresenter;
+
+void layer_presenter_init(LayerPresenter *presenter, GtkWindow *window,
+                          LayerWindowState *window_state);
+
+// Stops tracking the window, leaving the surface as it is. Setters act on the
+// surface again afterwards.
+void layer_presenter_clear(LayerPresenter *presenter);
+
+// Moves the surface out of sight, mapping it first if needed. Returns FALSE
+// if the window is not a layer surface.
+gboolean layer_presenter_prepare(LayerPresenter *presenter);
+
+// Brings a prepared surface back in one commit, with exclusive keyboard
+// interactivity if @exclusive_keyboard is TRUE. Returns FALSE if the surface
+// is not prepared.
+gboolean layer_presenter_present(LayerPresenter *presenter,
+                                 gboolean exclusive_keyboard);
+
+// Prepares a presented surface again. Returns FALSE if it is not mapped or
+// already prepared.
+gboolean layer_presenter_dismiss(LayerPresenter *presenter);
+
+#endif  // WAYLAND_LAYER_SHELL_LAYER_PRESENTER_H_
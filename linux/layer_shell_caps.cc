@@ -0,0 +1,35 @@
+#include "layer_shell_caps.h"
+
+#include <dlfcn.h>
+
+#include <gtk-layer-shell/gtk-layer-shell.h>
+
+#include "plugin_log.h"
+
+static gboolean probed;
+static LayerShellCaps caps;
+
+const LayerShellCaps *layer_shell_caps_get(void) {
+  if (probed) {
+    return &caps;
+  }
+  probed = TRUE;
+
+  caps.library_major = gtk_layer_get_major_version();
+  caps.library_minor = gtk_layer_get_minor_version();
+  caps.library_micro = gtk_layer_get_micro_version();
+  caps.protocol_version =
+      gtk_layer_is_supported() ? gtk_layer_get_protocol_version() : 0;
+  caps.layer_change_in_place = caps.protocol_version >= 2;
+  caps.on_demand_keyboard = caps.protocol_version >= 4;
+  // Looked up at runtime, so the plugin still builds and loads against
+  // gtk-layer-shell releases that predate it.
+  caps.exclusive_edge =
+      caps.protocol_version >= 5 &&
+      dlsym(RTLD_DEFAULT, "gtk_layer_set_exclusive_edge") != nullptr;
+
+  PLUGIN_LOG_I("gtk-layer-shell %u.%u.%u, zwlr_layer_shell_v1 version %u",
+               caps.library_major, caps.library_minor, caps.library_micro,
+               caps.protocol_version);
+  return &caps;
+}
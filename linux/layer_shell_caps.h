@@ -0,0 +1,30 @@
+#ifndef WAYLAND_LAYER_SHELL_LAYER_SHELL_CAPS_H_
+#define WAYLAND_LAYER_SHELL_LAYER_SHELL_CAPS_H_
+
+#include <gtk/gtk.h>
+
+// What gtk-layer-shell and the compositor's zwlr_layer_shell_v1 can do,
+// probed once per process.
+typedef struct {
+  // Version of the gtk-layer-shell library loaded at runtime.
+  guint library_major;
+  guint library_minor;
+  guint library_micro;
+  // Version of zwlr_layer_shell_v1 the compositor offers; 0 if it does not
+  // support the protocol.
+  guint protocol_version;
+  // Whether the layer of a mapped surface can change in place (version 2).
+  // Otherwise gtk-layer-shell remaps the surface for it.
+  gboolean layer_change_in_place;
+  // Whether GTK_LAYER_SHELL_KEYBOARD_MODE_ON_DEMAND is honored (version 4).
+  gboolean on_demand_keyboard;
+  // Whether the edge an exclusive zone applies to can be chosen (version 5
+  // and gtk_layer_set_exclusive_edge(), gtk-layer-shell 0.9).
+  gboolean exclusive_edge;
+} LayerShellCaps;
+
+// Returns the capabilities, probing them on first use. Call after GTK has
+// connected to the display.
+const LayerShellCaps *layer_shell_caps_get(void);
+
+#endif  // WAYLAND_LAYER_SHELL_LAYER_SHELL_CAPS_H_
@@ -0,0 +1,396 @@
+#include "layer_shell_ffi.h"
+
+#include "auto_hide.h"
+#include "include/wayland_layer_shell/wayland_layer_shell_ffi.h"
+#include "layer_window_state.h"
+#include "plugin_log.h"
+
+// The state the getters report. Written on the main thread when the queue
+// changes, and optimistically by the setters on the calling thread.
+typedef struct {
+  gboolean attached;
+  gboolean supported;
+  gboolean initialized;
+  LayerSurfaceState state;
+  // Setter calls not yet run on the main thread, per LAYER_FIELD_* bit. The
+  // queue does not know their values yet, so publishing keeps the optimistic
+  // ones for these fields.
+  guint in_flight[sizeof(guint) * 8];
+} FfiSnapshot;
+
+static GMutex snapshot_lock;
+static FfiSnapshot snapshot;
+
+// Main thread only.
+static GtkWindow *ffi_window;
+static MonitorRegistry *ffi_monitors;
+
+typedef enum {
+  FFI_CALL_SET_LAYER,
+  FFI_CALL_SET_ANCHOR,
+  FFI_CALL_SET_MARGIN,
+  FFI_CALL_SET_EXCLUSIVE_ZONE,
+  FFI_CALL_ENABLE_AUTO_EXCLUSIVE_ZONE,
+  FFI_CALL_SET_KEYBOARD_MODE,
+  FFI_CALL_SET_SIZE,
+  FFI_CALL_SET_MONITOR,
+  FFI_CALL_SHOW_WINDOW,
+  FFI_CALL_FLUSH,
+} FfiCallType;
+
+typedef struct {
+  FfiCallType type;
+  int a;
+  int b;
+  // The LAYER_FIELD_* bits the call changes.
+  guint fields;
+} FfiCall;
+
+// Adds @delta to the in-flight count of each of @fields. Call with the
+// snapshot locked.
+static void count_in_flight(guint fields, int delta) {
+  for (guint bit = 0; bit < G_N_ELEMENTS(snapshot.in_flight); bit++) {
+    if (fields & (1u << bit)) {
+      snapshot.in_flight[bit] += delta;
+    }
+  }
+}
+
+// Call with the snapshot locked.
+static gboolean is_in_flight(guint field) {
+  return snapshot.in_flight[g_bit_nth_lsf(field, -1)] > 0;
+}
+
+// Copies the snapshot's values of fields with calls in flight into @state.
+// Call with the snapshot locked.
+static void keep_in_flight(LayerSurfaceState *state) {
+  const LayerSurfaceState *optimistic = &snapshot.state;
+  if (is_in_flight(LAYER_FIELD_LAYER)) {
+    state->layer = optimistic->layer;
+  }
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    if (is_in_flight(LAYER_FIELD_ANCHOR << edge)) {
+      state->anchors[edge] = optimistic->anchors[edge];
+    }
+    if (is_in_flight(LAYER_FIELD_MARGIN << edge)) {
+      state->margins[edge] = optimistic->margins[edge];
+    }
+  }
+  if (is_in_flight(LAYER_FIELD_EXCLUSIVE_ZONE)) {
+    state->exclusive_zone = optimistic->exclusive_zone;
+  }
+  if (is_in_flight(LAYER_FIELD_AUTO_EXCLUSIVE_ZONE)) {
+    state->auto_exclusive_zone = optimistic->auto_exclusive_zone;
+  }
+  if (is_in_flight(LAYER_FIELD_KEYBOARD_MODE)) {
+    state->keyboard_mode = optimistic->keyboard_mode;
+  }
+  if (is_in_flight(LAYER_FIELD_SIZE)) {
+    state->width = optimistic->width;
+    state->height = optimistic->height;
+  }
+}
+
+static void publish(gpointer user_data) {
+  if (ffi_window == nullptr) {
+    return;
+  }
+  LayerWindowState *window_state = layer_window_state_get(ffi_window);
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(&window_state->queue, &state);
+
+  g_mutex_lock(&snapshot_lock);
+  snapshot.initialized = window_state->initialized;
+  keep_in_flight(&state);
+  snapshot.state = state;
+  g_mutex_unlock(&snapshot_lock);
+}
+
+// The automatic exclusive zone follows the surface size.
+static void size_allocate_cb(GtkWidget *widget, GdkRectangle *allocation,
+                             gpointer user_data) {
+  publish(nullptr);
+}
+
+static void window_destroy_cb(GtkWidget *widget, gpointer user_data) {
+  g_mutex_lock(&snapshot_lock);
+  snapshot.attached = FALSE;
+  g_mutex_unlock(&snapshot_lock);
+  ffi_window = nullptr;
+}
+
+void layer_shell_ffi_attach(GtkWindow *window) {
+  if (ffi_window != nullptr || window == nullptr) {
+    return;
+  }
+  ffi_window = window;
+  g_signal_connect(window, "destroy", G_CALLBACK(window_destroy_cb), nullptr);
+  g_signal_connect_after(window, "size-allocate", G_CALLBACK(size_allocate_cb),
+                         nullptr);
+  layer_surface_queue_add_changed_func(
+      &layer_window_state_get(window)->queue, publish, nullptr);
+
+  g_mutex_lock(&snapshot_lock);
+  snapshot.attached = TRUE;
+  snapshot.supported = gtk_layer_is_supported();
+  g_mutex_unlock(&snapshot_lock);
+  publish(nullptr);
+}
+
+static void run_call(const FfiCall *call) {
+  LayerWindowState *window_state = layer_window_state_get(ffi_window);
+  LayerSurfaceQueue *queue = &window_state->queue;
+  switch (call->type) {
+  case FFI_CALL_SET_LAYER:
+    layer_surface_queue_set_layer(queue,
+                                  static_cast<GtkLayerShellLayer>(call->a));
+    break;
+  case FFI_CALL_SET_ANCHOR:
+    layer_surface_queue_set_anchor(
+        queue, static_cast<GtkLayerShellEdge>(call->a), call->b);
+    break;
+  case FFI_CALL_SET_MARGIN:
+    layer_surface_queue_set_margin(
+        queue, static_cast<GtkLayerShellEdge>(call->a), call->b);
+    break;
+  case FFI_CALL_SET_EXCLUSIVE_ZONE:
+    layer_surface_queue_set_exclusive_zone(queue, call->a);
+    break;
+  case FFI_CALL_ENABLE_AUTO_EXCLUSIVE_ZONE:
+    layer_surface_queue_enable_auto_exclusive_zone(queue);
+    break;
+  case FFI_CALL_SET_KEYBOARD_MODE:
+    layer_surface_queue_set_keyboard_mode(
+        queue, static_cast<GtkLayerShellKeyboardMode>(call->a));
+    break;
+  case FFI_CALL_SET_SIZE:
+    // A hidden surface takes the size when it is revealed.
+    if (window_state->auto_hide == nullptr ||
+        !auto_hide_set_size(window_state->auto_hide, call->a, call->b)) {
+      layer_surface_queue_set_size(queue, call->a, call->b);
+    }
+    break;
+  case FFI_CALL_SET_MONITOR:
+    if (call->a == -1) {
+      layer_surface_queue_set_monitor(queue, nullptr);
+    } else {
+      const MonitorInfo *info =
+          ffi_monitors != nullptr
+              ? monitor_registry_lookup(ffi_monitors, call->a)
+              : nullptr;
+      if (info == nullptr) {
+        PLUGIN_LOG_W("Invalid monitor id: %d", call->a);
+        break;
+      }
+      layer_surface_queue_set_monitor(queue, info->monitor);
+    }
+    break;
+  case FFI_CALL_SHOW_WINDOW:
+    gtk_widget_show(GTK_WIDGET(ffi_window));
+    break;
+  case FFI_CALL_FLUSH:
+    layer_surface_queue_flush(queue);
+    break;
+  }
+}
+
+gboolean layer_shell_ffi_is_attached_to(GtkWindow *window) {
+  return window != nullptr && window == ffi_window;
+}
+
+void layer_shell_ffi_set_monitors(MonitorRegistry *monitors) {
+  ffi_monitors = monitors;
+}
+
+void layer_shell_ffi_drop_monitors(MonitorRegistry *monitors) {
+  if (ffi_monitors == monitors) {
+    ffi_monitors = nullptr;
+  }
+}
+
+static gboolean run_call_cb(gpointer user_data) {
+  const FfiCall *call = static_cast<const FfiCall *>(user_data);
+  if (ffi_window != nullptr) {
+    run_call(call);
+  }
+
+  // The queue has the value now (or dropped it, e.g. for a hidden surface),
+  // so the snapshot can follow it again.
+  g_mutex_lock(&snapshot_lock);
+  count_in_flight(call->fields, -1);
+  g_mutex_unlock(&snapshot_lock);
+  publish(nullptr);
+  return G_SOURCE_REMOVE;
+}
+
+// Runs a call on the main thread: right away when called from it, otherwise
+// from the main loop. The caller counted @fields as in flight.
+static int32_t post_call(FfiCallType type, int a, int b, guint fields) {
+  FfiCall *call = g_new(FfiCall, 1);
+  call->type = type;
+  call->a = a;
+  call->b = b;
+  call->fields = fields;
+  g_main_context_invoke_full(nullptr, G_PRIORITY_DEFAULT, run_call_cb, call,
+                             g_free);
+  return 1;
+}
+
+static gboolean valid_edge(int32_t edge) {
+  return edge >= 0 && edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER;
+}
+
+int32_t wayland_layer_shell_ffi_abi_version(void) {
+  return WAYLAND_LAYER_SHELL_FFI_ABI_VERSION;
+}
+
+int32_t wayland_layer_shell_ffi_is_attached(void) {
+  g_mutex_lock(&snapshot_lock);
+  int32_t result = snapshot.attached;
+  g_mutex_unlock(&snapshot_lock);
+  return result;
+}
+
+// Reads a field of the snapshot, or -1 while no window is attached.
+#define READ_SNAPSHOT(expression)                                              \
+  g_mutex_lock(&snapshot_lock);                                                \
+  int32_t result = snapshot.attached ? (expression) : -1;                      \
+  g_mutex_unlock(&snapshot_lock);                                              \
+  return result
+
+int32_t wayland_layer_shell_ffi_is_supported(void) {
+  READ_SNAPSHOT(snapshot.supported ? 1 : 0);
+}
+
+int32_t wayland_layer_shell_ffi_is_initialized(void) {
+  READ_SNAPSHOT(snapshot.initialized ? 1 : 0);
+}
+
+int32_t wayland_layer_shell_ffi_get_layer(void) {
+  READ_SNAPSHOT(snapshot.state.layer);
+}
+
+int32_t wayland_layer_shell_ffi_get_anchor(int32_t edge) {
+  if (!valid_edge(edge)) {
+    return -1;
+  }
+  READ_SNAPSHOT(snapshot.state.anchors[edge] ? 1 : 0);
+}
+
+int32_t wayland_layer_shell_ffi_get_margin(int32_t edge) {
+  if (!valid_edge(edge)) {
+    return -1;
+  }
+  READ_SNAPSHOT(snapshot.state.margins[edge]);
+}
+
+int32_t wayland_layer_shell_ffi_get_exclusive_zone(void) {
+  READ_SNAPSHOT(snapshot.state.exclusive_zone);
+}
+
+int32_t wayland_layer_shell_ffi_is_auto_exclusive_zone_enabled(void) {
+  READ_SNAPSHOT(snapshot.state.auto_exclusive_zone ? 1 : 0);
+}
+
+int32_t wayland_layer_shell_ffi_get_keyboard_mode(void) {
+  READ_SNAPSHOT(snapshot.state.keyboard_mode);
+}
+
+// Updates the snapshot with @statement and counts a call changing @fields as
+// in flight, unless no window is attached, in which case the setter returns 0.
+#define WRITE_SNAPSHOT(fields, statement)                                      \
+  do {                                                                         \
+    g_mutex_lock(&snapshot_lock);                                              \
+    gboolean attached = snapshot.attached;                                     \
+    if (attached) {                                                            \
+      statement;                                                               \
+      count_in_flight(fields, 1);                                              \
+    }                                                                          \
+    g_mutex_unlock(&snapshot_lock);                                            \
+    if (!attached) {                                                           \
+      return 0;                                                                \
+    }                                                                          \
+  } while (0)
+
+int32_t wayland_layer_shell_ffi_set_layer(int32_t layer) {
+  if (layer < 0 || layer >= GTK_LAYER_SHELL_LAYER_ENTRY_NUMBER) {
+    return 0;
+  }
+  WRITE_SNAPSHOT(LAYER_FIELD_LAYER,
+                 snapshot.state.layer = static_cast<GtkLayerShellLayer>(layer));
+  return post_call(FFI_CALL_SET_LAYER, layer, 0, LAYER_FIELD_LAYER);
+}
+
+int32_t wayland_layer_shell_ffi_set_anchor(int32_t edge,
+                                           int32_t anchor_to_edge) {
+  if (!valid_edge(edge)) {
+    return 0;
+  }
+  WRITE_SNAPSHOT(LAYER_FIELD_ANCHOR << edge,
+                 snapshot.state.anchors[edge] = anchor_to_edge != 0);
+  return post_call(FFI_CALL_SET_ANCHOR, edge, anchor_to_edge != 0,
+                   LAYER_FIELD_ANCHOR << edge);
+}
+
+int32_t wayland_layer_shell_ffi_set_margin(int32_t edge, int32_t margin_size) {
+  if (!valid_edge(edge)) {
+    return 0;
+  }
+  WRITE_SNAPSHOT(LAYER_FIELD_MARGIN << edge,
+                 snapshot.state.margins[edge] = margin_size);
+  return post_call(FFI_CALL_SET_MARGIN, edge, margin_size,
+                   LAYER_FIELD_MARGIN << edge);
+}
+
+int32_t wayland_layer_shell_ffi_set_exclusive_zone(int32_t exclusive_zone) {
+  const guint fields =
+      LAYER_FIELD_EXCLUSIVE_ZONE | LAYER_FIELD_AUTO_EXCLUSIVE_ZONE;
+  WRITE_SNAPSHOT(fields, snapshot.state.exclusive_zone = exclusive_zone;
+                 snapshot.state.auto_exclusive_zone = FALSE);
+  return post_call(FFI_CALL_SET_EXCLUSIVE_ZONE, exclusive_zone, 0, fields);
+}
+
+int32_t wayland_layer_shell_ffi_enable_auto_exclusive_zone(void) {
+  WRITE_SNAPSHOT(LAYER_FIELD_AUTO_EXCLUSIVE_ZONE,
+                 snapshot.state.auto_exclusive_zone = TRUE);
+  return post_call(FFI_CALL_ENABLE_AUTO_EXCLUSIVE_ZONE, 0, 0,
+                   LAYER_FIELD_AUTO_EXCLUSIVE_ZONE);
+}
+
+int32_t wayland_layer_shell_ffi_set_keyboard_mode(int32_t keyboard_mode) {
+  if (keyboard_mode < 0 ||
+      keyboard_mode >= GTK_LAYER_SHELL_KEYBOARD_MODE_ENTRY_NUMBER) {
+    return 0;
+  }
+  WRITE_SNAPSHOT(LAYER_FIELD_KEYBOARD_MODE,
+                 snapshot.state.keyboard_mode =
+                     static_cast<GtkLayerShellKeyboardMode>(keyboard_mode));
+  return post_call(FFI_CALL_SET_KEYBOARD_MODE, keyboard_mode, 0,
+                   LAYER_FIELD_KEYBOARD_MODE);
+}
+
+int32_t wayland_layer_shell_ffi_set_size(int32_t width, int32_t height) {
+  width = width > 0 ? width : -1;
+  height = height > 0 ? height : -1;
+  WRITE_SNAPSHOT(LAYER_FIELD_SIZE, snapshot.state.width = width;
+                 snapshot.state.height = height);
+  return post_call(FFI_CALL_SET_SIZE, width, height, LAYER_FIELD_SIZE);
+}
+
+int32_t wayland_layer_shell_ffi_set_monitor(int32_t id) {
+  if (id != -1 && id <= 0) {
+    return 0;
+  }
+  WRITE_SNAPSHOT(0, static_cast<void>(0));
+  return post_call(FFI_CALL_SET_MONITOR, id, 0, 0);
+}
+
+int32_t wayland_layer_shell_ffi_show_window(void) {
+  WRITE_SNAPSHOT(0, static_cast<void>(0));
+  return post_call(FFI_CALL_SHOW_WINDOW, 0, 0, 0);
+}
+
+int32_t wayland_layer_shell_ffi_flush(void) {
+  WRITE_SNAPSHOT(0, static_cast<void>(0));
+  return post_call(FFI_CALL_FLUSH, 0, 0, 0);
+}
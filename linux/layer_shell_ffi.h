@@ -0,0 +1,25 @@
+#ifndef WAYLAND_LAYER_SHELL_LAYER_SHELL_FFI_H_
+#define WAYLAND_LAYER_SHELL_LAYER_SHELL_FFI_H_
+
+#include <gtk/gtk.h>
+
+#include "monitor_registry.h"
+
+// Makes @window the window the C API in wayland_layer_shell_ffi.h acts on,
+// unless one is attached already, and publishes its state. Main thread only.
+// The window is detached again when it is destroyed.
+void layer_shell_ffi_attach(GtkWindow *window);
+
+// Returns whether @window is the window the C API acts on. Main thread only.
+gboolean layer_shell_ffi_is_attached_to(GtkWindow *window);
+
+// Makes wayland_layer_shell_ffi_set_monitor() resolve ids through @monitors,
+// the registry of the plugin instance whose window is attached, so the ids
+// are the ones Dart got from that instance. Main thread only.
+void layer_shell_ffi_set_monitors(MonitorRegistry *monitors);
+
+// Stops using @monitors, if it is the registry in use, before it is freed.
+// Main thread only.
+void layer_shell_ffi_drop_monitors(MonitorRegistry *monitors);
+
+#endif  // WAYLAND_LAYER_SHELL_LAYER_SHELL_FFI_H_
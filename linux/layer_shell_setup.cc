@@ -0,0 +1,326 @@
+#include "layer_shell_setup.h"
+
+#include <gtk-layer-shell/gtk-layer-shell.h>
+
+#include <cstring>
+
+#include "layer_window_state.h"
+#include "plugin_log.h"
+
+static const gchar *kConfigGroup = "layer-shell";
+static const gchar *kArgPrefix = "--layer-shell-";
+
+static const gchar *layer_names[] = {"background", "bottom", "top", "overlay"};
+static const gchar *edge_names[] = {"left", "right", "top", "bottom"};
+static const gchar *keyboard_mode_names[] = {"none", "exclusive", "on-demand"};
+
+// Returns the index of @value in @names, or -1.
+static int parse_name(const gchar *value, const gchar **names, int count) {
+  for (int i = 0; i < count; i++) {
+    if (g_ascii_strcasecmp(value, names[i]) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static gboolean parse_int(const gchar *key, const gchar *value, int *result,
+                          GError **error) {
+  gchar *end = nullptr;
+  gint64 number = g_ascii_strtoll(value, &end, 10);
+  if (end == value || *end != '\0' || number < G_MININT ||
+      number > G_MAXINT) {
+    g_set_error(error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+                "Invalid %s: %s", key, value);
+    return FALSE;
+  }
+  *result = static_cast<int>(number);
+  return TRUE;
+}
+
+static gboolean bad_value(const gchar *key, const gchar *value,
+                          GError **error) {
+  g_set_error(error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+              "Invalid %s: %s", key, value);
+  return FALSE;
+}
+
+gboolean layer_shell_config_set(WaylandLayerShellConfig *config,
+                                const gchar *key, const gchar *value,
+                                GError **error) {
+  if (strcmp(key, "width") == 0) {
+    return parse_int(key, value, &config->width, error);
+  }
+  if (strcmp(key, "height") == 0) {
+    return parse_int(key, value, &config->height, error);
+  }
+  if (strcmp(key, "layer") == 0) {
+    int layer = parse_name(value, layer_names, G_N_ELEMENTS(layer_names));
+    if (layer < 0) {
+      return bad_value(key, value, error);
+    }
+    config->layer = layer;
+    return TRUE;
+  }
+  if (strcmp(key, "anchors") == 0) {
+    g_auto(GStrv) edges = g_strsplit_set(value, ",;", -1);
+    gboolean anchors[G_N_ELEMENTS(config->anchors)] = {};
+    for (gchar **edge = edges; *edge != nullptr; edge++) {
+      g_strstrip(*edge);
+      if (**edge == '\0') {
+        continue;
+      }
+      int index = parse_name(*edge, edge_names, G_N_ELEMENTS(edge_names));
+      if (index < 0) {
+        return bad_value(key, value, error);
+      }
+      anchors[index] = TRUE;
+    }
+    memcpy(config->anchors, anchors, sizeof(anchors));
+    return TRUE;
+  }
+  if (strcmp(key, "margins") == 0) {
+    g_auto(GStrv) margins = g_strsplit_set(value, ",;", -1);
+    if (g_strv_length(margins) != G_N_ELEMENTS(config->margins)) {
+      return bad_value(key, value, error);
+    }
+    int parsed[G_N_ELEMENTS(config->margins)];
+    for (size_t i = 0; i < G_N_ELEMENTS(parsed); i++) {
+      if (!parse_int(key, g_strstrip(margins[i]), &parsed[i], error)) {
+        return FALSE;
+      }
+    }
+    memcpy(config->margins, parsed, sizeof(parsed));
+    return TRUE;
+  }
+  if (strcmp(key, "exclusive-zone") == 0) {
+    if (g_ascii_strcasecmp(value, "auto") == 0) {
+      config->auto_exclusive_zone = TRUE;
+      return TRUE;
+    }
+    config->auto_exclusive_zone = FALSE;
+    return parse_int(key, value, &config->exclusive_zone, error);
+  }
+  if (strcmp(key, "keyboard-mode") == 0) {
+    int mode = parse_name(value, keyboard_mode_names,
+                          G_N_ELEMENTS(keyboard_mode_names));
+    if (mode < 0) {
+      return bad_value(key, value, error);
+    }
+    config->keyboard_mode = mode;
+    return TRUE;
+  }
+  if (strcmp(key, "monitor") == 0) {
+    g_free(config->monitor);
+    config->monitor = g_strdup(value);
+    return TRUE;
+  }
+
+  g_set_error(error, G_OPTION_ERROR, G_OPTION_ERROR_UNKNOWN_OPTION,
+              "Unknown layer shell option: %s", key);
+  return FALSE;
+}
+
+// Finds the monitor @spec names: a Monitor.id (optionally followed by ":" and
+// anything, as in Monitor.toString()) or a model name.
+static GdkMonitor *find_monitor(GdkDisplay *display, const gchar *spec) {
+  gchar *end = nullptr;
+  gint64 id = g_ascii_strtoll(spec, &end, 10);
+  if (end != spec && (*end == '\0' || *end == ':')) {
+    // The monitor registry numbers the monitors present at startup in
+    // display order, starting at 1.
+    if (id < 1 || id > gdk_display_get_n_monitors(display)) {
+      return nullptr;
+    }
+    return gdk_display_get_monitor(display, static_cast<int>(id - 1));
+  }
+
+  for (int i = 0; i < gdk_display_get_n_monitors(display); i++) {
+    GdkMonitor *monitor = gdk_display_get_monitor(display, i);
+    if (g_strcmp0(gdk_monitor_get_model(monitor), spec) == 0) {
+      return monitor;
+    }
+  }
+  return nullptr;
+}
+
+void layer_shell_setup(GtkWindow *window, const WaylandLayerShellConfig *config,
+                       GdkMonitor *monitor) {
+  if (config->width >= 0 || config->height >= 0) {
+    gtk_widget_set_size_request(GTK_WIDGET(window), config->width,
+                                config->height);
+  }
+
+  // Remove decorations for layer shell
+  gtk_window_set_decorated(window, FALSE);
+
+  // Initialize layer shell for this specific window
+  gtk_layer_init_for_window(window);
+
+  // Set layer shell properties IMMEDIATELY after initialization
+  gtk_layer_set_layer(window, static_cast<GtkLayerShellLayer>(config->layer));
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    gtk_layer_set_anchor(window, static_cast<GtkLayerShellEdge>(edge),
+                         config->anchors[edge]);
+    gtk_layer_set_margin(window, static_cast<GtkLayerShellEdge>(edge),
+                         config->margins[edge]);
+  }
+  if (config->auto_exclusive_zone) {
+    gtk_layer_auto_exclusive_zone_enable(window);
+  } else {
+    gtk_layer_set_exclusive_zone(window, config->exclusive_zone);
+  }
+  gtk_layer_set_keyboard_mode(
+      window, static_cast<GtkLayerShellKeyboardMode>(config->keyboard_mode));
+  if (monitor != nullptr) {
+    gtk_layer_set_monitor(window, monitor);
+  }
+
+  // Mark this window as initialized and take the state set above as the
+  // starting point of its shadow state
+  LayerWindowState *window_state = layer_window_state_get(window);
+  window_state->initialized = TRUE;
+  layer_surface_queue_sync(&window_state->queue);
+
+  PLUGIN_LOG_I("Initialized layer shell for window %p", window);
+}
+
+void layer_shell_config_from_state(WaylandLayerShellConfig *config,
+                                   const LayerSurfaceState *state) {
+  wayland_layer_shell_config_init(config);
+  config->width = state->width;
+  config->height = state->height;
+  config->layer = state->layer;
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    config->anchors[edge] = state->anchors[edge];
+    config->margins[edge] = state->margins[edge];
+  }
+  config->exclusive_zone = state->exclusive_zone;
+  config->auto_exclusive_zone = state->auto_exclusive_zone;
+  config->keyboard_mode = state->keyboard_mode;
+}
+
+void layer_shell_config_queue(LayerSurfaceQueue *queue,
+                              const WaylandLayerShellConfig *config) {
+  layer_surface_queue_set_layer(queue,
+                                static_cast<GtkLayerShellLayer>(config->layer));
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    layer_surface_queue_set_anchor(queue, static_cast<GtkLayerShellEdge>(edge),
+                                   config->anchors[edge]);
+    layer_surface_queue_set_margin(queue, static_cast<GtkLayerShellEdge>(edge),
+                                   config->margins[edge]);
+  }
+  if (config->auto_exclusive_zone) {
+    layer_surface_queue_enable_auto_exclusive_zone(queue);
+  } else {
+    layer_surface_queue_set_exclusive_zone(queue, config->exclusive_zone);
+  }
+  layer_surface_queue_set_keyboard_mode(
+      queue, static_cast<GtkLayerShellKeyboardMode>(config->keyboard_mode));
+  layer_surface_queue_set_size(queue, config->width, config->height);
+}
+
+void wayland_layer_shell_config_init(WaylandLayerShellConfig *config) {
+  *config = {};
+  config->width = -1;
+  config->height = -1;
+  config->layer = GTK_LAYER_SHELL_LAYER_TOP;
+  config->anchors[GTK_LAYER_SHELL_EDGE_LEFT] = TRUE;
+  config->anchors[GTK_LAYER_SHELL_EDGE_RIGHT] = TRUE;
+  config->anchors[GTK_LAYER_SHELL_EDGE_BOTTOM] = TRUE;
+  config->auto_exclusive_zone = TRUE;
+  config->keyboard_mode = GTK_LAYER_SHELL_KEYBOARD_MODE_ON_DEMAND;
+}
+
+void wayland_layer_shell_config_clear(WaylandLayerShellConfig *config) {
+  g_clear_pointer(&config->monitor, g_free);
+}
+
+gboolean wayland_layer_shell_config_load_file(WaylandLayerShellConfig *config,
+                                              const gchar *path,
+                                              GError **error) {
+  g_autoptr(GKeyFile) key_file = g_key_file_new();
+  if (!g_key_file_load_from_file(key_file, path, G_KEY_FILE_NONE, error)) {
+    return FALSE;
+  }
+
+  g_auto(GStrv) keys =
+      g_key_file_get_keys(key_file, kConfigGroup, nullptr, error);
+  if (keys == nullptr) {
+    return FALSE;
+  }
+  for (gchar **key = keys; *key != nullptr; key++) {
+    g_autofree gchar *value =
+        g_key_file_get_value(key_file, kConfigGroup, *key, error);
+    if (value == nullptr ||
+        !layer_shell_config_set(config, *key, value, error)) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+gboolean wayland_layer_shell_config_load_args(WaylandLayerShellConfig *config,
+                                              gchar **args, gboolean *found,
+                                              GError **error) {
+  *found = FALSE;
+  if (args == nullptr) {
+    return TRUE;
+  }
+
+  // The config file goes first so the other options can override it.
+  for (gchar **arg = args; *arg != nullptr; arg++) {
+    if (g_str_has_prefix(*arg, "--layer-shell-config=")) {
+      *found = TRUE;
+      if (!wayland_layer_shell_config_load_file(
+              config, strchr(*arg, '=') + 1, error)) {
+        return FALSE;
+      }
+    }
+  }
+
+  for (gchar **arg = args; *arg != nullptr; arg++) {
+    if (!g_str_has_prefix(*arg, kArgPrefix) ||
+        g_str_has_prefix(*arg, "--layer-shell-config=")) {
+      continue;
+    }
+    const gchar *option = *arg + strlen(kArgPrefix);
+    const gchar *equals = strchr(option, '=');
+    if (equals == nullptr) {
+      g_set_error(error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
+                  "Missing value for %s", *arg);
+      return FALSE;
+    }
+    *found = TRUE;
+    g_autofree gchar *key = g_strndup(option, equals - option);
+    if (!layer_shell_config_set(config, key, equals + 1, error)) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+gboolean wayland_layer_shell_bootstrap(GtkWindow *window,
+                                       const WaylandLayerShellConfig *config) {
+  plugin_log_init();
+
+  if (!gtk_layer_is_supported()) {
+    PLUGIN_LOG_W("Layer shell not supported, not bootstrapping");
+    return FALSE;
+  }
+  if (gtk_widget_get_realized(GTK_WIDGET(window))) {
+    PLUGIN_LOG_W("Bootstrapping a window that is already realized");
+  }
+
+  GdkMonitor *monitor = nullptr;
+  if (config->monitor != nullptr) {
+    monitor = find_monitor(gtk_widget_get_display(GTK_WIDGET(window)),
+                           config->monitor);
+    if (monitor == nullptr) {
+      PLUGIN_LOG_W("Unknown monitor: %s", config->monitor);
+    }
+  }
+
+  layer_shell_setup(window, config, monitor);
+  return TRUE;
+}
@@ -0,0 +1,32 @@
+#ifndef WAYLAND_LAYER_SHELL_LAYER_SHELL_SETUP_H_
+#define WAYLAND_LAYER_SHELL_LAYER_SHELL_SETUP_H_
+
+#include <gtk/gtk.h>
+
+#include "include/wayland_layer_shell/wayland_layer_shell_plugin.h"
+#include "layer_surface_queue.h"
+
+// Turns @window into a layer surface configured by @config, placed on
+// @monitor (nullptr lets the compositor decide), and marks it initialized.
+// Shared by initialize() and wayland_layer_shell_bootstrap(); @config->monitor
+// is not looked at.
+void layer_shell_setup(GtkWindow *window, const WaylandLayerShellConfig *config,
+                       GdkMonitor *monitor);
+
+// Applies one key of the config file format to @config (see
+// wayland_layer_shell_config_load_file()). Lists may be separated by ',' or
+// ';'.
+gboolean layer_shell_config_set(WaylandLayerShellConfig *config,
+                                const gchar *key, const gchar *value,
+                                GError **error);
+
+// Fills @config with @state, leaving the monitor unset.
+void layer_shell_config_from_state(WaylandLayerShellConfig *config,
+                                   const LayerSurfaceState *state);
+
+// Queues the changes that take the surface to @config on @queue, apart from
+// the monitor. Fields that already match are elided by the queue.
+void layer_shell_config_queue(LayerSurfaceQueue *queue,
+                              const WaylandLayerShellConfig *config);
+
+#endif  // WAYLAND_LAYER_SHELL_LAYER_SHELL_SETUP_H_
@@ -0,0 +1,505 @@
+#include "layer_surface_queue.h"
+
+#include "layer_shell_caps.h"
+#include "plugin_log.h"
+#include "plugin_trace.h"
+
+// The state of a window before it becomes a layer surface, matching the
+// gtk-layer-shell defaults.
+static void default_state(LayerSurfaceState *state) {
+  *state = {};
+  state->layer = GTK_LAYER_SHELL_LAYER_TOP;
+}
+
+static void read_state(GtkWindow *window, LayerSurfaceState *state) {
+  // Before initialize the window has no layer surface to query; report the
+  // gtk-layer-shell defaults instead of tripping its warnings.
+  if (!gtk_layer_is_layer_window(window)) {
+    default_state(state);
+    gtk_widget_get_size_request(GTK_WIDGET(window), &state->width,
+                                &state->height);
+    return;
+  }
+
+  state->layer = gtk_layer_get_layer(window);
+  state->monitor = gtk_layer_get_monitor(window);
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    state->anchors[edge] =
+        gtk_layer_get_anchor(window, static_cast<GtkLayerShellEdge>(edge));
+    state->margins[edge] =
+        gtk_layer_get_margin(window, static_cast<GtkLayerShellEdge>(edge));
+  }
+  state->exclusive_zone = gtk_layer_get_exclusive_zone(window);
+  state->auto_exclusive_zone = gtk_layer_auto_exclusive_zone_is_enabled(window);
+  state->keyboard_mode = gtk_layer_get_keyboard_mode(window);
+  gtk_widget_get_size_request(GTK_WIDGET(window), &state->width,
+                              &state->height);
+}
+
+// Returns the LAYER_FIELD_* bits of the changes in @dirty that gtk-layer-shell
+// can only make by remapping the mapped surface.
+static guint remap_fields(const LayerSurfaceQueue *queue, guint dirty) {
+  guint fields = 0;
+  if ((dirty & LAYER_FIELD_MONITOR) &&
+      queue->pending.monitor != queue->applied.monitor) {
+    fields |= LAYER_FIELD_MONITOR;
+  }
+  if ((dirty & LAYER_FIELD_LAYER) &&
+      queue->pending.layer != queue->applied.layer &&
+      !layer_shell_caps_get()->layer_change_in_place) {
+    fields |= LAYER_FIELD_LAYER;
+  }
+  return fields;
+}
+
+static void remap_marshal(GHook *hook, gpointer marshal_data) {
+  reinterpret_cast<LayerSurfaceQueueRemapFunc>(hook->func)(
+      GPOINTER_TO_UINT(marshal_data), hook->data);
+}
+
+// Applies the pending changes to gtk-layer-shell. Updates on the GdkWindow are
+// frozen meanwhile, so the commits requested by the individual setters end up
+// in one repaint. Changes that need a remap are applied while the window is
+// unmapped, so the surface is remapped once and created in its final state.
+static void apply_pending(LayerSurfaceQueue *queue) {
+  if (queue->dirty == 0) {
+    return;
+  }
+
+  GtkWindow *window = queue->window;
+  GtkWidget *widget = GTK_WIDGET(window);
+  // A copy, since unmapping below runs signal handlers that may call the
+  // setters again.
+  const LayerSurfaceState pending_copy = queue->pending;
+  const LayerSurfaceState *pending = &pending_copy;
+  guint dirty = queue->dirty;
+  queue->dirty = 0;
+  guint64 trace_start = PLUGIN_TRACE_BEGIN();
+
+  gboolean mapped = gtk_widget_get_mapped(widget);
+  guint remap = mapped && gtk_layer_is_layer_window(window)
+                    ? remap_fields(queue, dirty)
+                    : 0;
+  GdkWindow *gdk_window =
+      remap == 0 ? gtk_widget_get_window(widget) : nullptr;
+  if (gdk_window != nullptr) {
+    gdk_window_freeze_updates(gdk_window);
+  }
+  if (remap != 0) {
+    PLUGIN_LOG_D("Remapping the surface, changed fields 0x%x", remap);
+    queue->applied = *pending;
+    gtk_widget_hide(widget);
+  }
+
+  if (dirty & LAYER_FIELD_LAYER) {
+    gtk_layer_set_layer(window, pending->layer);
+  }
+  if (dirty & LAYER_FIELD_MONITOR) {
+    gtk_layer_set_monitor(window, pending->monitor);
+  }
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    if (dirty & (LAYER_FIELD_ANCHOR << edge)) {
+      gtk_layer_set_anchor(window, static_cast<GtkLayerShellEdge>(edge),
+                           pending->anchors[edge]);
+    }
+    if (dirty & (LAYER_FIELD_MARGIN << edge)) {
+      gtk_layer_set_margin(window, static_cast<GtkLayerShellEdge>(edge),
+                           pending->margins[edge]);
+    }
+  }
+  if (dirty & LAYER_FIELD_EXCLUSIVE_ZONE) {
+    gtk_layer_set_exclusive_zone(window, pending->exclusive_zone);
+  }
+  if (dirty & LAYER_FIELD_AUTO_EXCLUSIVE_ZONE) {
+    gtk_layer_auto_exclusive_zone_enable(window);
+  }
+  if (dirty & LAYER_FIELD_KEYBOARD_MODE) {
+    gtk_layer_set_keyboard_mode(window, pending->keyboard_mode);
+  }
+  if (dirty & LAYER_FIELD_SIZE) {
+    gtk_widget_set_size_request(GTK_WIDGET(window), pending->width,
+                                pending->height);
+    // A window never shrinks below its current size on its own; asking for
+    // the smallest size lets it settle at the request (or its content).
+    gtk_window_resize(window, MAX(pending->width, 1), MAX(pending->height, 1));
+  }
+
+  if (gdk_window != nullptr) {
+    gdk_window_thaw_updates(gdk_window);
+  }
+  if (remap != 0) {
+    gtk_widget_show(widget);
+  }
+  queue->applied = *pending;
+
+  if (gtk_widget_get_mapped(widget)) {
+    queue->commits++;
+    queue->last_commit_time = g_get_monotonic_time();
+  }
+  if (remap != 0) {
+    queue->remaps++;
+    PLUGIN_TRACE_END(trace_start, "remap", "dirty", dirty, "fields", remap);
+    g_hook_list_marshal(&queue->remap_hooks, FALSE, remap_marshal,
+                        GUINT_TO_POINTER(remap));
+    return;
+  }
+  PLUGIN_TRACE_END(trace_start, "commit", "dirty", dirty);
+}
+
+static gboolean tick_cb(GtkWidget *widget, GdkFrameClock *frame_clock,
+                        gpointer user_data) {
+  LayerSurfaceQueue *queue = static_cast<LayerSurfaceQueue *>(user_data);
+  queue->tick_id = 0;
+  apply_pending(queue);
+  return G_SOURCE_REMOVE;
+}
+
+// Tick callbacks only run while the window is mapped, so anything still
+// pending when it gets unmapped is applied right away.
+static void unmap_cb(GtkWidget *widget, gpointer user_data) {
+  layer_surface_queue_flush(static_cast<LayerSurfaceQueue *>(user_data));
+}
+
+static void notify_changed(LayerSurfaceQueue *queue) {
+  g_hook_list_invoke(&queue->changed_hooks, FALSE);
+}
+
+// Makes sure the pending state gets applied.
+static void schedule(LayerSurfaceQueue *queue) {
+  GtkWidget *widget = GTK_WIDGET(queue->window);
+  if (!gtk_widget_get_mapped(widget)) {
+    apply_pending(queue);
+  } else if (queue->tick_id == 0) {
+    queue->tick_id =
+        gtk_widget_add_tick_callback(widget, tick_cb, queue, nullptr);
+  }
+  notify_changed(queue);
+}
+
+// Returns the state the surface is heading for: the pending state if there
+// is one, the shadow copy otherwise.
+static const LayerSurfaceState *effective_state(LayerSurfaceQueue *queue) {
+  return queue->dirty != 0 ? &queue->pending : &queue->applied;
+}
+
+// Records a setter call. Returns FALSE if @changed is FALSE, i.e. the setter
+// would leave the surface as it is and can return right away.
+static gboolean begin_change(LayerSurfaceQueue *queue, gboolean changed) {
+  queue->setter_calls++;
+  if (!changed) {
+    queue->elided_calls++;
+    return FALSE;
+  }
+
+  // Make the pending state start out from the applied one, so untouched
+  // fields read back correctly from layer_surface_queue_get_state.
+  if (queue->dirty == 0) {
+    queue->pending = queue->applied;
+  }
+  return TRUE;
+}
+
+// Like begin_change(), for a setter of a field the held state covers. Returns
+// the state the setter writes to, the held one while there is one, or nullptr
+// if it can return right away.
+static LayerSurfaceState *begin_held_change(LayerSurfaceQueue *queue,
+                                            gboolean changed) {
+  if (queue->held == nullptr) {
+    return begin_change(queue, changed) ? &queue->pending : nullptr;
+  }
+  queue->setter_calls++;
+  if (!changed) {
+    queue->elided_calls++;
+    return nullptr;
+  }
+  return queue->held;
+}
+
+// Finishes a change begun with begin_held_change() to @fields, which
+// supersedes any pending change to @replaced.
+static void end_held_change(LayerSurfaceQueue *queue, guint fields,
+                            guint replaced) {
+  if (queue->held != nullptr) {
+    notify_changed(queue);
+    return;
+  }
+  queue->dirty &= ~replaced;
+  queue->dirty |= fields;
+  schedule(queue);
+}
+
+// Returns the state the setters of the fields the held state covers compare
+// against.
+static const LayerSurfaceState *held_state(LayerSurfaceQueue *queue) {
+  return queue->held != nullptr ? queue->held : effective_state(queue);
+}
+
+void layer_surface_queue_init(LayerSurfaceQueue *queue, GtkWindow *window) {
+  queue->window = window;
+  queue->dirty = 0;
+  queue->held = nullptr;
+  queue->tick_id = 0;
+  queue->setter_calls = 0;
+  queue->elided_calls = 0;
+  queue->commits = 0;
+  queue->remaps = 0;
+  queue->last_commit_time = 0;
+  g_hook_list_init(&queue->changed_hooks, sizeof(GHook));
+  g_hook_list_init(&queue->remap_hooks, sizeof(GHook));
+  read_state(window, &queue->applied);
+  queue->pending = queue->applied;
+  queue->unmap_handler_id =
+      g_signal_connect(window, "unmap", G_CALLBACK(unmap_cb), queue);
+}
+
+void layer_surface_queue_clear(LayerSurfaceQueue *queue) {
+  if (queue->window == nullptr) {
+    return;
+  }
+
+  if (queue->tick_id != 0) {
+    gtk_widget_remove_tick_callback(GTK_WIDGET(queue->window), queue->tick_id);
+    queue->tick_id = 0;
+  }
+  g_signal_handler_disconnect(queue->window, queue->unmap_handler_id);
+  queue->dirty = 0;
+  queue->held = nullptr;
+  g_hook_list_clear(&queue->changed_hooks);
+  g_hook_list_clear(&queue->remap_hooks);
+  queue->window = nullptr;
+}
+
+void layer_surface_queue_sync(LayerSurfaceQueue *queue) {
+  read_state(queue->window, &queue->applied);
+  if (queue->dirty == 0) {
+    queue->pending = queue->applied;
+  }
+  notify_changed(queue);
+}
+
+gulong layer_surface_queue_add_changed_func(LayerSurfaceQueue *queue,
+                                            LayerSurfaceQueueChangedFunc func,
+                                            gpointer user_data) {
+  GHook *hook = g_hook_alloc(&queue->changed_hooks);
+  hook->func = reinterpret_cast<gpointer>(func);
+  hook->data = user_data;
+  g_hook_append(&queue->changed_hooks, hook);
+  return hook->hook_id;
+}
+
+void layer_surface_queue_remove_changed_func(LayerSurfaceQueue *queue,
+                                             gulong id) {
+  g_hook_destroy(&queue->changed_hooks, id);
+}
+
+gulong layer_surface_queue_add_remap_func(LayerSurfaceQueue *queue,
+                                          LayerSurfaceQueueRemapFunc func,
+                                          gpointer user_data) {
+  GHook *hook = g_hook_alloc(&queue->remap_hooks);
+  hook->func = reinterpret_cast<gpointer>(func);
+  hook->data = user_data;
+  g_hook_append(&queue->remap_hooks, hook);
+  return hook->hook_id;
+}
+
+void layer_surface_queue_remove_remap_func(LayerSurfaceQueue *queue,
+                                           gulong id) {
+  g_hook_destroy(&queue->remap_hooks, id);
+}
+
+void layer_surface_queue_set_layer(LayerSurfaceQueue *queue,
+                                   GtkLayerShellLayer layer) {
+  if (!begin_change(queue, effective_state(queue)->layer != layer)) {
+    return;
+  }
+  queue->pending.layer = layer;
+  queue->dirty |= LAYER_FIELD_LAYER;
+  schedule(queue);
+}
+
+void layer_surface_queue_set_monitor(LayerSurfaceQueue *queue,
+                                     GdkMonitor *monitor) {
+  if (!begin_change(queue, effective_state(queue)->monitor != monitor)) {
+    return;
+  }
+  queue->pending.monitor = monitor;
+  queue->dirty |= LAYER_FIELD_MONITOR;
+  schedule(queue);
+}
+
+void layer_surface_queue_forget_monitor(LayerSurfaceQueue *queue,
+                                        GdkMonitor *monitor) {
+  if (effective_state(queue)->monitor == monitor) {
+    layer_surface_queue_set_monitor(queue, nullptr);
+  }
+  // The shadow copy must not keep the pointer until the next frame either.
+  if (queue->applied.monitor == monitor) {
+    layer_surface_queue_flush(queue);
+  }
+}
+
+void layer_surface_queue_set_anchor(LayerSurfaceQueue *queue,
+                                    GtkLayerShellEdge edge,
+                                    gboolean anchor_to_edge) {
+  g_return_if_fail(edge >= 0 && edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER);
+  anchor_to_edge = anchor_to_edge ? TRUE : FALSE;
+  LayerSurfaceState *state = begin_held_change(
+      queue, held_state(queue)->anchors[edge] != anchor_to_edge);
+  if (state == nullptr) {
+    return;
+  }
+  state->anchors[edge] = anchor_to_edge;
+  end_held_change(queue, LAYER_FIELD_ANCHOR << edge, 0);
+}
+
+void layer_surface_queue_set_margin(LayerSurfaceQueue *queue,
+                                    GtkLayerShellEdge edge, int margin_size) {
+  g_return_if_fail(edge >= 0 && edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER);
+  LayerSurfaceState *state = begin_held_change(
+      queue, held_state(queue)->margins[edge] != margin_size);
+  if (state == nullptr) {
+    return;
+  }
+  state->margins[edge] = margin_size;
+  end_held_change(queue, LAYER_FIELD_MARGIN << edge, 0);
+}
+
+void layer_surface_queue_set_exclusive_zone(LayerSurfaceQueue *queue,
+                                            int exclusive_zone) {
+  const LayerSurfaceState *current = held_state(queue);
+  LayerSurfaceState *state = begin_held_change(
+      queue, current->auto_exclusive_zone ||
+                 current->exclusive_zone != exclusive_zone);
+  if (state == nullptr) {
+    return;
+  }
+  state->exclusive_zone = exclusive_zone;
+  state->auto_exclusive_zone = FALSE;
+  end_held_change(queue, LAYER_FIELD_EXCLUSIVE_ZONE,
+                  LAYER_FIELD_AUTO_EXCLUSIVE_ZONE);
+}
+
+void layer_surface_queue_enable_auto_exclusive_zone(LayerSurfaceQueue *queue) {
+  LayerSurfaceState *state =
+      begin_held_change(queue, !held_state(queue)->auto_exclusive_zone);
+  if (state == nullptr) {
+    return;
+  }
+  state->auto_exclusive_zone = TRUE;
+  end_held_change(queue, LAYER_FIELD_AUTO_EXCLUSIVE_ZONE,
+                  LAYER_FIELD_EXCLUSIVE_ZONE);
+}
+
+void layer_surface_queue_set_keyboard_mode(LayerSurfaceQueue *queue,
+                                           GtkLayerShellKeyboardMode mode) {
+  LayerSurfaceState *state =
+      begin_held_change(queue, held_state(queue)->keyboard_mode != mode);
+  if (state == nullptr) {
+    return;
+  }
+  state->keyboard_mode = mode;
+  end_held_change(queue, LAYER_FIELD_KEYBOARD_MODE, 0);
+}
+
+void layer_surface_queue_set_size(LayerSurfaceQueue *queue, int width,
+                                  int height) {
+  width = MAX(width, -1);
+  height = MAX(height, -1);
+  const LayerSurfaceState *current = held_state(queue);
+  LayerSurfaceState *state = begin_held_change(
+      queue, current->width != width || current->height != height);
+  if (state == nullptr) {
+    return;
+  }
+  state->width = width;
+  state->height = height;
+  end_held_change(queue, LAYER_FIELD_SIZE, 0);
+}
+
+void layer_surface_queue_set_state(LayerSurfaceQueue *queue,
+                                   const LayerSurfaceState *state) {
+  const LayerSurfaceState *current = effective_state(queue);
+  guint fields = 0;
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    if (current->anchors[edge] != (state->anchors[edge] ? TRUE : FALSE)) {
+      fields |= LAYER_FIELD_ANCHOR << edge;
+    }
+    if (current->margins[edge] != state->margins[edge]) {
+      fields |= LAYER_FIELD_MARGIN << edge;
+    }
+  }
+  if (state->auto_exclusive_zone) {
+    if (!current->auto_exclusive_zone) {
+      fields |= LAYER_FIELD_AUTO_EXCLUSIVE_ZONE;
+    }
+  } else if (current->auto_exclusive_zone ||
+             current->exclusive_zone != state->exclusive_zone) {
+    fields |= LAYER_FIELD_EXCLUSIVE_ZONE;
+  }
+  if (current->keyboard_mode != state->keyboard_mode) {
+    fields |= LAYER_FIELD_KEYBOARD_MODE;
+  }
+  int width = MAX(state->width, -1);
+  int height = MAX(state->height, -1);
+  if (current->width != width || current->height != height) {
+    fields |= LAYER_FIELD_SIZE;
+  }
+  if (!begin_change(queue, fields != 0)) {
+    return;
+  }
+
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    queue->pending.anchors[edge] = state->anchors[edge] ? TRUE : FALSE;
+    queue->pending.margins[edge] = state->margins[edge];
+  }
+  if (state->auto_exclusive_zone) {
+    queue->pending.auto_exclusive_zone = TRUE;
+    queue->dirty &= ~LAYER_FIELD_EXCLUSIVE_ZONE;
+  } else {
+    queue->pending.exclusive_zone = state->exclusive_zone;
+    queue->pending.auto_exclusive_zone = FALSE;
+    queue->dirty &= ~LAYER_FIELD_AUTO_EXCLUSIVE_ZONE;
+  }
+  queue->pending.keyboard_mode = state->keyboard_mode;
+  queue->pending.width = width;
+  queue->pending.height = height;
+  queue->dirty |= fields;
+  schedule(queue);
+}
+
+void layer_surface_queue_hold(LayerSurfaceQueue *queue,
+                              LayerSurfaceState *held) {
+  // A cleared queue dropped its hold already.
+  if (queue->window == nullptr || queue->held == held) {
+    return;
+  }
+  queue->held = held;
+  notify_changed(queue);
+}
+
+void layer_surface_queue_get_state(LayerSurfaceQueue *queue,
+                                   LayerSurfaceState *state) {
+  *state = *effective_state(queue);
+  if (queue->held != nullptr) {
+    LayerSurfaceState held = *queue->held;
+    held.layer = state->layer;
+    held.monitor = state->monitor;
+    *state = held;
+    return;
+  }
+
+  // gtk-layer-shell recomputes the automatic exclusive zone whenever the
+  // surface is resized, which the shadow copy can't follow.
+  if (state->auto_exclusive_zone && queue->applied.auto_exclusive_zone &&
+      gtk_layer_is_layer_window(queue->window)) {
+    state->exclusive_zone = gtk_layer_get_exclusive_zone(queue->window);
+  }
+}
+
+void layer_surface_queue_flush(LayerSurfaceQueue *queue) {
+  if (queue->tick_id != 0) {
+    gtk_widget_remove_tick_callback(GTK_WIDGET(queue->window), queue->tick_id);
+    queue->tick_id = 0;
+  }
+  apply_pending(queue);
+}
@@ -0,0 +1,169 @@
+#ifndef WAYLAND_LAYER_SHELL_LAYER_SURFACE_QUEUE_H_
+#define WAYLAND_LAYER_SHELL_LAYER_SURFACE_QUEUE_H_
+
+#include <gtk/gtk.h>
+
+#include <gtk-layer-shell/gtk-layer-shell.h>
+
+// Full layer surface state, as understood by gtk-layer-shell.
+typedef struct {
+  GtkLayerShellLayer layer;
+  // Only compared by identity, never dereferenced; nullptr lets the compositor
+  // pick the monitor.
+  GdkMonitor *monitor;
+  gboolean anchors[GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER];
+  int margins[GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER];
+  int exclusive_zone;
+  gboolean auto_exclusive_zone;
+  GtkLayerShellKeyboardMode keyboard_mode;
+  // Size request of the window; -1 leaves the dimension to the compositor
+  // (when anchored to both opposite edges) or to the content.
+  int width;
+  int height;
+} LayerSurfaceState;
+
+// Which fields of a LayerSurfaceState hold a change. Anchor and margin bits
+// are per edge: LAYER_FIELD_ANCHOR << edge and LAYER_FIELD_MARGIN << edge.
+enum {
+  LAYER_FIELD_LAYER = 1 << 0,
+  LAYER_FIELD_ANCHOR = 1 << 1,
+  LAYER_FIELD_MARGIN = 1 << 5,
+  LAYER_FIELD_EXCLUSIVE_ZONE = 1 << 9,
+  LAYER_FIELD_AUTO_EXCLUSIVE_ZONE = 1 << 10,
+  LAYER_FIELD_KEYBOARD_MODE = 1 << 11,
+  LAYER_FIELD_MONITOR = 1 << 12,
+  LAYER_FIELD_SIZE = 1 << 13,
+};
+
+// Called whenever the state returned by layer_surface_queue_get_state()
+// changes.
+typedef void (*LayerSurfaceQueueChangedFunc)(gpointer user_data);
+
+// Called after the queue remapped the surface to apply a change, with the
+// LAYER_FIELD_* bits of the fields that required it.
+typedef void (*LayerSurfaceQueueRemapFunc)(guint fields, gpointer user_data);
+
+// Collects layer surface changes in front of gtk-layer-shell and applies them
+// together, at most once per frame.
+//
+// Every gtk_layer_set_* call on a mapped window makes gtk-layer-shell commit
+// the surface, so a burst of setters turns into a burst of configure/ack
+// round trips with the compositor. Setters on the queue only record the new
+// value; the queue then applies everything on the next tick of the window's
+// GdkFrameClock, or immediately on layer_surface_queue_flush(). While the
+// window is unmapped there is no surface to commit and changes are applied
+// straight away.
+//
+// The queue also keeps a shadow copy of the state last applied to
+// gtk-layer-shell. Getters are answered from it, and setters that would not
+// change anything return without touching gtk-layer-shell at all.
+//
+// Some changes cannot be made to a mapped surface: gtk-layer-shell unmaps
+// and maps it again to move it to another monitor, and to change its layer
+// on compositors older than zwlr_layer_shell_v1 version 2. The queue does
+// that remap itself, once for all the pending changes, instead of letting
+// each setter remap on its own and commit the rest to the old surface.
+//
+// A surface kept out of sight can have its state held, see
+// layer_surface_queue_hold().
+typedef struct {
+  GtkWindow *window;
+  LayerSurfaceState applied;
+  LayerSurfaceState pending;
+  guint dirty;
+  // Where the setters of everything but the layer and monitor write while
+  // set, instead of the surface.
+  LayerSurfaceState *held;
+  guint tick_id;
+  gulong unmap_handler_id;
+
+  // Number of setter calls received, how many of them were no-ops, and the
+  // surface commits the rest turned into.
+  guint64 setter_calls;
+  guint64 elided_calls;
+  guint64 commits;
+  // How many of the commits remapped the surface.
+  guint64 remaps;
+  // g_get_monotonic_time() of the last commit, 0 before the first.
+  gint64 last_commit_time;
+
+  // LayerSurfaceQueueChangedFunc listeners.
+  GHookList changed_hooks;
+  // LayerSurfaceQueueRemapFunc listeners.
+  GHookList remap_hooks;
+} LayerSurfaceQueue;
+
+// Starts managing @window. The queue does not take a reference; call
+// layer_surface_queue_clear() before the window goes away.
+void layer_surface_queue_init(LayerSurfaceQueue *queue, GtkWindow *window);
+
+// Drops any pending changes and stops tracking the window.
+void layer_surface_queue_clear(LayerSurfaceQueue *queue);
+
+// Adds a function called on state changes. Returns an id for
+// layer_surface_queue_remove_changed_func().
+gulong layer_surface_queue_add_changed_func(LayerSurfaceQueue *queue,
+                                            LayerSurfaceQueueChangedFunc func,
+                                            gpointer user_data);
+
+void layer_surface_queue_remove_changed_func(LayerSurfaceQueue *queue,
+                                             gulong id);
+
+// Adds a function called after each remap. Returns an id for
+// layer_surface_queue_remove_remap_func().
+gulong layer_surface_queue_add_remap_func(LayerSurfaceQueue *queue,
+                                          LayerSurfaceQueueRemapFunc func,
+                                          gpointer user_data);
+
+void layer_surface_queue_remove_remap_func(LayerSurfaceQueue *queue,
+                                           gulong id);
+
+// Reloads the shadow copy from gtk-layer-shell, e.g. after the window was
+// initialized as a layer surface.
+void layer_surface_queue_sync(LayerSurfaceQueue *queue);
+
+void layer_surface_queue_set_layer(LayerSurfaceQueue *queue,
+                                   GtkLayerShellLayer layer);
+void layer_surface_queue_set_monitor(LayerSurfaceQueue *queue,
+                                     GdkMonitor *monitor);
+// Drops @monitor, which was just disconnected, from the queue's state; a
+// surface that was on it goes back to the compositor's choice of output.
+void layer_surface_queue_forget_monitor(LayerSurfaceQueue *queue,
+                                        GdkMonitor *monitor);
+void layer_surface_queue_set_anchor(LayerSurfaceQueue *queue,
+                                    GtkLayerShellEdge edge,
+                                    gboolean anchor_to_edge);
+void layer_surface_queue_set_margin(LayerSurfaceQueue *queue,
+                                    GtkLayerShellEdge edge, int margin_size);
+void layer_surface_queue_set_exclusive_zone(LayerSurfaceQueue *queue,
+                                            int exclusive_zone);
+void layer_surface_queue_enable_auto_exclusive_zone(LayerSurfaceQueue *queue);
+void layer_surface_queue_set_keyboard_mode(LayerSurfaceQueue *queue,
+                                           GtkLayerShellKeyboardMode mode);
+// Negative dimensions are stored as -1.
+void layer_surface_queue_set_size(LayerSurfaceQueue *queue, int width,
+                                  int height);
+
+// Moves the surface towards @state in one change, leaving the layer and
+// monitor alone. Unlike the setters, this changes the surface while the state
+// is held.
+void layer_surface_queue_set_state(LayerSurfaceQueue *queue,
+                                   const LayerSurfaceState *state);
+
+// Makes the anchor, margin, exclusive zone, keyboard mode and size setters
+// record into @held instead of changing the surface, and
+// layer_surface_queue_get_state() report those fields from it, until called
+// again with nullptr. The layer and monitor setters still act on the surface.
+// @held must outlive the hold.
+void layer_surface_queue_hold(LayerSurfaceQueue *queue,
+                              LayerSurfaceState *held);
+
+// Returns the state the surface will have once pending changes are applied,
+// or the held state for the fields it covers.
+void layer_surface_queue_get_state(LayerSurfaceQueue *queue,
+                                   LayerSurfaceState *state);
+
+// Applies all pending changes now, in a single commit.
+void layer_surface_queue_flush(LayerSurfaceQueue *queue);
+
+#endif  // WAYLAND_LAYER_SHELL_LAYER_SURFACE_QUEUE_H_
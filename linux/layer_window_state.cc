@@ -0,0 +1,37 @@
+#include "layer_window_state.h"
+
+G_DEFINE_QUARK(wayland-layer-shell-window-state, layer_window_state)
+
+// The window is still intact while "destroy" runs, so this is where the queue,
+// the regions and the governor let go of their callbacks and signal handlers.
+// The memory itself is only released together with the window's qdata.
+static void destroy_cb(GtkWidget *widget, gpointer user_data) {
+  LayerWindowState *state = static_cast<LayerWindowState *>(user_data);
+  layer_surface_queue_clear(&state->queue);
+  surface_regions_clear(&state->regions);
+  frame_governor_clear(&state->governor);
+  state->initialized = FALSE;
+}
+
+static void state_free(gpointer data) { g_free(data); }
+
+LayerWindowState *layer_window_state_get(GtkWindow *window) {
+  LayerWindowState *state = layer_window_state_peek(window);
+  if (state != nullptr) {
+    return state;
+  }
+
+  state = g_new0(LayerWindowState, 1);
+  layer_surface_queue_init(&state->queue, window);
+  surface_regions_init(&state->regions, window);
+  frame_governor_init(&state->governor, window);
+  g_signal_connect(window, "destroy", G_CALLBACK(destroy_cb), state);
+  g_object_set_qdata_full(G_OBJECT(window), layer_window_state_quark(), state,
+                          state_free);
+  return state;
+}
+
+LayerWindowState *layer_window_state_peek(GtkWindow *window) {
+  return static_cast<LayerWindowState *>(
+      g_object_get_qdata(G_OBJECT(window), layer_window_state_quark()));
+}
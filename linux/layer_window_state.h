@@ -0,0 +1,43 @@
+#ifndef WAYLAND_LAYER_SHELL_LAYER_WINDOW_STATE_H_
+#define WAYLAND_LAYER_SHELL_LAYER_WINDOW_STATE_H_
+
+#include <gtk/gtk.h>
+
+#include "frame_governor.h"
+#include "layer_surface_queue.h"
+#include "surface_regions.h"
+
+typedef struct _AutoHide AutoHide;
+
+// Native state of one window managed by the plugin.
+//
+// The state is attached to the GtkWindow itself (as GObject qdata), so it
+// lives exactly as long as the window does: it is torn down when the window
+// is destroyed, whether or not the plugin is still around, and several
+// plugin instances sharing a window share its state.
+typedef struct {
+  // Whether initialize() turned the window into a layer surface.
+  gboolean initialized;
+
+  // Pending changes plus the shadow copy of the last applied state.
+  LayerSurfaceQueue queue;
+
+  // Input and opaque region hints.
+  SurfaceRegions regions;
+
+  // Frame rate policy.
+  FrameGovernor governor;
+
+  // The enabled auto-hide of a plugin instance on the window, if any. Size
+  // requests from outside that instance go through it, so a hidden surface
+  // keeps its strip size.
+  AutoHide *auto_hide;
+} LayerWindowState;
+
+// Returns the state attached to @window, creating it on first use.
+LayerWindowState *layer_window_state_get(GtkWindow *window);
+
+// Returns the state attached to @window, or nullptr if there is none.
+LayerWindowState *layer_window_state_peek(GtkWindow *window);
+
+#endif  // WAYLAND_LAYER_SHELL_LAYER_WINDOW_STATE_H_
@@ -0,0 +1,188 @@
+#include "monitor_registry.h"
+
+#include <algorithm>
+
+static void monitor_notify_cb(GObject *object, GParamSpec *pspec,
+                              gpointer user_data);
+
+// Reads the current properties of @info->monitor into @info. Returns whether
+// anything changed.
+static bool read_monitor(MonitorInfo *info) {
+  MonitorInfo before = *info;
+  GdkMonitor *monitor = info->monitor;
+
+  const char *manufacturer = gdk_monitor_get_manufacturer(monitor);
+  const char *model = gdk_monitor_get_model(monitor);
+  info->manufacturer = manufacturer != nullptr ? manufacturer : "";
+  info->model = model != nullptr ? model : "";
+  gdk_monitor_get_geometry(monitor, &info->geometry);
+  gdk_monitor_get_workarea(monitor, &info->workarea);
+  info->scale_factor = gdk_monitor_get_scale_factor(monitor);
+  info->refresh_rate = gdk_monitor_get_refresh_rate(monitor);
+  info->width_mm = gdk_monitor_get_width_mm(monitor);
+  info->height_mm = gdk_monitor_get_height_mm(monitor);
+
+  auto same_rect = [](const GdkRectangle &a, const GdkRectangle &b) {
+    return a.x == b.x && a.y == b.y && a.width == b.width &&
+           a.height == b.height;
+  };
+  return before.manufacturer != info->manufacturer ||
+         before.model != info->model ||
+         !same_rect(before.geometry, info->geometry) ||
+         !same_rect(before.workarea, info->workarea) ||
+         before.scale_factor != info->scale_factor ||
+         before.refresh_rate != info->refresh_rate ||
+         before.width_mm != info->width_mm ||
+         before.height_mm != info->height_mm;
+}
+
+// Describes the physical monitor behind @info, independent of its position
+// in the display's monitor list.
+static std::string identity_key(const MonitorInfo &info) {
+  return info.manufacturer + "|" + info.model + "|" +
+         std::to_string(info.width_mm) + "x" + std::to_string(info.height_mm);
+}
+
+guint monitor_registry_assign_id(MonitorRegistry *registry,
+                                 const MonitorInfo *info) {
+  // Identical monitors share an identity; tell them apart by a slot number,
+  // taking the lowest slot whose id no connected monitor holds. Counting the
+  // connected ones instead would hand a replugged monitor the id of its twin.
+  std::string base = identity_key(*info);
+  for (int slot = 0;; slot++) {
+    std::string key = base + "#" + std::to_string(slot);
+    auto known = registry->known_ids.find(key);
+    if (known == registry->known_ids.end()) {
+      guint id = ++registry->next_id;
+      registry->known_ids[key] = id;
+      return id;
+    }
+    if (monitor_registry_lookup(registry, known->second) == nullptr) {
+      return known->second;
+    }
+  }
+}
+
+static void add_monitor(MonitorRegistry *registry, GdkMonitor *monitor,
+                        bool notify) {
+  MonitorInfo info = {};
+  info.monitor = GDK_MONITOR(g_object_ref(monitor));
+  read_monitor(&info);
+  info.id = monitor_registry_assign_id(registry, &info);
+  g_signal_connect(monitor, "notify", G_CALLBACK(monitor_notify_cb), registry);
+  registry->monitors.push_back(info);
+
+  if (notify && registry->changed_func != nullptr) {
+    registry->changed_func(MONITOR_ADDED, &registry->monitors.back(),
+                           registry->user_data);
+  }
+}
+
+static gboolean refresh_idle_cb(gpointer user_data) {
+  MonitorRegistry *registry = static_cast<MonitorRegistry *>(user_data);
+  registry->refresh_idle_id = 0;
+
+  for (MonitorInfo &info : registry->monitors) {
+    if (!info.dirty) {
+      continue;
+    }
+    info.dirty = false;
+    if (read_monitor(&info) && registry->changed_func != nullptr) {
+      registry->changed_func(MONITOR_CHANGED, &info, registry->user_data);
+    }
+  }
+  return G_SOURCE_REMOVE;
+}
+
+static void monitor_notify_cb(GObject *object, GParamSpec *pspec,
+                              gpointer user_data) {
+  MonitorRegistry *registry = static_cast<MonitorRegistry *>(user_data);
+  for (MonitorInfo &info : registry->monitors) {
+    if (G_OBJECT(info.monitor) == object) {
+      info.dirty = true;
+    }
+  }
+  if (registry->refresh_idle_id == 0) {
+    registry->refresh_idle_id = g_idle_add(refresh_idle_cb, registry);
+  }
+}
+
+static void monitor_added_cb(GdkDisplay *display, GdkMonitor *monitor,
+                             gpointer user_data) {
+  add_monitor(static_cast<MonitorRegistry *>(user_data), monitor, true);
+}
+
+static void monitor_removed_cb(GdkDisplay *display, GdkMonitor *monitor,
+                               gpointer user_data) {
+  MonitorRegistry *registry = static_cast<MonitorRegistry *>(user_data);
+  auto it = std::find_if(
+      registry->monitors.begin(), registry->monitors.end(),
+      [monitor](const MonitorInfo &info) { return info.monitor == monitor; });
+  if (it == registry->monitors.end()) {
+    return;
+  }
+
+  MonitorInfo info = *it;
+  registry->monitors.erase(it);
+  g_signal_handlers_disconnect_by_func(monitor,
+                                       (gpointer)monitor_notify_cb, registry);
+  if (registry->changed_func != nullptr) {
+    registry->changed_func(MONITOR_REMOVED, &info, registry->user_data);
+  }
+  g_object_unref(info.monitor);
+}
+
+MonitorRegistry *monitor_registry_new(GdkDisplay *display,
+                                      MonitorChangedFunc changed_func,
+                                      gpointer user_data) {
+  MonitorRegistry *registry = new MonitorRegistry();
+  registry->display = GDK_DISPLAY(g_object_ref(display));
+  registry->changed_func = changed_func;
+  registry->user_data = user_data;
+
+  registry->enumerations++;
+  for (int i = 0; i < gdk_display_get_n_monitors(display); i++) {
+    add_monitor(registry, gdk_display_get_monitor(display, i), false);
+  }
+
+  registry->added_handler_id = g_signal_connect(
+      display, "monitor-added", G_CALLBACK(monitor_added_cb), registry);
+  registry->removed_handler_id = g_signal_connect(
+      display, "monitor-removed", G_CALLBACK(monitor_removed_cb), registry);
+  return registry;
+}
+
+void monitor_registry_free(MonitorRegistry *registry) {
+  if (registry->refresh_idle_id != 0) {
+    g_source_remove(registry->refresh_idle_id);
+  }
+  g_signal_handler_disconnect(registry->display, registry->added_handler_id);
+  g_signal_handler_disconnect(registry->display, registry->removed_handler_id);
+  for (MonitorInfo &info : registry->monitors) {
+    g_signal_handlers_disconnect_by_func(
+        info.monitor, (gpointer)monitor_notify_cb, registry);
+    g_object_unref(info.monitor);
+  }
+  g_object_unref(registry->display);
+  delete registry;
+}
+
+const MonitorInfo *monitor_registry_lookup(MonitorRegistry *registry,
+                                           guint id) {
+  for (const MonitorInfo &info : registry->monitors) {
+    if (info.id == id) {
+      return &info;
+    }
+  }
+  return nullptr;
+}
+
+const MonitorInfo *monitor_registry_find(MonitorRegistry *registry,
+                                         GdkMonitor *monitor) {
+  for (const MonitorInfo &info : registry->monitors) {
+    if (info.monitor == monitor) {
+      return &info;
+    }
+  }
+  return nullptr;
+}
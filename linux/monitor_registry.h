@@ -0,0 +1,80 @@
+#ifndef WAYLAND_LAYER_SHELL_MONITOR_REGISTRY_H_
+#define WAYLAND_LAYER_SHELL_MONITOR_REGISTRY_H_
+
+#include <gtk/gtk.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Cached description of one connected monitor.
+struct MonitorInfo {
+  // Stable id, see MonitorRegistry. Never 0.
+  guint id;
+  GdkMonitor *monitor;
+  std::string manufacturer;
+  std::string model;
+  GdkRectangle geometry;
+  GdkRectangle workarea;
+  int scale_factor;
+  int refresh_rate; // in milli-Hertz, 0 if unknown
+  int width_mm;
+  int height_mm;
+  bool dirty;
+};
+
+typedef enum {
+  MONITOR_ADDED,
+  MONITOR_CHANGED,
+  MONITOR_REMOVED,
+} MonitorChange;
+
+typedef void (*MonitorChangedFunc)(MonitorChange change,
+                                   const MonitorInfo *info,
+                                   gpointer user_data);
+
+// Keeps the monitors of a GdkDisplay cached and up to date.
+//
+// The display is enumerated once; after that the registry follows the
+// display's monitor-added/monitor-removed signals and the monitors' property
+// notifications, and reports each change to @changed_func. Property
+// notifications arrive one property at a time, so they are folded into a
+// single MONITOR_CHANGED per monitor from an idle callback.
+//
+// Ids stay the same for as long as the plugin runs: a monitor is identified by
+// manufacturer, model and physical size, and a monitor that is unplugged and
+// plugged back in gets its old id again, no matter how the display's monitor
+// indices shifted in the meantime.
+struct MonitorRegistry {
+  GdkDisplay *display;
+  std::vector<MonitorInfo> monitors;
+  std::map<std::string, guint> known_ids;
+  guint next_id;
+  gulong added_handler_id;
+  gulong removed_handler_id;
+  guint refresh_idle_id;
+  guint64 enumerations;
+  MonitorChangedFunc changed_func;
+  gpointer user_data;
+};
+
+MonitorRegistry *monitor_registry_new(GdkDisplay *display,
+                                      MonitorChangedFunc changed_func,
+                                      gpointer user_data);
+
+void monitor_registry_free(MonitorRegistry *registry);
+
+// Returns the id for a monitor described by @info that is about to be added
+// to @registry->monitors: the id the same physical monitor had before if it
+// was connected earlier, a new one otherwise.
+guint monitor_registry_assign_id(MonitorRegistry *registry,
+                                 const MonitorInfo *info);
+
+// Returns the cached monitor with @id, or nullptr.
+const MonitorInfo *monitor_registry_lookup(MonitorRegistry *registry, guint id);
+
+// Returns the cached entry for @monitor, or nullptr.
+const MonitorInfo *monitor_registry_find(MonitorRegistry *registry,
+                                         GdkMonitor *monitor);
+
+#endif  // WAYLAND_LAYER_SHELL_MONITOR_REGISTRY_H_
@@ -0,0 +1,138 @@
+#include "plugin_log.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+std::atomic<int> plugin_log_level{PLUGIN_LOG_WARNING};
+
+namespace {
+
+// One ring entry. @sequence tells readers which record the slot holds and
+// whether it is complete: 2 * index + 1 while record number @index is being
+// written, 2 * index + 2 once it is done.
+struct Slot {
+  std::atomic<guint64> sequence;
+  PluginLogRecord record;
+};
+
+Slot ring[kPluginLogCapacity];
+std::atomic<guint64> next_index{0};
+std::atomic<bool> drain_scheduled{false};
+
+// Index of the next record to write to stderr. Only touched by the drain,
+// which runs on the main context.
+guint64 drained = 0;
+
+const gchar *level_names[] = {"off", "error", "warning", "info", "debug"};
+
+// Copies record number @index out of the ring. Returns false if the slot is
+// still being written or has been reused for a newer record since.
+bool read_record(guint64 index, PluginLogRecord *record) {
+  const Slot *slot = &ring[index % kPluginLogCapacity];
+  guint64 expected = 2 * index + 2;
+  if (slot->sequence.load(std::memory_order_acquire) != expected) {
+    return false;
+  }
+  memcpy(record, &slot->record, sizeof(*record));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot->sequence.load(std::memory_order_relaxed) == expected;
+}
+
+gboolean drain_idle_cb(gpointer user_data) {
+  drain_scheduled.store(false, std::memory_order_release);
+  plugin_log_drain();
+  return G_SOURCE_REMOVE;
+}
+
+}  // namespace
+
+void plugin_log_init() {
+  const gchar *value = g_getenv("WAYLAND_LAYER_SHELL_LOG");
+  if (value == nullptr) {
+    return;
+  }
+  int level = plugin_log_parse_level(value);
+  if (level >= 0) {
+    plugin_log_set_level(level);
+  }
+}
+
+int plugin_log_parse_level(const gchar *name) {
+  for (size_t i = 0; i < G_N_ELEMENTS(level_names); i++) {
+    if (g_ascii_strcasecmp(name, level_names[i]) == 0) {
+      return static_cast<int>(i);
+    }
+  }
+
+  gchar *end = nullptr;
+  gint64 level = g_ascii_strtoll(name, &end, 10);
+  if (end == name || *end != '\0' || level < PLUGIN_LOG_OFF ||
+      level > PLUGIN_LOG_DEBUG) {
+    return -1;
+  }
+  return static_cast<int>(level);
+}
+
+void plugin_log_set_level(int level) {
+  plugin_log_level.store(CLAMP(level, PLUGIN_LOG_OFF, PLUGIN_LOG_DEBUG),
+                         std::memory_order_relaxed);
+}
+
+void plugin_log_write(int level, const gchar *format, ...) {
+  guint64 index = next_index.fetch_add(1, std::memory_order_relaxed);
+  Slot *slot = &ring[index % kPluginLogCapacity];
+
+  slot->sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot->record.time = g_get_real_time();
+  slot->record.level = level;
+  va_list args;
+  va_start(args, format);
+  g_vsnprintf(slot->record.message, sizeof(slot->record.message), format,
+              args);
+  va_end(args);
+  slot->sequence.store(2 * index + 2, std::memory_order_release);
+
+  // One idle callback drains a whole burst of records.
+  if (!drain_scheduled.exchange(true, std::memory_order_acq_rel)) {
+    g_idle_add_full(G_PRIORITY_LOW, drain_idle_cb, nullptr, nullptr);
+  }
+}
+
+size_t plugin_log_snapshot(PluginLogRecord *records, size_t max_records) {
+  guint64 end = next_index.load(std::memory_order_acquire);
+  guint64 available = MIN(end, static_cast<guint64>(kPluginLogCapacity));
+  guint64 start = end - MIN(available, static_cast<guint64>(max_records));
+
+  size_t count = 0;
+  for (guint64 index = start; index < end; index++) {
+    if (read_record(index, &records[count])) {
+      count++;
+    }
+  }
+  return count;
+}
+
+void plugin_log_drain() {
+  guint64 end = next_index.load(std::memory_order_acquire);
+  if (end - drained > kPluginLogCapacity) {
+    guint64 lost = end - kPluginLogCapacity - drained;
+    fprintf(stderr, "wayland_layer_shell: %" G_GUINT64_FORMAT
+                    " log records dropped\n",
+            lost);
+    drained = end - kPluginLogCapacity;
+  }
+
+  PluginLogRecord record;
+  for (; drained < end; drained++) {
+    if (!read_record(drained, &record)) {
+      // Still being written; its writer schedules another drain.
+      break;
+    }
+    fprintf(stderr, "wayland_layer_shell: [%s] %s\n",
+            level_names[CLAMP(record.level, 0, PLUGIN_LOG_DEBUG)],
+            record.message);
+  }
+  fflush(stderr);
+}
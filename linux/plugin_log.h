@@ -0,0 +1,83 @@
+#ifndef WAYLAND_LAYER_SHELL_PLUGIN_LOG_H_
+#define WAYLAND_LAYER_SHELL_PLUGIN_LOG_H_
+
+#include <glib.h>
+
+#include <atomic>
+
+// Log levels, from quietest to most verbose. The values are shared with Dart's
+// ShellLogLevel.
+enum {
+  PLUGIN_LOG_OFF = 0,
+  PLUGIN_LOG_ERROR = 1,
+  PLUGIN_LOG_WARNING = 2,
+  PLUGIN_LOG_INFO = 3,
+  PLUGIN_LOG_DEBUG = 4,
+};
+
+// Most verbose level compiled in. Statements above it are removed by the
+// compiler; set it with -DWAYLAND_LAYER_SHELL_LOG_MAX_LEVEL=<n>.
+#ifndef WAYLAND_LAYER_SHELL_LOG_MAX_LEVEL
+#define WAYLAND_LAYER_SHELL_LOG_MAX_LEVEL PLUGIN_LOG_DEBUG
+#endif
+
+// Number of records kept in the ring, and the longest message stored per
+// record (longer messages are truncated).
+constexpr size_t kPluginLogCapacity = 256;
+constexpr size_t kPluginLogMessageSize = 160;
+
+// Level selected at runtime. Starts out as PLUGIN_LOG_WARNING, or as given by
+// the WAYLAND_LAYER_SHELL_LOG environment variable.
+extern std::atomic<int> plugin_log_level;
+
+// Logs a printf-style message at @level.
+//
+// Disabled levels cost a comparison against a constant or a relaxed atomic
+// load; the arguments are not evaluated. Enabled records are formatted into a
+// fixed-size lock-free ring without allocating and written to stderr later,
+// from an idle callback on the main context.
+#define PLUGIN_LOG(level, ...)                                                 \
+  do {                                                                         \
+    if ((level) <= WAYLAND_LAYER_SHELL_LOG_MAX_LEVEL &&                        \
+        (level) <= plugin_log_level.load(std::memory_order_relaxed)) {         \
+      plugin_log_write((level), __VA_ARGS__);                                  \
+    }                                                                          \
+  } while (0)
+
+#define PLUGIN_LOG_E(...) PLUGIN_LOG(PLUGIN_LOG_ERROR, __VA_ARGS__)
+#define PLUGIN_LOG_W(...) PLUGIN_LOG(PLUGIN_LOG_WARNING, __VA_ARGS__)
+#define PLUGIN_LOG_I(...) PLUGIN_LOG(PLUGIN_LOG_INFO, __VA_ARGS__)
+#define PLUGIN_LOG_D(...) PLUGIN_LOG(PLUGIN_LOG_DEBUG, __VA_ARGS__)
+
+// A record copied out of the ring.
+typedef struct {
+  gint64 time; // g_get_real_time(), in microseconds
+  int level;
+  gchar message[kPluginLogMessageSize];
+} PluginLogRecord;
+
+// Reads the runtime level from the environment. Safe to call more than once.
+void plugin_log_init();
+
+// Parses "off", "error", "warning", "info", "debug" or a number into a level.
+// Returns -1 for anything else.
+int plugin_log_parse_level(const gchar *name);
+
+// Sets the runtime level, clamped to the valid range.
+void plugin_log_set_level(int level);
+
+// Stores a record in the ring. Use PLUGIN_LOG() instead of calling this
+// directly. Safe to call from any thread.
+void plugin_log_write(int level, const gchar *format, ...)
+    G_GNUC_PRINTF(2, 3);
+
+// Copies up to @max_records of the most recent records, oldest first, into
+// @records and returns how many were copied. Records being written while the
+// ring is read are skipped.
+size_t plugin_log_snapshot(PluginLogRecord *records, size_t max_records);
+
+// Writes the records not written yet to stderr. Normally done from an idle
+// callback; exposed for shutdown and tests.
+void plugin_log_drain();
+
+#endif  // WAYLAND_LAYER_SHELL_PLUGIN_LOG_H_
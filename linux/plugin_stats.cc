@@ -0,0 +1,77 @@
+#include "plugin_stats.h"
+
+#include <time.h>
+
+#include <cstring>
+
+int plugin_stats_bucket(guint64 ns) {
+  if (ns < kStatsSubBuckets) {
+    return static_cast<int>(ns);
+  }
+  // The highest set bit picks the power of two, the bits below it the linear
+  // sub-bucket.
+  int magnitude = 63 - __builtin_clzll(ns);
+  int sub_bucket = static_cast<int>(ns >> (magnitude - kStatsSubBucketBits)) &
+                   (kStatsSubBuckets - 1);
+  int bucket = (magnitude - kStatsSubBucketBits + 1) * kStatsSubBuckets +
+               sub_bucket;
+  return MIN(bucket, kStatsBuckets - 1);
+}
+
+guint64 plugin_stats_bucket_start(int bucket) {
+  if (bucket < kStatsSubBuckets) {
+    return bucket;
+  }
+  int magnitude = bucket / kStatsSubBuckets + kStatsSubBucketBits - 1;
+  guint64 sub_bucket = bucket % kStatsSubBuckets;
+  return (static_cast<guint64>(kStatsSubBuckets) + sub_bucket)
+         << (magnitude - kStatsSubBucketBits);
+}
+
+guint64 plugin_stats_now() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<guint64>(now.tv_sec) * G_GUINT64_CONSTANT(1000000000) +
+         now.tv_nsec;
+}
+
+void plugin_stats_record(PluginStats *stats, channel_api::Method method,
+                         guint64 start_ns, bool error) {
+  guint64 ns = plugin_stats_now() - start_ns;
+  MethodStats *method_stats = &stats->methods[static_cast<size_t>(method)];
+  method_stats->calls++;
+  if (error) {
+    method_stats->errors++;
+  }
+  method_stats->total_ns += ns;
+  method_stats->max_ns = MAX(method_stats->max_ns, ns);
+  method_stats->buckets[plugin_stats_bucket(ns)]++;
+}
+
+guint64 plugin_stats_percentile(const MethodStats *method_stats,
+                                double percentile) {
+  if (method_stats->calls == 0) {
+    return 0;
+  }
+
+  guint64 rank = static_cast<guint64>(
+      method_stats->calls * CLAMP(percentile, 0.0, 100.0) / 100.0 + 0.5);
+  rank = CLAMP(rank, G_GUINT64_CONSTANT(1), method_stats->calls);
+  guint64 seen = 0;
+  for (int bucket = 0; bucket < kStatsBuckets; bucket++) {
+    seen += method_stats->buckets[bucket];
+    if (seen >= rank) {
+      // The last bucket is open-ended; the maximum is the best bound there.
+      if (bucket == kStatsBuckets - 1) {
+        return method_stats->max_ns;
+      }
+      return MIN(plugin_stats_bucket_start(bucket + 1) - 1,
+                 method_stats->max_ns);
+    }
+  }
+  return method_stats->max_ns;
+}
+
+void plugin_stats_reset(PluginStats *stats) {
+  memset(stats, 0, sizeof(*stats));
+}
@@ -0,0 +1,56 @@
+#ifndef WAYLAND_LAYER_SHELL_PLUGIN_STATS_H_
+#define WAYLAND_LAYER_SHELL_PLUGIN_STATS_H_
+
+#include <glib.h>
+
+#include "channel_api.g.h"
+
+// Whether method call statistics are compiled in. Set it with
+// -DWAYLAND_LAYER_SHELL_STATS=0 to remove them entirely.
+#ifndef WAYLAND_LAYER_SHELL_STATS
+#define WAYLAND_LAYER_SHELL_STATS 1
+#endif
+
+// Latency histogram layout: log-linear buckets in the style of HDR
+// histograms. Each power of two of nanoseconds is split into
+// kStatsSubBuckets linear buckets, which keeps the relative error under 25%
+// from 1 ns up to about 7 s; slower calls land in the last bucket.
+constexpr int kStatsSubBucketBits = 2;
+constexpr int kStatsSubBuckets = 1 << kStatsSubBucketBits;
+constexpr int kStatsBuckets = 32 * kStatsSubBuckets;
+
+typedef struct {
+  guint64 calls;
+  guint64 errors;
+  guint64 total_ns;
+  guint64 max_ns;
+  guint64 buckets[kStatsBuckets];
+} MethodStats;
+
+// Call statistics for every channel method, indexed by channel_api::Method.
+// Only touched from the main context.
+typedef struct {
+  MethodStats methods[channel_api::kMethodCount];
+} PluginStats;
+
+// Returns the histogram bucket a call taking @ns nanoseconds falls into.
+int plugin_stats_bucket(guint64 ns);
+
+// Returns the smallest latency, in nanoseconds, that falls into @bucket.
+guint64 plugin_stats_bucket_start(int bucket);
+
+// Returns a monotonic timestamp in nanoseconds.
+guint64 plugin_stats_now();
+
+// Records one call of @method that started at @start_ns.
+void plugin_stats_record(PluginStats *stats, channel_api::Method method,
+                         guint64 start_ns, bool error);
+
+// Returns the latency below which @percentile (0-100) of the calls of
+// @method_stats fell, as the upper end of the histogram bucket it reached.
+guint64 plugin_stats_percentile(const MethodStats *method_stats,
+                                double percentile);
+
+void plugin_stats_reset(PluginStats *stats);
+
+#endif  // WAYLAND_LAYER_SHELL_PLUGIN_STATS_H_
@@ -0,0 +1,183 @@
+#include "plugin_trace.h"
+
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdlib>
+
+bool plugin_trace_enabled = false;
+
+namespace {
+
+struct TraceEvent {
+  const gchar *name;
+  guint64 start_ns;
+  // 0 for instant events.
+  guint64 duration_ns;
+  bool complete;
+  const gchar *arg_names[2];
+  gint64 args[2];
+};
+
+TraceEvent *events = nullptr;
+// Total events recorded since tracing started; the ring holds the last
+// kPluginTraceCapacity of them.
+guint64 recorded = 0;
+gchar *trace_path = nullptr;
+// Thread id of the main context, which records all events.
+long main_tid = 0;
+
+TraceEvent *next_event(const gchar *name, guint64 start_ns,
+                       const gchar *arg0_name, gint64 arg0,
+                       const gchar *arg1_name, gint64 arg1) {
+  TraceEvent *event = &events[recorded % kPluginTraceCapacity];
+  recorded++;
+  event->name = name;
+  event->start_ns = start_ns;
+  event->duration_ns = 0;
+  event->complete = false;
+  event->arg_names[0] = arg0_name;
+  event->args[0] = arg0;
+  event->arg_names[1] = arg1_name;
+  event->args[1] = arg1;
+  return event;
+}
+
+void append_event(GString *json, const TraceEvent *event, int pid) {
+  // Timestamps are in microseconds; keep the nanoseconds as decimals.
+  g_string_append_printf(json,
+                         "{\"name\":\"%s\",\"cat\":\"wayland_layer_shell\","
+                         "\"ph\":\"%s\",\"ts\":%.3f,",
+                         event->name, event->complete ? "X" : "i",
+                         event->start_ns / 1000.0);
+  if (event->complete) {
+    g_string_append_printf(json, "\"dur\":%.3f,", event->duration_ns / 1000.0);
+  } else {
+    g_string_append(json, "\"s\":\"t\",");
+  }
+  g_string_append_printf(json, "\"pid\":%d,\"tid\":%ld,\"args\":{", pid,
+                         main_tid);
+  for (int i = 0; i < 2; i++) {
+    if (event->arg_names[i] != nullptr) {
+      g_string_append_printf(json, "%s\"%s\":%" G_GINT64_FORMAT,
+                             i > 0 ? "," : "", event->arg_names[i],
+                             event->args[i]);
+    }
+  }
+  g_string_append(json, "}}");
+}
+
+gboolean write_trace(const gchar *path, GError **error) {
+  int pid = getpid();
+  guint64 count = MIN(recorded, kPluginTraceCapacity);
+  guint64 first = recorded - count;
+
+  g_autoptr(GString) json = g_string_new("{\"traceEvents\":[\n");
+  g_string_append_printf(json,
+                         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+                         "\"tid\":%ld,\"args\":{\"name\":\"platform\"}}",
+                         pid, main_tid);
+  for (guint64 i = first; i < recorded; i++) {
+    g_string_append(json, ",\n");
+    append_event(json, &events[i % kPluginTraceCapacity], pid);
+  }
+  g_string_append_printf(json,
+                         "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{"
+                         "\"dropped_events\":%" G_GUINT64_FORMAT "}}\n",
+                         first);
+  return g_file_set_contents(path, json->str, json->len, error);
+}
+
+// Dart may have stopped the trace already.
+void write_at_exit() {
+  if (!plugin_trace_enabled) {
+    return;
+  }
+  g_autoptr(GError) error = nullptr;
+  g_autofree gchar *path = plugin_trace_stop(nullptr, nullptr, &error);
+  if (path == nullptr && error != nullptr) {
+    g_printerr("wayland_layer_shell: %s\n", error->message);
+  }
+}
+
+}  // namespace
+
+void plugin_trace_init() {
+  static bool initialized = false;
+  if (initialized) {
+    return;
+  }
+  initialized = true;
+
+  const gchar *path = g_getenv("WAYLAND_LAYER_SHELL_TRACE");
+  if (path != nullptr && path[0] != '\0' && plugin_trace_start(path)) {
+    atexit(write_at_exit);
+  }
+}
+
+guint64 plugin_trace_now() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<guint64>(now.tv_sec) * G_GUINT64_CONSTANT(1000000000) +
+         now.tv_nsec;
+}
+
+gboolean plugin_trace_start(const gchar *path) {
+#if WAYLAND_LAYER_SHELL_TRACE
+  if (events == nullptr) {
+    events = g_new(TraceEvent, kPluginTraceCapacity);
+  }
+  recorded = 0;
+  g_free(trace_path);
+  trace_path =
+      path != nullptr
+          ? g_strdup(path)
+          : g_strdup_printf("%s/wayland_layer_shell-%d.json", g_get_tmp_dir(),
+                            getpid());
+  main_tid = syscall(SYS_gettid);
+  plugin_trace_enabled = true;
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
+gchar *plugin_trace_stop(size_t *events_written, guint64 *dropped,
+                         GError **error) {
+  if (!plugin_trace_enabled) {
+    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                "Tracing is not running");
+    return nullptr;
+  }
+  plugin_trace_enabled = false;
+
+  if (!write_trace(trace_path, error)) {
+    return nullptr;
+  }
+  if (events_written != nullptr) {
+    *events_written = MIN(recorded, kPluginTraceCapacity);
+  }
+  if (dropped != nullptr) {
+    *dropped = recorded - MIN(recorded, kPluginTraceCapacity);
+  }
+  return g_strdup(trace_path);
+}
+
+void plugin_trace_complete(guint64 start_ns, const gchar *name,
+                           const gchar *arg0_name, gint64 arg0,
+                           const gchar *arg1_name, gint64 arg1) {
+  // Tracing may have stopped while the span was open.
+  if (!plugin_trace_enabled) {
+    return;
+  }
+  TraceEvent *event =
+      next_event(name, start_ns, arg0_name, arg0, arg1_name, arg1);
+  event->complete = true;
+  event->duration_ns = plugin_trace_now() - start_ns;
+}
+
+void plugin_trace_instant(const gchar *name, const gchar *arg0_name,
+                          gint64 arg0, const gchar *arg1_name, gint64 arg1) {
+  next_event(name, plugin_trace_now(), arg0_name, arg0, arg1_name, arg1);
+}
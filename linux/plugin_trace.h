@@ -0,0 +1,74 @@
+#ifndef WAYLAND_LAYER_SHELL_PLUGIN_TRACE_H_
+#define WAYLAND_LAYER_SHELL_PLUGIN_TRACE_H_
+
+#include <glib.h>
+
+// Whether trace events are compiled in. Set it with
+// -DWAYLAND_LAYER_SHELL_TRACE=0 to remove them entirely.
+#ifndef WAYLAND_LAYER_SHELL_TRACE
+#define WAYLAND_LAYER_SHELL_TRACE 1
+#endif
+
+// Number of events kept while tracing. Once full, the oldest events are
+// overwritten, so a trace always holds the time right before it was stopped.
+constexpr size_t kPluginTraceCapacity = 16384;
+
+// Whether tracing is running. Only touched from the main context, like the
+// events themselves.
+extern bool plugin_trace_enabled;
+
+#define PLUGIN_TRACE_ON() (WAYLAND_LAYER_SHELL_TRACE && plugin_trace_enabled)
+
+// Returns the start of a span for PLUGIN_TRACE_END(), or 0 while tracing is
+// off.
+#define PLUGIN_TRACE_BEGIN() (PLUGIN_TRACE_ON() ? plugin_trace_now() : 0)
+
+// Records a span named @name from @start_ns (from PLUGIN_TRACE_BEGIN()) until
+// now, with up to two named integer arguments (nullptr names for none).
+// Nothing is recorded if tracing was off when the span began.
+#define PLUGIN_TRACE_END(start_ns, ...)                                        \
+  do {                                                                         \
+    if ((start_ns) != 0) {                                                     \
+      plugin_trace_complete((start_ns), __VA_ARGS__);                          \
+    }                                                                          \
+  } while (0)
+
+// Records an instant event, with arguments as for PLUGIN_TRACE_END(). Disabled
+// tracing costs a load and a branch; the arguments are not evaluated.
+#define PLUGIN_TRACE_INSTANT(...)                                              \
+  do {                                                                         \
+    if (PLUGIN_TRACE_ON()) {                                                   \
+      plugin_trace_instant(__VA_ARGS__);                                       \
+    }                                                                          \
+  } while (0)
+
+// Starts tracing if the WAYLAND_LAYER_SHELL_TRACE environment variable names
+// a file; the trace is written there when the process exits. Safe to call
+// more than once.
+void plugin_trace_init();
+
+// Returns a CLOCK_MONOTONIC timestamp in nanoseconds, the clock Flutter's own
+// timeline uses.
+guint64 plugin_trace_now();
+
+// Clears the events recorded so far and starts recording. The trace is
+// written to @path when stopped, or to a file in the temporary directory if
+// @path is nullptr. Returns FALSE if tracing is compiled out.
+gboolean plugin_trace_start(const gchar *path);
+
+// Stops recording and writes the events in the Chrome trace event format,
+// which Perfetto and chrome://tracing load. Returns the path written to
+// (free with g_free()), or nullptr with @error set if writing failed or
+// tracing was not running.
+gchar *plugin_trace_stop(size_t *events, guint64 *dropped, GError **error);
+
+// Use the macros above instead of calling these directly. @name and the
+// argument names must be static strings.
+void plugin_trace_complete(guint64 start_ns, const gchar *name,
+                           const gchar *arg0_name = nullptr, gint64 arg0 = 0,
+                           const gchar *arg1_name = nullptr, gint64 arg1 = 0);
+void plugin_trace_instant(const gchar *name, const gchar *arg0_name = nullptr,
+                          gint64 arg0 = 0, const gchar *arg1_name = nullptr,
+                          gint64 arg1 = 0);
+
+#endif  // WAYLAND_LAYER_SHELL_PLUGIN_TRACE_H_
@@ -0,0 +1,123 @@
+#include "surface_regions.h"
+
+// Replaces *@stored with a copy of @region unless they are equal. Returns
+// whether it did.
+static gboolean replace_region(cairo_region_t **stored,
+                               const cairo_region_t *region) {
+  if (cairo_region_equal(*stored, region)) {
+    return FALSE;
+  }
+  g_clear_pointer(stored, cairo_region_destroy);
+  if (region != nullptr) {
+    *stored = cairo_region_copy(region);
+  }
+  return TRUE;
+}
+
+static void apply_opaque(SurfaceRegions *regions) {
+  GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(regions->window));
+  if (regions->opaque != nullptr && gdk_window != nullptr) {
+    gdk_window_set_opaque_region(gdk_window, regions->opaque);
+  }
+}
+
+// Runs after GTK's own handlers, which reset the opaque region.
+static void reapply_opaque_cb(GtkWidget *widget, gpointer user_data) {
+  apply_opaque(static_cast<SurfaceRegions *>(user_data));
+}
+
+static void size_allocate_cb(GtkWidget *widget, GdkRectangle *allocation,
+                             gpointer user_data) {
+  apply_opaque(static_cast<SurfaceRegions *>(user_data));
+}
+
+static void connect_opaque_handlers(SurfaceRegions *regions) {
+  if (regions->realize_handler_id != 0) {
+    return;
+  }
+  regions->realize_handler_id = g_signal_connect_after(
+      regions->window, "realize", G_CALLBACK(reapply_opaque_cb), regions);
+  regions->size_allocate_handler_id =
+      g_signal_connect_after(regions->window, "size-allocate",
+                             G_CALLBACK(size_allocate_cb), regions);
+  regions->style_updated_handler_id =
+      g_signal_connect_after(regions->window, "style-updated",
+                             G_CALLBACK(reapply_opaque_cb), regions);
+}
+
+static void disconnect_opaque_handlers(SurfaceRegions *regions) {
+  if (regions->realize_handler_id == 0) {
+    return;
+  }
+  g_signal_handler_disconnect(regions->window, regions->realize_handler_id);
+  g_signal_handler_disconnect(regions->window,
+                              regions->size_allocate_handler_id);
+  g_signal_handler_disconnect(regions->window,
+                              regions->style_updated_handler_id);
+  regions->realize_handler_id = 0;
+  regions->size_allocate_handler_id = 0;
+  regions->style_updated_handler_id = 0;
+}
+
+void surface_regions_init(SurfaceRegions *regions, GtkWindow *window) {
+  *regions = {};
+  regions->window = window;
+}
+
+void surface_regions_clear(SurfaceRegions *regions) {
+  if (regions->window != nullptr) {
+    disconnect_opaque_handlers(regions);
+  }
+  g_clear_pointer(&regions->input, cairo_region_destroy);
+  g_clear_pointer(&regions->opaque, cairo_region_destroy);
+  regions->window = nullptr;
+}
+
+gboolean surface_regions_set_input(SurfaceRegions *regions,
+                                   const cairo_region_t *region) {
+  if (!replace_region(&regions->input, region)) {
+    regions->elided_updates++;
+    return FALSE;
+  }
+  regions->updates++;
+
+  // GTK keeps its own copy and applies it again whenever the window is
+  // realized.
+  if (!regions->input_suspended) {
+    gtk_widget_input_shape_combine_region(GTK_WIDGET(regions->window),
+                                          regions->input);
+  }
+  return TRUE;
+}
+
+void surface_regions_suspend_input(SurfaceRegions *regions,
+                                   gboolean suspended) {
+  if (regions->input_suspended == suspended) {
+    return;
+  }
+  regions->input_suspended = suspended;
+  if (regions->input != nullptr) {
+    gtk_widget_input_shape_combine_region(
+        GTK_WIDGET(regions->window), suspended ? nullptr : regions->input);
+  }
+}
+
+gboolean surface_regions_set_opaque(SurfaceRegions *regions,
+                                    const cairo_region_t *region) {
+  if (!replace_region(&regions->opaque, region)) {
+    regions->elided_updates++;
+    return FALSE;
+  }
+  regions->updates++;
+
+  if (regions->opaque == nullptr) {
+    disconnect_opaque_handlers(regions);
+    // Let GTK put its own opaque region back.
+    gtk_widget_queue_resize(GTK_WIDGET(regions->window));
+    return TRUE;
+  }
+
+  connect_opaque_handlers(regions);
+  apply_opaque(regions);
+  return TRUE;
+}
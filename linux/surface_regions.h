@@ -0,0 +1,57 @@
+#ifndef WAYLAND_LAYER_SHELL_SURFACE_REGIONS_H_
+#define WAYLAND_LAYER_SHELL_SURFACE_REGIONS_H_
+
+#include <gtk/gtk.h>
+
+// Input and opaque region hints of one window.
+//
+// Regions are in surface-local logical pixels. Each setter compares the new
+// region with the last one it sent and only passes real changes on to GTK,
+// so repeating the same region costs no surface commit.
+//
+// GTK recomputes the opaque region itself whenever the window is allocated
+// or restyled, so an explicit opaque region is re-applied after it does.
+typedef struct {
+  GtkWindow *window;
+  // nullptr: the whole surface takes input.
+  cairo_region_t *input;
+  // nullptr: GTK's own opaque region is left alone.
+  cairo_region_t *opaque;
+  gulong realize_handler_id;
+  gulong size_allocate_handler_id;
+  gulong style_updated_handler_id;
+  // Whether the whole surface takes input regardless of @input.
+  gboolean input_suspended;
+
+  // Updates passed on to GTK, and updates skipped because the region did not
+  // change.
+  guint64 updates;
+  guint64 elided_updates;
+} SurfaceRegions;
+
+// Starts managing the regions of @window. Does not take a reference; call
+// surface_regions_clear() before the window goes away.
+void surface_regions_init(SurfaceRegions *regions, GtkWindow *window);
+
+// Drops the stored regions and disconnects from the window. The regions
+// already set on the window stay in place.
+void surface_regions_clear(SurfaceRegions *regions);
+
+// Restricts pointer and touch input to @region (nullptr: the whole surface,
+// an empty region: no input at all). Input outside of it goes to whatever is
+// below the surface. Returns whether the region changed.
+gboolean surface_regions_set_input(SurfaceRegions *regions,
+                                   const cairo_region_t *region);
+
+// While @suspended, the whole surface takes input; the region set with
+// surface_regions_set_input() is kept and applied again when resumed.
+void surface_regions_suspend_input(SurfaceRegions *regions,
+                                   gboolean suspended);
+
+// Tells the compositor that @region of the surface is fully opaque, so it can
+// skip drawing what is beneath it. nullptr hands the opaque region back to
+// GTK. Returns whether the region changed.
+gboolean surface_regions_set_opaque(SurfaceRegions *regions,
+                                    const cairo_region_t *region);
+
+#endif  // WAYLAND_LAYER_SHELL_SURFACE_REGIONS_H_
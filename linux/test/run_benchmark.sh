@@ -0,0 +1,74 @@
+#!/bin/sh
+# Runs wayland_layer_shell_benchmark, or wayland_layer_shell_soak, inside a
+# private headless sway.
+#
+# Usage: run_benchmark.sh <benchmark binary> [results.json] [benchmark args...]
+#
+# Needs sway (wlroots' headless backend and pixman renderer; no GPU, no
+# network) and swaymsg. BENCHMARK_OUTPUTS sets how many virtual outputs the
+# compositor gets (default 4), BENCHMARK_SCALE their scale (default 1.5, so
+# GTK's integer buffer scale differs from the preferred fractional scale and
+# the rendered and exact pixel counts in the scale result differ). Exits with
+# 77 if sway is not installed.
+set -eu
+
+benchmark=${1:?usage: run_benchmark.sh <benchmark binary> [results.json] [args...]}
+results=${2:-wayland_layer_shell_benchmark.json}
+shift
+[ $# -gt 0 ] && shift
+outputs=${BENCHMARK_OUTPUTS:-4}
+scale=${BENCHMARK_SCALE:-1.5}
+
+if ! command -v sway >/dev/null 2>&1; then
+  echo "sway not found, skipping benchmark" >&2
+  exit 77
+fi
+
+runtime_dir=$(mktemp -d)
+sway_pid=
+cleanup() {
+  [ -n "$sway_pid" ] && kill "$sway_pid" 2>/dev/null && wait "$sway_pid" || true
+  rm -rf "$runtime_dir"
+}
+trap cleanup EXIT INT TERM
+
+# An empty config keeps the user's bars, idle daemons etc. out of the run.
+: >"$runtime_dir/sway.conf"
+
+XDG_RUNTIME_DIR=$runtime_dir \
+WLR_BACKENDS=headless \
+WLR_RENDERER=pixman \
+WLR_LIBINPUT_NO_DEVICES=1 \
+  sway --config "$runtime_dir/sway.conf" >"$runtime_dir/sway.log" 2>&1 &
+sway_pid=$!
+
+# Wait for the Wayland and IPC sockets.
+socket=
+ipc=
+for _ in $(seq 100); do
+  socket=$(cd "$runtime_dir" && ls wayland-? 2>/dev/null | head -n 1) || true
+  ipc=$(ls "$runtime_dir"/sway-ipc.*.sock 2>/dev/null | head -n 1) || true
+  [ -n "$socket" ] && [ -n "$ipc" ] && break
+  sleep 0.1
+done
+if [ -z "$socket" ] || [ -z "$ipc" ]; then
+  echo "sway did not start:" >&2
+  cat "$runtime_dir/sway.log" >&2
+  exit 1
+fi
+
+# The headless backend starts with one output; add the rest.
+i=1
+while [ "$i" -lt "$outputs" ]; do
+  swaymsg -s "$ipc" create_output >/dev/null
+  i=$((i + 1))
+done
+swaymsg -s "$ipc" output '*' scale "$scale" >/dev/null
+
+# SWAYSOCK lets the soak test plug outputs in and out.
+XDG_RUNTIME_DIR=$runtime_dir \
+WAYLAND_DISPLAY=$socket \
+SWAYSOCK=$ipc \
+GDK_BACKEND=wayland \
+  "$benchmark" --json "$results" --expected-outputs "$outputs" "$@"
+echo "Results written to $results"
@@ -0,0 +1,742 @@
+#include <fcntl.h>
+#include <flutter_linux/flutter_linux.h>
+#include <gtk-layer-shell/gtk-layer-shell.h>
+#include <gtk/gtk.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "frame_presentation.h"
+#include "layer_shell_caps.h"
+#include "include/wayland_layer_shell/wayland_layer_shell_ffi.h"
+#include "include/wayland_layer_shell/wayland_layer_shell_plugin.h"
+#include "wayland_layer_shell_plugin_private.h"
+
+// Benchmarks the plugin's method handlers against a real compositor.
+//
+// Meant to run inside a headless compositor with layer shell support; see
+// run_benchmark.sh, which starts one and points this binary at it. Results
+// are written as JSON so runs can be compared between releases. Exits with
+// 77 (the ctest/automake "skipped" code) if there is no layer shell.
+
+namespace {
+
+// How long to wait for the compositor before a sample counts as timed out.
+constexpr gint64 kWaitTimeoutUs = 2 * G_USEC_PER_SEC;
+
+struct Options {
+  const gchar *json_path = nullptr;
+  int initialize_iterations = 10;
+  int configure_iterations = 100;
+  int monitor_list_iterations = 1000;
+  int storm_calls = 100000;
+  int getter_calls = 100000;
+  int present_iterations = 50;
+  int control_iterations = 200;
+  int presented_frames = 120;
+  int expected_outputs = 0;
+};
+
+double now_us() {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Latency samples of one benchmark, in microseconds.
+struct Samples {
+  std::vector<double> values;
+  int timeouts = 0;
+
+  double percentile(double p) const {
+    std::vector<double> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    size_t index = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+  }
+
+  void append_json(GString *json, const gchar *name) const {
+    g_string_append_printf(json, "    \"%s\": {\"samples\": %zu", name,
+                           values.size());
+    if (!values.empty()) {
+      double sum = 0;
+      for (double value : values) {
+        sum += value;
+      }
+      g_string_append_printf(
+          json,
+          ", \"mean_us\": %.3f, \"min_us\": %.3f, \"p50_us\": %.3f, "
+          "\"p90_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f",
+          sum / values.size(), percentile(0), percentile(50), percentile(90),
+          percentile(99), percentile(100));
+    }
+    g_string_append_printf(json, ", \"timeouts\": %d}", timeouts);
+  }
+};
+
+FlValue *int_list(std::initializer_list<gint64> values) {
+  FlValue *list = fl_value_new_list();
+  for (gint64 value : values) {
+    fl_value_append_take(list, fl_value_new_int(value));
+  }
+  return list;
+}
+
+// Calls @method and returns its result, or nullptr if it failed.
+FlValue *invoke(WaylandLayerShellPlugin *plugin, const gchar *method,
+                FlValue *args) {
+  g_autoptr(FlMethodResponse) response =
+      wayland_layer_shell_plugin_invoke(plugin, method, args);
+  if (!FL_IS_METHOD_SUCCESS_RESPONSE(response)) {
+    g_printerr("%s failed\n", method);
+    return nullptr;
+  }
+  return fl_value_ref(fl_method_success_response_get_result(
+      FL_METHOD_SUCCESS_RESPONSE(response)));
+}
+
+// Iterates the main context until *@counter exceeds @target. Returns FALSE on
+// timeout.
+gboolean wait_for(const int *counter, int target) {
+  gint64 deadline = g_get_monotonic_time() + kWaitTimeoutUs;
+  while (*counter <= target) {
+    if (g_get_monotonic_time() > deadline) {
+      return FALSE;
+    }
+    g_main_context_iteration(nullptr, FALSE);
+  }
+  return TRUE;
+}
+
+gboolean count_configure_cb(GtkWidget *widget, GdkEvent *event,
+                            gpointer user_data) {
+  (*static_cast<int *>(user_data))++;
+  return FALSE;
+}
+
+void count_paint_cb(GdkFrameClock *frame_clock, gpointer user_data) {
+  (*static_cast<int *>(user_data))++;
+}
+
+// Counts the frames painted on @window in *@counter until the returned
+// handler is disconnected from the window's frame clock.
+gulong count_paints(GtkWindow *window, int *counter) {
+  GdkFrameClock *frame_clock = gdk_window_get_frame_clock(
+      gtk_widget_get_window(GTK_WIDGET(window)));
+  return g_signal_connect(frame_clock, "after-paint",
+                          G_CALLBACK(count_paint_cb), counter);
+}
+
+void stop_counting_paints(GtkWindow *window, gulong handler_id) {
+  GdkWindow *gdk_window = gtk_widget_get_window(GTK_WIDGET(window));
+  if (gdk_window != nullptr) {
+    g_signal_handler_disconnect(gdk_window_get_frame_clock(gdk_window),
+                                handler_id);
+  }
+}
+
+// A mapped toplevel with a plugin instance managing it.
+struct Fixture {
+  GtkWindow *window = nullptr;
+  WaylandLayerShellPlugin *plugin = nullptr;
+  int configures = 0;
+
+  gboolean open() {
+    window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_window_set_default_size(window, 400, 300);
+    g_signal_connect(window, "configure-event",
+                     G_CALLBACK(count_configure_cb), &configures);
+    plugin = wayland_layer_shell_plugin_new_for_window(window);
+    gtk_widget_show_all(GTK_WIDGET(window));
+    return wait_for(&configures, 0);
+  }
+
+  gboolean initialize() {
+    g_autoptr(FlValue) args = int_list({400, 300});
+    fl_value_append_take(args, fl_value_new_null());
+    g_autoptr(FlValue) result = invoke(plugin, "initialize", args);
+    return result != nullptr;
+  }
+
+  void close() {
+    g_clear_object(&plugin);
+    gtk_widget_destroy(GTK_WIDGET(window));
+    window = nullptr;
+    while (g_main_context_iteration(nullptr, FALSE)) {
+    }
+  }
+};
+
+gint64 lookup_int(FlValue *map, const gchar *key) {
+  FlValue *value = fl_value_lookup_string(map, key);
+  return value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_INT
+             ? fl_value_get_int(value)
+             : -1;
+}
+
+// initialize on an already visible window, until the compositor configured
+// the new layer surface, plus the phases initialize reports itself.
+void bench_initialize(const Options &options, GString *json) {
+  Samples total, hide, init, configure;
+  for (int i = 0; i < options.initialize_iterations; i++) {
+    Fixture fixture;
+    if (!fixture.open()) {
+      total.timeouts++;
+      fixture.close();
+      continue;
+    }
+
+    g_autoptr(FlValue) args = int_list({400, 300});
+    fl_value_append_take(args, fl_value_new_null());
+    double start = now_us();
+    g_autoptr(FlMethodResponse) response = wayland_layer_shell_plugin_invoke(
+        fixture.plugin, "initialize", args);
+    double elapsed = now_us() - start;
+
+    if (FL_IS_METHOD_SUCCESS_RESPONSE(response)) {
+      FlValue *timings = fl_value_lookup_string(
+          fl_method_success_response_get_result(
+              FL_METHOD_SUCCESS_RESPONSE(response)),
+          "timings");
+      total.values.push_back(elapsed);
+      auto add = [timings](Samples *samples, const gchar *key) {
+        gint64 value = timings != nullptr ? lookup_int(timings, key) : -1;
+        if (value >= 0) {
+          samples->values.push_back(value);
+        }
+      };
+      add(&hide, "hide_us");
+      add(&init, "init_us");
+      add(&configure, "configure_us");
+    } else {
+      total.timeouts++;
+    }
+    fixture.close();
+  }
+
+  total.append_json(json, "initialize_to_configure");
+  g_string_append(json, ",\n");
+  hide.append_json(json, "initialize_hide");
+  g_string_append(json, ",\n");
+  init.append_json(json, "initialize_init");
+  g_string_append(json, ",\n");
+  configure.append_json(json, "initialize_first_configure");
+}
+
+// A size-changing setter, flushed, until GTK sees the compositor's configure
+// for it (gtk-layer-shell acks configures as they arrive).
+void bench_setter_to_configure(const Options &options, GString *json) {
+  Samples samples;
+  Fixture fixture;
+  // initialize returns once the layer surface has been configured.
+  if (fixture.open() && fixture.initialize()) {
+    for (int i = 0; i < options.configure_iterations; i++) {
+      int before = fixture.configures;
+      // The surface is anchored left and right, so the left margin changes
+      // its width and forces a new configure.
+      g_autoptr(FlValue) margin =
+          int_list({GTK_LAYER_SHELL_EDGE_LEFT, (i % 2) * 20 + 10});
+      g_autoptr(FlValue) no_args = fl_value_new_null();
+
+      double start = now_us();
+      g_autoptr(FlValue) set = invoke(fixture.plugin, "setMargin", margin);
+      g_autoptr(FlValue) flushed = invoke(fixture.plugin, "flush", no_args);
+      if (wait_for(&fixture.configures, before)) {
+        samples.values.push_back(now_us() - start);
+      } else {
+        samples.timeouts++;
+      }
+    }
+  } else {
+    samples.timeouts++;
+  }
+  fixture.close();
+  samples.append_json(json, "setter_to_configure");
+}
+
+// A layer change together with a size-changing margin, flushed, until the
+// compositor configured the surface. Before zwlr_layer_shell_v1 version 2
+// every iteration remaps the surface; the remap count is reported alongside.
+void bench_layer_change(const Options &options, GString *json) {
+  Samples samples;
+  gint64 remaps = 0;
+  Fixture fixture;
+  g_autoptr(FlValue) no_args = fl_value_new_null();
+  if (fixture.open() && fixture.initialize()) {
+    g_autoptr(FlValue) stats_before =
+        invoke(fixture.plugin, "getCommitStats", no_args);
+    for (int i = 0; i < options.configure_iterations; i++) {
+      int before = fixture.configures;
+      g_autoptr(FlValue) layer = int_list(
+          {i % 2 ? GTK_LAYER_SHELL_LAYER_OVERLAY : GTK_LAYER_SHELL_LAYER_TOP});
+      g_autoptr(FlValue) margin =
+          int_list({GTK_LAYER_SHELL_EDGE_LEFT, (i % 2) * 20 + 10});
+
+      double start = now_us();
+      g_autoptr(FlValue) set_layer = invoke(fixture.plugin, "setLayer", layer);
+      g_autoptr(FlValue) set_margin =
+          invoke(fixture.plugin, "setMargin", margin);
+      g_autoptr(FlValue) flushed = invoke(fixture.plugin, "flush", no_args);
+      if (wait_for(&fixture.configures, before)) {
+        samples.values.push_back(now_us() - start);
+      } else {
+        samples.timeouts++;
+      }
+    }
+    g_autoptr(FlValue) stats_after =
+        invoke(fixture.plugin, "getCommitStats", no_args);
+    if (stats_before != nullptr && stats_after != nullptr) {
+      remaps = lookup_int(stats_after, "remaps") -
+               lookup_int(stats_before, "remaps");
+    }
+  } else {
+    samples.timeouts++;
+  }
+  fixture.close();
+  samples.append_json(json, "layer_change_to_configure");
+  g_string_append_printf(json,
+                         ",\n    \"layer_change_remaps\": %" G_GINT64_FORMAT,
+                         remaps);
+}
+
+// Hotkey to visible: from the call that shows the surface until GTK painted
+// its first frame afterwards, which it only does once the compositor sent the
+// frame callback for the surface on screen. Compares present on a prepared
+// surface against showWindow on a hidden one, which has to create and
+// configure a new layer surface.
+void bench_present(const Options &options, GString *json) {
+  Samples present, show;
+  Fixture fixture;
+  g_autoptr(FlValue) no_args = fl_value_new_null();
+  g_autoptr(FlValue) present_args = fl_value_new_list();
+  fl_value_append_take(present_args, fl_value_new_bool(FALSE));
+  if (fixture.open() && fixture.initialize()) {
+    g_autoptr(FlValue) prepared = invoke(fixture.plugin, "prepare", no_args);
+    for (int i = 0; i < options.present_iterations; i++) {
+      int paints = 0;
+      gulong handler_id = count_paints(fixture.window, &paints);
+      double start = now_us();
+      g_autoptr(FlValue) result =
+          invoke(fixture.plugin, "present", present_args);
+      if (wait_for(&paints, 0)) {
+        present.values.push_back(now_us() - start);
+      } else {
+        present.timeouts++;
+      }
+      stop_counting_paints(fixture.window, handler_id);
+      g_autoptr(FlValue) dismissed =
+          invoke(fixture.plugin, "dismiss", no_args);
+    }
+
+    for (int i = 0; i < options.present_iterations; i++) {
+      gtk_widget_hide(GTK_WIDGET(fixture.window));
+      while (g_main_context_iteration(nullptr, FALSE)) {
+      }
+      // Hiding unmaps the window but keeps it realized, frame clock and all.
+      int paints = 0;
+      gulong handler_id = count_paints(fixture.window, &paints);
+      double start = now_us();
+      g_autoptr(FlValue) result =
+          invoke(fixture.plugin, "showWindow", no_args);
+      if (wait_for(&paints, 0)) {
+        show.values.push_back(now_us() - start);
+      } else {
+        show.timeouts++;
+      }
+      stop_counting_paints(fixture.window, handler_id);
+    }
+  } else {
+    present.timeouts++;
+    show.timeouts++;
+  }
+  fixture.close();
+  present.append_json(json, "present_to_paint");
+  g_string_append(json, ",\n");
+  show.append_json(json, "show_window_to_paint");
+}
+
+// Connects a non-blocking client to the control socket at @path. Returns -1
+// on failure.
+int connect_control_socket(const gchar *path) {
+  struct sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  g_strlcpy(address.sun_path, path, sizeof(address.sun_path));
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  // Connecting to a listening Unix socket completes right away.
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&address),
+              sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Sends @command on @fd and iterates the main context until the reply line
+// arrives. Returns FALSE on timeout or if the reply is not "ok".
+gboolean control_round_trip(int fd, const gchar *command) {
+  size_t length = strlen(command);
+  if (write(fd, command, length) != static_cast<ssize_t>(length)) {
+    return FALSE;
+  }
+  GString *reply = g_string_new(nullptr);
+  gint64 deadline = g_get_monotonic_time() + kWaitTimeoutUs;
+  while (reply->len == 0 || reply->str[reply->len - 1] != '\n') {
+    if (g_get_monotonic_time() > deadline) {
+      g_string_free(reply, TRUE);
+      return FALSE;
+    }
+    g_main_context_iteration(nullptr, FALSE);
+    gchar buffer[256];
+    ssize_t count = read(fd, buffer, sizeof(buffer));
+    if (count > 0) {
+      g_string_append_len(reply, buffer, count);
+    }
+  }
+  gboolean ok = g_str_equal(reply->str, "ok\n");
+  if (!ok) {
+    g_printerr("Control command %s", reply->str);
+  }
+  g_string_free(reply, TRUE);
+  return ok;
+}
+
+// A command from another process on the control socket until its reply,
+// which is sent once the change has been committed. "ping" is the same round
+// trip without a command, i.e. the socket and main loop overhead.
+void bench_control_socket(const Options &options, GString *json) {
+  Samples commit, ping;
+  Fixture fixture;
+  g_autofree gchar *path = g_strdup_printf(
+      "%s/wayland_layer_shell_benchmark-%d.sock", g_get_tmp_dir(), getpid());
+  g_autoptr(FlValue) listen_args = fl_value_new_list();
+  fl_value_append_take(listen_args, fl_value_new_string(path));
+  int fd = -1;
+  if (fixture.open() && fixture.initialize()) {
+    g_autoptr(FlValue) listening =
+        invoke(fixture.plugin, "listenControlSocket", listen_args);
+    if (listening != nullptr) {
+      fd = connect_control_socket(path);
+    }
+  }
+  if (fd >= 0) {
+    for (int i = 0; i < options.control_iterations; i++) {
+      const gchar *command =
+          i % 2 == 0 ? "setLayer overlay\n" : "setLayer top\n";
+      double start = now_us();
+      if (control_round_trip(fd, command)) {
+        commit.values.push_back(now_us() - start);
+      } else {
+        commit.timeouts++;
+      }
+    }
+    for (int i = 0; i < options.control_iterations; i++) {
+      double start = now_us();
+      if (control_round_trip(fd, "ping\n")) {
+        ping.values.push_back(now_us() - start);
+      } else {
+        ping.timeouts++;
+      }
+    }
+    close(fd);
+  } else {
+    commit.timeouts++;
+    ping.timeouts++;
+  }
+  fixture.close();
+  commit.append_json(json, "control_socket_to_commit");
+  g_string_append(json, ",\n");
+  ping.append_json(json, "control_socket_ping");
+}
+
+void frame_presented_cb(const PresentedFrame *frame, gpointer user_data) {
+  Samples *samples = static_cast<Samples *>(user_data);
+  if (frame->presented) {
+    samples->values.push_back(frame->latency_us);
+  } else {
+    samples->timeouts++;
+  }
+}
+
+// From GTK painting a frame until the compositor reports it on screen
+// through wp_presentation. Empty if the compositor lacks the protocol.
+// Discarded frames count as timeouts.
+void bench_presentation(const Options &options, GString *json) {
+  Samples samples;
+  Fixture fixture;
+  if (fixture.open() && fixture.initialize()) {
+    FramePresentation *presentation =
+        frame_presentation_new(fixture.window, frame_presented_cb, &samples);
+    frame_presentation_set_enabled(presentation, TRUE);
+    if (frame_presentation_is_supported(presentation)) {
+      gint64 deadline = g_get_monotonic_time() +
+                        options.presented_frames * kWaitTimeoutUs / 10;
+      while (static_cast<int>(samples.values.size()) + samples.timeouts <
+                 options.presented_frames &&
+             g_get_monotonic_time() < deadline) {
+        gtk_widget_queue_draw(GTK_WIDGET(fixture.window));
+        g_main_context_iteration(nullptr, TRUE);
+      }
+    }
+    frame_presentation_free(presentation);
+  } else {
+    samples.timeouts++;
+  }
+  fixture.close();
+  samples.append_json(json, "paint_to_presented");
+}
+
+void bench_monitor_list(const Options &options, GString *json, int *count) {
+  Samples samples;
+  Fixture fixture;
+  fixture.open();
+  g_autoptr(FlValue) no_args = fl_value_new_null();
+  for (int i = 0; i < options.monitor_list_iterations; i++) {
+    double start = now_us();
+    g_autoptr(FlValue) monitors =
+        invoke(fixture.plugin, "getMonitorList", no_args);
+    samples.values.push_back(now_us() - start);
+    *count = monitors != nullptr ? fl_value_get_length(monitors) : 0;
+  }
+  fixture.close();
+  samples.append_json(json, "monitor_list");
+}
+
+// Back-to-back setters the way a widget tree re-asserting its config issues
+// them: every other call repeats the previous value.
+void bench_setter_storm(const Options &options, GString *json) {
+  Fixture fixture;
+  if (!fixture.open() || !fixture.initialize()) {
+    fixture.close();
+    g_string_append(json, "    \"setter_storm\": {\"failed\": true}");
+    return;
+  }
+
+  g_autoptr(FlValue) no_args = fl_value_new_null();
+  g_autoptr(FlValue) stats_before =
+      invoke(fixture.plugin, "getCommitStats", no_args);
+
+  double start = now_us();
+  for (int i = 0; i < options.storm_calls; i++) {
+    g_autoptr(FlValue) args = int_list(
+        {(i / 2) % GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER, (i / 8) % 16});
+    g_autoptr(FlValue) result = invoke(fixture.plugin, "setMargin", args);
+  }
+  g_autoptr(FlValue) flushed = invoke(fixture.plugin, "flush", no_args);
+  double elapsed = now_us() - start;
+
+  g_autoptr(FlValue) stats_after =
+      invoke(fixture.plugin, "getCommitStats", no_args);
+  fixture.close();
+
+  auto delta = [&](const gchar *key) {
+    return lookup_int(stats_after, key) - lookup_int(stats_before, key);
+  };
+  g_string_append_printf(
+      json,
+      "    \"setter_storm\": {\"calls\": %d, \"elapsed_us\": %.3f, "
+      "\"calls_per_second\": %.0f, \"elided_calls\": %" G_GINT64_FORMAT
+      ", \"commits\": %" G_GINT64_FORMAT "}",
+      options.storm_calls, elapsed, options.storm_calls / elapsed * 1e6,
+      delta("elided_calls"), delta("commits"));
+}
+
+// getLayer the way Dart reaches it through the method channel (encoding the
+// call, dispatching it and decoding the response, minus the thread hops)
+// against the C API dart:ffi calls, which reads the published snapshot.
+void bench_getter_paths(const Options &options, GString *json) {
+  Fixture fixture;
+  if (!fixture.open() || !fixture.initialize() ||
+      wayland_layer_shell_ffi_is_attached() != 1) {
+    fixture.close();
+    g_string_append(json, "    \"getter_paths\": {\"failed\": true}");
+    return;
+  }
+
+  g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
+  FlMethodCodec *method_codec = FL_METHOD_CODEC(codec);
+  int mismatches = 0;
+  double start = now_us();
+  for (int i = 0; i < options.getter_calls; i++) {
+    GBytes *message = fl_method_codec_encode_method_call(
+        method_codec, "getLayer", nullptr, nullptr);
+    g_autofree gchar *name = nullptr;
+    g_autoptr(FlValue) args = nullptr;
+    fl_method_codec_decode_method_call(method_codec, message, &name, &args,
+                                       nullptr);
+    g_bytes_unref(message);
+    g_autoptr(FlMethodResponse) response =
+        wayland_layer_shell_plugin_invoke(fixture.plugin, name, args);
+    GBytes *envelope = fl_method_codec_encode_success_envelope(
+        method_codec,
+        fl_method_success_response_get_result(
+            FL_METHOD_SUCCESS_RESPONSE(response)),
+        nullptr);
+    g_autoptr(FlMethodResponse) decoded =
+        fl_method_codec_decode_response(method_codec, envelope, nullptr);
+    g_bytes_unref(envelope);
+    if (decoded == nullptr) {
+      mismatches++;
+    }
+  }
+  double channel_elapsed = now_us() - start;
+
+  gint64 layer = gtk_layer_get_layer(fixture.window);
+  start = now_us();
+  for (int i = 0; i < options.getter_calls; i++) {
+    if (wayland_layer_shell_ffi_get_layer() != layer) {
+      mismatches++;
+    }
+  }
+  double ffi_elapsed = now_us() - start;
+  fixture.close();
+
+  g_string_append_printf(
+      json,
+      "    \"getter_paths\": {\"calls\": %d, \"channel_ns_per_call\": %.1f, "
+      "\"ffi_ns_per_call\": %.1f, \"mismatches\": %d}",
+      options.getter_calls, channel_elapsed * 1000 / options.getter_calls,
+      ffi_elapsed * 1000 / options.getter_calls, mismatches);
+}
+
+double lookup_float(FlValue *map, const gchar *key) {
+  FlValue *value = fl_value_lookup_string(map, key);
+  return value != nullptr && fl_value_get_type(value) == FL_VALUE_TYPE_FLOAT
+             ? fl_value_get_float(value)
+             : -1;
+}
+
+// Pixels GTK rasterizes per frame at its integer buffer scale against what
+// the compositor's preferred fractional scale would need. The preferred
+// scale arrives some time after the surface is mapped.
+void bench_scale(GString *json) {
+  Fixture fixture;
+  if (!fixture.open() || !fixture.initialize()) {
+    fixture.close();
+    g_string_append(json, "    \"scale\": {\"failed\": true}");
+    return;
+  }
+
+  g_autoptr(FlValue) no_args = fl_value_new_null();
+  FlValue *info = invoke(fixture.plugin, "getScaleInfo", no_args);
+  gint64 deadline = g_get_monotonic_time() + kWaitTimeoutUs;
+  while (info != nullptr && lookup_float(info, "preferred_scale") <= 0 &&
+         fl_value_get_bool(
+             fl_value_lookup_string(info, "fractional_scale_supported")) &&
+         g_get_monotonic_time() < deadline) {
+    g_main_context_iteration(nullptr, FALSE);
+    fl_value_unref(info);
+    info = invoke(fixture.plugin, "getScaleInfo", no_args);
+  }
+  fixture.close();
+  if (info == nullptr) {
+    g_string_append(json, "    \"scale\": {\"failed\": true}");
+    return;
+  }
+
+  g_string_append_printf(
+      json,
+      "    \"scale\": {\"fractional_scale_supported\": %s, "
+      "\"preferred_scale\": %.3f, \"buffer_scale\": %" G_GINT64_FORMAT
+      ", \"rendered_pixels\": %" G_GINT64_FORMAT
+      ", \"exact_pixels\": %" G_GINT64_FORMAT "}",
+      fl_value_get_bool(
+          fl_value_lookup_string(info, "fractional_scale_supported"))
+          ? "true"
+          : "false",
+      lookup_float(info, "preferred_scale"), lookup_int(info, "buffer_scale"),
+      lookup_int(info, "rendered_pixels"), lookup_int(info, "exact_pixels"));
+  fl_value_unref(info);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  GOptionEntry entries[] = {
+      {"json", 'o', 0, G_OPTION_ARG_FILENAME, &options.json_path,
+       "Write results to FILE instead of stdout", "FILE"},
+      {"initialize-iterations", 0, 0, G_OPTION_ARG_INT,
+       &options.initialize_iterations, "Windows to initialize", "N"},
+      {"configure-iterations", 0, 0, G_OPTION_ARG_INT,
+       &options.configure_iterations, "Setter/configure round trips", "N"},
+      {"monitor-list-iterations", 0, 0, G_OPTION_ARG_INT,
+       &options.monitor_list_iterations, "getMonitorList calls", "N"},
+      {"storm-calls", 0, 0, G_OPTION_ARG_INT, &options.storm_calls,
+       "Setter calls in the storm", "N"},
+      {"getter-calls", 0, 0, G_OPTION_ARG_INT, &options.getter_calls,
+       "getLayer calls per path", "N"},
+      {"present-iterations", 0, 0, G_OPTION_ARG_INT,
+       &options.present_iterations, "present and showWindow calls", "N"},
+      {"control-iterations", 0, 0, G_OPTION_ARG_INT,
+       &options.control_iterations, "Control socket round trips", "N"},
+      {"presented-frames", 0, 0, G_OPTION_ARG_INT, &options.presented_frames,
+       "Frames to collect presentation feedback for", "N"},
+      {"expected-outputs", 0, 0, G_OPTION_ARG_INT, &options.expected_outputs,
+       "Fail unless the compositor has N outputs", "N"},
+      {nullptr}};
+  g_autoptr(GError) error = nullptr;
+  if (!gtk_init_with_args(&argc, &argv, nullptr, entries, nullptr, &error)) {
+    g_printerr("%s\n", error != nullptr ? error->message : "No display");
+    return 1;
+  }
+  if (!gtk_layer_is_supported()) {
+    g_printerr("The compositor does not support layer shell\n");
+    return 77;
+  }
+
+  g_autoptr(GString) json = g_string_new("{\n");
+  g_string_append_printf(json, "  \"gtk_layer_shell\": \"%u.%u.%u\",\n",
+                         gtk_layer_get_major_version(),
+                         gtk_layer_get_minor_version(),
+                         gtk_layer_get_micro_version());
+  g_string_append_printf(json, "  \"layer_shell_protocol\": %u,\n",
+                         layer_shell_caps_get()->protocol_version);
+  g_string_append(json, "  \"benchmarks\": {\n");
+  bench_initialize(options, json);
+  g_string_append(json, ",\n");
+  bench_setter_to_configure(options, json);
+  g_string_append(json, ",\n");
+  bench_layer_change(options, json);
+  g_string_append(json, ",\n");
+  bench_present(options, json);
+  g_string_append(json, ",\n");
+  bench_control_socket(options, json);
+  g_string_append(json, ",\n");
+  bench_presentation(options, json);
+  g_string_append(json, ",\n");
+  int monitors = 0;
+  bench_monitor_list(options, json, &monitors);
+  g_string_append(json, ",\n");
+  bench_setter_storm(options, json);
+  g_string_append(json, ",\n");
+  bench_getter_paths(options, json);
+  g_string_append(json, ",\n");
+  bench_scale(json);
+  g_string_append_printf(json, "\n  },\n  \"monitors\": %d\n}\n", monitors);
+
+  if (options.json_path != nullptr) {
+    if (!g_file_set_contents(options.json_path, json->str, json->len,
+                             &error)) {
+      g_printerr("%s\n", error->message);
+      return 1;
+    }
+  } else {
+    fputs(json->str, stdout);
+  }
+
+  if (options.expected_outputs > 0 && monitors != options.expected_outputs) {
+    g_printerr("Expected %d outputs, the compositor has %d\n",
+               options.expected_outputs, monitors);
+    return 1;
+  }
+  return 0;
+}
@@ -1,17 +1,29 @@
 #include <flutter_linux/flutter_linux.h>
+#include <glib/gstdio.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <gtk-layer-shell/gtk-layer-shell.h>
 
+#include <algorithm>
+#include <cstring>
+
+#include "channel_api.g.h"
+#include "include/wayland_layer_shell/wayland_layer_shell_ffi.h"
 #include "include/wayland_layer_shell/wayland_layer_shell_plugin.h"
+#include "layer_animator.h"
+#include "layer_surface_queue.h"
+#include "monitor_registry.h"
+#include "plugin_log.h"
+#include "plugin_stats.h"
+#include "plugin_trace.h"
 #include "wayland_layer_shell_plugin_private.h"
 
-// This demonstrates a simple unit test of the C portion of this plugin's
-// implementation.
+// Unit tests of the plugin's native code.
 //
-// Once you have built the plugin's example app, you can run these tests
-// from the command line. For instance, for a plugin called my_plugin
-// built for x64 debug, run:
-// $ build/linux/x64/debug/plugins/my_plugin/my_plugin_test
+// Configure the example app with -DWAYLAND_LAYER_SHELL_TESTS=ON, then run
+// `ctest -R wayland_layer_shell_test` in the plugin's build directory or the
+// binary itself, e.g. for x64 debug:
+// $ build/linux/x64/debug/plugins/wayland_layer_shell/wayland_layer_shell_test
 
 namespace wayland_layer_shell {
 namespace test {
@@ -27,5 +39,325 @@ TEST(WaylandLayerShellPlugin, GetPlatformVersion) {
   EXPECT_THAT(fl_value_get_string(result), testing::StartsWith("Linux "));
 }
 
+TEST(WaylandLayerShellPlugin, LookupMethod) {
+  for (size_t i = 0; i < channel_api::kMethodCount; i++) {
+    EXPECT_EQ(channel_api::lookup_method(channel_api::kMethodNames[i]),
+              static_cast<channel_api::Method>(i));
+  }
+  EXPECT_EQ(channel_api::lookup_method("setMarginX"),
+            channel_api::Method::kUnknown);
+  EXPECT_EQ(channel_api::lookup_method(""), channel_api::Method::kUnknown);
+}
+
+TEST(WaylandLayerShellPlugin, EasingEndpoints) {
+  for (LayerEasing easing :
+       {LAYER_EASING_LINEAR, LAYER_EASING_EASE_IN, LAYER_EASING_EASE_OUT,
+        LAYER_EASING_EASE_IN_OUT}) {
+    EXPECT_DOUBLE_EQ(layer_easing_apply(easing, 0.0), 0.0);
+    EXPECT_DOUBLE_EQ(layer_easing_apply(easing, 1.0), 1.0);
+  }
+  EXPECT_DOUBLE_EQ(layer_easing_apply(LAYER_EASING_EASE_IN_OUT, 0.5), 0.5);
+  EXPECT_LT(layer_easing_apply(LAYER_EASING_EASE_IN, 0.5), 0.5);
+  EXPECT_GT(layer_easing_apply(LAYER_EASING_EASE_OUT, 0.5), 0.5);
+}
+
+TEST(WaylandLayerShellPlugin, LogLevelsAndRing) {
+  EXPECT_EQ(plugin_log_parse_level("DEBUG"), PLUGIN_LOG_DEBUG);
+  EXPECT_EQ(plugin_log_parse_level("off"), PLUGIN_LOG_OFF);
+  EXPECT_EQ(plugin_log_parse_level("2"), PLUGIN_LOG_WARNING);
+  EXPECT_EQ(plugin_log_parse_level("7"), -1);
+  EXPECT_EQ(plugin_log_parse_level("loud"), -1);
+
+  plugin_log_set_level(PLUGIN_LOG_INFO);
+  PLUGIN_LOG_D("dropped");
+  PLUGIN_LOG_I("kept %d", 42);
+
+  PluginLogRecord record;
+  ASSERT_EQ(plugin_log_snapshot(&record, 1), 1u);
+  EXPECT_EQ(record.level, PLUGIN_LOG_INFO);
+  EXPECT_STREQ(record.message, "kept 42");
+}
+
+TEST(WaylandLayerShellPlugin, StatsBuckets) {
+  for (int bucket = 0; bucket < kStatsBuckets - 1; bucket++) {
+    guint64 start = plugin_stats_bucket_start(bucket);
+    guint64 end = plugin_stats_bucket_start(bucket + 1);
+    ASSERT_LT(start, end);
+    EXPECT_EQ(plugin_stats_bucket(start), bucket);
+    EXPECT_EQ(plugin_stats_bucket(end - 1), bucket);
+  }
+  EXPECT_EQ(plugin_stats_bucket(G_MAXUINT64), kStatsBuckets - 1);
+
+  MethodStats method_stats = {};
+  for (guint64 us = 1; us <= 100; us++) {
+    method_stats.calls++;
+    method_stats.max_ns = us * 1000;
+    method_stats.buckets[plugin_stats_bucket(us * 1000)]++;
+  }
+  guint64 p50 = plugin_stats_percentile(&method_stats, 50);
+  EXPECT_GE(p50, 50000u);
+  EXPECT_LE(p50, 62500u);
+  EXPECT_EQ(plugin_stats_percentile(&method_stats, 100), 100000u);
+}
+
+TEST(WaylandLayerShellPlugin, ConfigArgs) {
+  WaylandLayerShellConfig config;
+  wayland_layer_shell_config_init(&config);
+
+  gchar arg0[] = "--unrelated";
+  gchar arg1[] = "--layer-shell-layer=overlay";
+  gchar arg2[] = "--layer-shell-anchors=top,left";
+  gchar arg3[] = "--layer-shell-margins=1;2;3;4";
+  gchar arg4[] = "--layer-shell-exclusive-zone=32";
+  gchar arg5[] = "--layer-shell-monitor=2";
+  gchar* args[] = {arg0, arg1, arg2, arg3, arg4, arg5, nullptr};
+  gboolean found = FALSE;
+  g_autoptr(GError) error = nullptr;
+  ASSERT_TRUE(
+      wayland_layer_shell_config_load_args(&config, args, &found, &error));
+  EXPECT_TRUE(found);
+  EXPECT_EQ(config.layer, 3);
+  EXPECT_TRUE(config.anchors[0]);
+  EXPECT_FALSE(config.anchors[1]);
+  EXPECT_TRUE(config.anchors[2]);
+  EXPECT_FALSE(config.anchors[3]);
+  EXPECT_EQ(config.margins[3], 4);
+  EXPECT_FALSE(config.auto_exclusive_zone);
+  EXPECT_EQ(config.exclusive_zone, 32);
+  EXPECT_STREQ(config.monitor, "2");
+
+  gchar bad[] = "--layer-shell-layer=sideways";
+  gchar* bad_args[] = {bad, nullptr};
+  EXPECT_FALSE(
+      wayland_layer_shell_config_load_args(&config, bad_args, &found, &error));
+  EXPECT_NE(error, nullptr);
+
+  wayland_layer_shell_config_clear(&config);
+  EXPECT_EQ(config.monitor, nullptr);
+}
+
+TEST(WaylandLayerShellPlugin, TraceFile) {
+  g_autofree gchar* path =
+      g_build_filename(g_get_tmp_dir(), "wayland_layer_shell_test.json", NULL);
+  PLUGIN_TRACE_INSTANT("before");
+  ASSERT_TRUE(plugin_trace_start(path));
+  guint64 start = PLUGIN_TRACE_BEGIN();
+  EXPECT_NE(start, 0u);
+  PLUGIN_TRACE_END(start, "span", "fields", 3);
+  PLUGIN_TRACE_INSTANT("configure", "width", 800, "height", 32);
+
+  size_t events = 0;
+  guint64 dropped = 0;
+  g_autofree gchar* written = plugin_trace_stop(&events, &dropped, nullptr);
+  ASSERT_STREQ(written, path);
+  EXPECT_EQ(events, 2u);
+  EXPECT_EQ(dropped, 0u);
+  EXPECT_EQ(PLUGIN_TRACE_BEGIN(), 0u);
+
+  g_autofree gchar* contents = nullptr;
+  ASSERT_TRUE(g_file_get_contents(path, &contents, nullptr, nullptr));
+  EXPECT_NE(strstr(contents, "\"name\":\"span\""), nullptr);
+  EXPECT_NE(strstr(contents, "\"fields\":3"), nullptr);
+  EXPECT_NE(strstr(contents, "\"width\":800,\"height\":32"), nullptr);
+  EXPECT_EQ(strstr(contents, "before"), nullptr);
+  g_unlink(path);
+}
+
+TEST(WaylandLayerShellPlugin, FfiWithoutWindow) {
+  EXPECT_EQ(wayland_layer_shell_ffi_abi_version(),
+            WAYLAND_LAYER_SHELL_FFI_ABI_VERSION);
+  EXPECT_EQ(wayland_layer_shell_ffi_is_attached(), 0);
+  EXPECT_EQ(wayland_layer_shell_ffi_get_layer(), -1);
+  EXPECT_EQ(wayland_layer_shell_ffi_get_anchor(GTK_LAYER_SHELL_EDGE_TOP), -1);
+  EXPECT_EQ(wayland_layer_shell_ffi_set_layer(GTK_LAYER_SHELL_LAYER_TOP), 0);
+  EXPECT_EQ(wayland_layer_shell_ffi_flush(), 0);
+}
+
+TEST(WaylandLayerShellPlugin, MonitorIdsSurviveReplug) {
+  MonitorRegistry registry = {};
+  auto plug = [&registry]() {
+    MonitorInfo info = {};
+    info.manufacturer = "ACME";
+    info.model = "Panel";
+    info.width_mm = 600;
+    info.height_mm = 340;
+    info.id = monitor_registry_assign_id(&registry, &info);
+    registry.monitors.push_back(info);
+    return info.id;
+  };
+  auto unplug = [&registry](guint id) {
+    auto it = std::find_if(
+        registry.monitors.begin(), registry.monitors.end(),
+        [id](const MonitorInfo& info) { return info.id == id; });
+    registry.monitors.erase(it);
+  };
+
+  guint a = plug();
+  guint b = plug();
+  EXPECT_NE(a, b);
+
+  unplug(a);
+  EXPECT_EQ(plug(), a);
+
+  unplug(b);
+  unplug(a);
+  EXPECT_EQ(plug(), a);
+  EXPECT_EQ(plug(), b);
+  EXPECT_EQ(registry.known_ids.size(), 2u);
+}
+
+// The tests below need a display; the queue ones also a layer shell, as
+// they apply state to the window.
+static gboolean have_layer_shell() {
+  return gtk_init_check(nullptr, nullptr) && gtk_layer_is_supported();
+}
+
+static FlValue* edge_args(gint64 edge, FlValue* value) {
+  FlValue* args = fl_value_new_list();
+  fl_value_append_take(args, fl_value_new_int(edge));
+  if (value != nullptr) {
+    fl_value_append_take(args, value);
+  }
+  return args;
+}
+
+static void expect_bad_args(WaylandLayerShellPlugin* plugin,
+                            const gchar* method, FlValue* args) {
+  g_autoptr(FlMethodResponse) response =
+      wayland_layer_shell_plugin_invoke(plugin, method, args);
+  ASSERT_TRUE(FL_IS_METHOD_ERROR_RESPONSE(response)) << method;
+  EXPECT_STREQ(fl_method_error_response_get_code(
+                   FL_METHOD_ERROR_RESPONSE(response)),
+               "bad_args")
+      << method;
+}
+
+TEST(WaylandLayerShellPlugin, RejectsOutOfRangeEnums) {
+  if (!gtk_init_check(nullptr, nullptr)) {
+    GTEST_SKIP() << "No display";
+  }
+  GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+  g_autoptr(WaylandLayerShellPlugin) plugin =
+      wayland_layer_shell_plugin_new_for_window(window);
+
+  for (gint64 edge : {static_cast<gint64>(-1),
+                      static_cast<gint64>(GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER)}) {
+    g_autoptr(FlValue) anchor = edge_args(edge, fl_value_new_bool(TRUE));
+    expect_bad_args(plugin, "setAnchor", anchor);
+    g_autoptr(FlValue) margin = edge_args(edge, fl_value_new_int(8));
+    expect_bad_args(plugin, "setMargin", margin);
+    g_autoptr(FlValue) get = edge_args(edge, nullptr);
+    expect_bad_args(plugin, "getAnchor", get);
+    expect_bad_args(plugin, "getMargin", get);
+  }
+  g_autoptr(FlValue) layer =
+      edge_args(GTK_LAYER_SHELL_LAYER_ENTRY_NUMBER, nullptr);
+  expect_bad_args(plugin, "setLayer", layer);
+  g_autoptr(FlValue) keyboard_mode =
+      edge_args(GTK_LAYER_SHELL_KEYBOARD_MODE_ENTRY_NUMBER, nullptr);
+  expect_bad_args(plugin, "setKeyboardMode", keyboard_mode);
+
+  for (const gchar* method : {"animateMargins", "animateSize"}) {
+    for (gint64 duration_ms : {-1, 100}) {
+      g_autoptr(FlValue) animate = fl_value_new_list();
+      fl_value_append_take(animate, fl_value_new_null());
+      fl_value_append_take(animate, fl_value_new_int32_list(nullptr, 0));
+      fl_value_append_take(animate, fl_value_new_int(duration_ms));
+      fl_value_append_take(animate, fl_value_new_int(duration_ms < 0 ? 0 : 4));
+      expect_bad_args(plugin, method, animate);
+    }
+  }
+
+  gtk_widget_destroy(GTK_WIDGET(window));
+}
+
+TEST(WaylandLayerShellPlugin, QueueElidesNoOpSetters) {
+  if (!have_layer_shell()) {
+    GTEST_SKIP() << "No layer shell";
+  }
+  GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+  gtk_layer_init_for_window(window);
+  LayerSurfaceQueue queue;
+  layer_surface_queue_init(&queue, window);
+
+  layer_surface_queue_set_margin(&queue, GTK_LAYER_SHELL_EDGE_TOP, 0);
+  layer_surface_queue_set_anchor(&queue, GTK_LAYER_SHELL_EDGE_TOP, FALSE);
+  layer_surface_queue_set_margin(&queue, GTK_LAYER_SHELL_EDGE_TOP, 12);
+  layer_surface_queue_set_margin(&queue, GTK_LAYER_SHELL_EDGE_TOP, 12);
+  EXPECT_EQ(queue.setter_calls, 4u);
+  EXPECT_EQ(queue.elided_calls, 3u);
+  EXPECT_EQ(gtk_layer_get_margin(window, GTK_LAYER_SHELL_EDGE_TOP), 12);
+
+  layer_surface_queue_clear(&queue);
+  gtk_widget_destroy(GTK_WIDGET(window));
+}
+
+TEST(WaylandLayerShellPlugin, QueueCoalescesUntilFlush) {
+  if (!have_layer_shell()) {
+    GTEST_SKIP() << "No layer shell";
+  }
+  GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+  gtk_layer_init_for_window(window);
+  gtk_widget_show(GTK_WIDGET(window));
+  LayerSurfaceQueue queue;
+  layer_surface_queue_init(&queue, window);
+
+  layer_surface_queue_set_margin(&queue, GTK_LAYER_SHELL_EDGE_LEFT, 4);
+  layer_surface_queue_set_margin(&queue, GTK_LAYER_SHELL_EDGE_LEFT, 16);
+  layer_surface_queue_set_anchor(&queue, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
+  layer_surface_queue_set_exclusive_zone(&queue, 32);
+  EXPECT_EQ(queue.commits, 0u);
+  EXPECT_EQ(gtk_layer_get_margin(window, GTK_LAYER_SHELL_EDGE_LEFT), 0);
+
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(&queue, &state);
+  EXPECT_EQ(state.margins[GTK_LAYER_SHELL_EDGE_LEFT], 16);
+  EXPECT_TRUE(state.anchors[GTK_LAYER_SHELL_EDGE_BOTTOM]);
+
+  layer_surface_queue_flush(&queue);
+  EXPECT_EQ(queue.commits, 1u);
+  EXPECT_EQ(gtk_layer_get_margin(window, GTK_LAYER_SHELL_EDGE_LEFT), 16);
+  EXPECT_EQ(gtk_layer_get_exclusive_zone(window), 32);
+
+  layer_surface_queue_clear(&queue);
+  gtk_widget_destroy(GTK_WIDGET(window));
+}
+
+TEST(WaylandLayerShellPlugin, QueueHoldsSettersForPresent) {
+  if (!have_layer_shell()) {
+    GTEST_SKIP() << "No layer shell";
+  }
+  GtkWindow* window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+  gtk_layer_init_for_window(window);
+  LayerSurfaceQueue queue;
+  layer_surface_queue_init(&queue, window);
+
+  LayerSurfaceState held;
+  layer_surface_queue_get_state(&queue, &held);
+  layer_surface_queue_hold(&queue, &held);
+  LayerSurfaceState hidden = held;
+  hidden.anchors[GTK_LAYER_SHELL_EDGE_BOTTOM] = TRUE;
+  hidden.margins[GTK_LAYER_SHELL_EDGE_BOTTOM] = -100;
+  layer_surface_queue_set_state(&queue, &hidden);
+  layer_surface_queue_set_margin(&queue, GTK_LAYER_SHELL_EDGE_BOTTOM, 8);
+  layer_surface_queue_set_anchor(&queue, GTK_LAYER_SHELL_EDGE_LEFT, TRUE);
+  EXPECT_EQ(gtk_layer_get_margin(window, GTK_LAYER_SHELL_EDGE_BOTTOM), -100);
+  EXPECT_FALSE(gtk_layer_get_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT));
+  EXPECT_EQ(held.margins[GTK_LAYER_SHELL_EDGE_BOTTOM], 8);
+
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(&queue, &state);
+  EXPECT_EQ(state.margins[GTK_LAYER_SHELL_EDGE_BOTTOM], 8);
+  EXPECT_TRUE(state.anchors[GTK_LAYER_SHELL_EDGE_LEFT]);
+
+  layer_surface_queue_set_state(&queue, &held);
+  layer_surface_queue_hold(&queue, nullptr);
+  EXPECT_EQ(gtk_layer_get_margin(window, GTK_LAYER_SHELL_EDGE_BOTTOM), 8);
+  EXPECT_TRUE(gtk_layer_get_anchor(window, GTK_LAYER_SHELL_EDGE_LEFT));
+
+  layer_surface_queue_clear(&queue);
+  gtk_widget_destroy(GTK_WIDGET(window));
+}
+
 }  // namespace test
 }  // namespace wayland_layer_shell
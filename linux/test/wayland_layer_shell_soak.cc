@@ -0,0 +1,749 @@
+#include <flutter_linux/flutter_linux.h>
+#include <glib/gstdio.h>
+#include <gtk-layer-shell/gtk-layer-shell.h>
+#include <gtk/gtk.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "channel_api.g.h"
+#include "frame_governor.h"
+#include "include/wayland_layer_shell/wayland_layer_shell_plugin.h"
+#include "plugin_log.h"
+#include "wayland_layer_shell_plugin_private.h"
+
+// Soak test for the plugin's method handlers: calls each of them a million
+// times (--calls), cycles windows through create/initialize/destroy and,
+// under sway, plugs outputs in and out, while counting every allocation the
+// main thread makes. Fails if a handler retains memory across calls, if the
+// allocations per call grow over the run, or if the resident set grows by
+// more than --max-rss-growth-kb. The allocations of each handler are
+// reported as JSON, so it is visible which calls allocate at all.
+//
+// Runs inside the same headless compositor as the benchmark:
+//   test/run_benchmark.sh <build dir>/wayland_layer_shell_soak soak.json
+// Exits with 77 if there is no layer shell.
+
+// Allocation counting shim. Defining malloc and friends in the executable
+// takes precedence over glibc's for every library in the process; they
+// forward to glibc's own entry points. Only the main thread counts, and only
+// while `counting` is set, so GIO and GDK worker threads add no noise.
+// reallocs count as an allocation and a free, so retained memory is
+// allocations - frees either way.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void __libc_free(void *pointer);
+}
+
+namespace {
+thread_local bool counting = false;
+uint64_t allocations = 0;
+uint64_t frees = 0;
+}  // namespace
+
+extern "C" void *malloc(size_t size) noexcept {
+  if (counting) {
+    allocations++;
+  }
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept {
+  if (counting) {
+    allocations++;
+  }
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size) noexcept {
+  if (counting) {
+    if (pointer != nullptr) {
+      frees++;
+    }
+    if (pointer == nullptr || size != 0) {
+      allocations++;
+    }
+  }
+  return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void *pointer) noexcept {
+  if (counting && pointer != nullptr) {
+    frees++;
+  }
+  __libc_free(pointer);
+}
+
+namespace {
+
+// How long to wait for the compositor before a cycle counts as timed out.
+constexpr gint64 kWaitTimeoutUs = 2 * G_USEC_PER_SEC;
+
+// Each soak is split into this many rounds; the first and last are compared
+// to catch allocations per call that grow over time.
+constexpr int kRounds = 10;
+
+struct Options {
+  const gchar *json_path = nullptr;
+  int calls = 1000000;
+  int window_cycles = 1000;
+  int hotplug_cycles = 200;
+  int expected_outputs = 0;
+  // A leak on one call in a hundred is still a leak a bar running for weeks
+  // notices; anything below is left to caches settling.
+  double max_retained_per_call = 0.01;
+  double max_retained_per_cycle = 1.0;
+  // Allowed growth from the first to the last round, relative and absolute.
+  double max_growth = 0.25;
+  int max_rss_growth_kb = 8192;
+};
+
+struct Count {
+  uint64_t allocations;
+  uint64_t frees;
+};
+
+Count read_count() { return {allocations, frees}; }
+
+// Allocations and frees between two counts.
+Count since(const Count &start) {
+  return {allocations - start.allocations, frees - start.frees};
+}
+
+long resident_kb() {
+  long size = 0;
+  long resident = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) {
+    return 0;
+  }
+  if (fscanf(statm, "%ld %ld", &size, &resident) != 2) {
+    resident = 0;
+  }
+  fclose(statm);
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+void drain_main_loop() {
+  while (g_main_context_iteration(nullptr, FALSE)) {
+  }
+}
+
+FlValue *int_list(std::initializer_list<gint64> values) {
+  FlValue *list = fl_value_new_list();
+  for (gint64 value : values) {
+    fl_value_append_take(list, fl_value_new_int(value));
+  }
+  return list;
+}
+
+// Arguments for the @i-th call of a method.
+typedef FlValue *(*ArgsFunc)(int i);
+
+// Set up before the soak starts.
+gint64 monitor_id = -1;
+gchar *trace_path = nullptr;
+gchar *socket_path = nullptr;
+
+FlValue *path_args(const gchar *path) {
+  FlValue *args = fl_value_new_list();
+  fl_value_append_take(args, fl_value_new_string(path));
+  return args;
+}
+
+FlValue *trace_args(int i) { return path_args(trace_path); }
+FlValue *socket_args(int i) { return path_args(socket_path); }
+
+FlValue *present_args(int i) {
+  FlValue *args = fl_value_new_list();
+  fl_value_append_take(args, fl_value_new_bool(FALSE));
+  return args;
+}
+
+FlValue *animate_size_args(int i) {
+  FlValue *args = fl_value_new_list();
+  fl_value_append_take(args, fl_value_new_null());
+  fl_value_append_take(args, int_list({400, 300}));
+  fl_value_append_take(args, fl_value_new_int(100));
+  fl_value_append_take(args, fl_value_new_int(0));
+  return args;
+}
+
+// One handler to soak. Stateful handlers get a setup or teardown call that
+// is not counted, e.g. prepare before each present. Calls alternate between
+// a changed value on even @i and the default on odd @i, so each setter does
+// real work and the surface ends up as it started.
+struct SoakCall {
+  const gchar *method;
+  ArgsFunc args;
+  const gchar *setup;
+  ArgsFunc setup_args;
+  const gchar *teardown;
+  ArgsFunc teardown_args;
+  // Handlers that do file or socket I/O or remap the surface are called
+  // this many times less often.
+  int divisor;
+};
+
+const SoakCall kCalls[] = {
+    {"getPlatformVersion"},
+    {"isSupported"},
+    {"getCapabilities"},
+    {"isFfiWindow"},
+    // Returns early on the already initialized window.
+    {"initialize",
+     [](int i) {
+       FlValue *args = int_list({400, 300});
+       fl_value_append_take(args, fl_value_new_null());
+       return args;
+     }},
+    {"showWindow"},
+    {"prepare", nullptr, nullptr, nullptr, "present", present_args},
+    {"present",
+     [](int i) {
+       FlValue *args = fl_value_new_list();
+       fl_value_append_take(args, fl_value_new_bool(i % 2 == 0));
+       return args;
+     },
+     "prepare"},
+    {"dismiss", nullptr, nullptr, nullptr, "present", present_args},
+    {"setLayer",
+     [](int i) {
+       return int_list({i % 2 == 0 ? GTK_LAYER_SHELL_LAYER_OVERLAY
+                                   : GTK_LAYER_SHELL_LAYER_TOP});
+     }},
+    {"getLayer"},
+    {"getMonitorList"},
+    {"setMonitor",
+     [](int i) { return int_list({i % 2 == 0 ? monitor_id : -1}); }, nullptr,
+     nullptr, nullptr, nullptr, 100},
+    {"setAnchor",
+     [](int i) {
+       FlValue *args = int_list({GTK_LAYER_SHELL_EDGE_TOP});
+       fl_value_append_take(args, fl_value_new_bool(i % 2 == 0));
+       return args;
+     }},
+    {"getAnchor", [](int i) { return int_list({i % 4}); }},
+    {"setMargin",
+     [](int i) {
+       return int_list({GTK_LAYER_SHELL_EDGE_LEFT, i % 2 == 0 ? 20 : 0});
+     }},
+    {"getMargin", [](int i) { return int_list({i % 4}); }},
+    {"setExclusiveZone",
+     [](int i) { return int_list({i % 2 == 0 ? 30 : 0}); }},
+    {"getExclusiveZone"},
+    {"enableAutoExclusiveZone"},
+    {"isAutoExclusiveZoneEnabled"},
+    {"setKeyboardMode",
+     [](int i) {
+       return int_list({i % 2 == 0 ? GTK_LAYER_SHELL_KEYBOARD_MODE_ON_DEMAND
+                                   : GTK_LAYER_SHELL_KEYBOARD_MODE_NONE});
+     }},
+    {"getKeyboardMode"},
+    {"setSize", [](int i) { return int_list({400, i % 2 == 0 ? 320 : 300}); }},
+    {"applyConfig",
+     [](int i) {
+       FlValue *args = int_list({i % 2 == 0 ? GTK_LAYER_SHELL_LAYER_OVERLAY
+                                            : GTK_LAYER_SHELL_LAYER_TOP});
+       for (int field = 1; field < 6; field++) {
+         fl_value_append_take(args, fl_value_new_null());
+       }
+       return args;
+     }},
+    {"flush"},
+    {"getCommitStats"},
+    {"setInputRegion",
+     [](int i) {
+       FlValue *args = fl_value_new_list();
+       fl_value_append_take(args, i % 2 == 0 ? int_list({0, 0, 100, 100})
+                                             : fl_value_new_null());
+       return args;
+     }},
+    {"setOpaqueRegion",
+     [](int i) {
+       FlValue *args = fl_value_new_list();
+       fl_value_append_take(args, i % 2 == 0 ? int_list({0, 0, 100, 100})
+                                             : fl_value_new_null());
+       return args;
+     }},
+    {"animateMargins",
+     [](int i) {
+       FlValue *args = fl_value_new_list();
+       fl_value_append_take(args, fl_value_new_null());
+       fl_value_append_take(args, int_list({0, 0, 0, i % 2 == 0 ? 20 : 0}));
+       fl_value_append_take(args, fl_value_new_int(100));
+       fl_value_append_take(args, fl_value_new_int(0));
+       return args;
+     },
+     nullptr, nullptr, "cancelAnimations"},
+    {"animateSize", animate_size_args, nullptr, nullptr, "cancelAnimations"},
+    {"cancelAnimations", nullptr, "animateSize", animate_size_args},
+    {"setRenderPolicy",
+     [](int i) {
+       FlValue *args = int_list(
+           {i % 2 == 0 ? FRAME_POLICY_ON_DEMAND : FRAME_POLICY_CONTINUOUS});
+       fl_value_append_take(args, fl_value_new_null());
+       return args;
+     }},
+    {"setFrameRateCap", [](int i) { return int_list({i % 2 == 0 ? 30 : 0}); }},
+    {"setAutoHide",
+     [](int i) {
+       FlValue *args = fl_value_new_list();
+       fl_value_append_take(args, fl_value_new_bool(i % 2 == 0));
+       fl_value_append_take(args,
+                            fl_value_new_int(GTK_LAYER_SHELL_EDGE_BOTTOM));
+       fl_value_append_take(args, fl_value_new_int(4));
+       fl_value_append_take(args, fl_value_new_int(0));
+       fl_value_append_take(args, fl_value_new_int(0));
+       return args;
+     }},
+    {"requestFrame"},
+    {"getFrameStats"},
+    {"getScaleInfo"},
+    {"isPresentationSupported"},
+    {"setLogLevel", [](int i) { return int_list({PLUGIN_LOG_WARNING}); }},
+    {"getLogRecords", [](int i) { return int_list({64}); }},
+    {"getStats"},
+    {"resetStats"},
+    {"startTracing", trace_args, nullptr, nullptr, "stopTracing", nullptr,
+     100},
+    {"stopTracing", nullptr, "startTracing", trace_args, nullptr, nullptr, 100},
+    {"listenControlSocket", socket_args, nullptr, nullptr,
+     "closeControlSocket", nullptr, 100},
+    {"closeControlSocket", nullptr, "listenControlSocket", socket_args,
+     nullptr, nullptr, 100},
+    // No toplevel has this id, and none is touched.
+    {"activateToplevel", [](int i) { return int_list({G_MAXINT32}); }},
+    {"setToplevelMinimized",
+     [](int i) {
+       FlValue *args = int_list({G_MAXINT32});
+       fl_value_append_take(args, fl_value_new_bool(TRUE));
+       return args;
+     }},
+    {"closeToplevel", [](int i) { return int_list({G_MAXINT32}); }},
+};
+
+// Calls @method, counting its allocations and those of the main loop work it
+// causes if @count is set. Returns FALSE if it responded with an error.
+gboolean run_call(WaylandLayerShellPlugin *plugin, const gchar *method,
+                  ArgsFunc args, int i, bool count) {
+  g_autoptr(FlValue) value = args != nullptr ? args(i) : fl_value_new_null();
+  counting = count;
+  FlMethodResponse *response =
+      wayland_layer_shell_plugin_invoke(plugin, method, value);
+  gboolean ok = FL_IS_METHOD_SUCCESS_RESPONSE(response);
+  g_object_unref(response);
+  drain_main_loop();
+  counting = false;
+  return ok;
+}
+
+gboolean run_soak_call(WaylandLayerShellPlugin *plugin, const SoakCall &call,
+                       int i) {
+  if (call.setup != nullptr) {
+    run_call(plugin, call.setup, call.setup_args, i, false);
+  }
+  gboolean ok = run_call(plugin, call.method, call.args, i, true);
+  if (call.teardown != nullptr) {
+    run_call(plugin, call.teardown, call.teardown_args, i, false);
+  }
+  return ok;
+}
+
+// Allocations per call or cycle of one soak, round by round.
+struct Rounds {
+  int calls = 0;
+  int errors = 0;
+  Count total = {0, 0};
+  double first = 0;
+  double last = 0;
+
+  void add_round(const Count &count, int round_calls, int round) {
+    double per_call = static_cast<double>(count.allocations) / round_calls;
+    if (round == 0) {
+      first = per_call;
+    }
+    last = per_call;
+    calls += round_calls;
+    total.allocations += count.allocations;
+    total.frees += count.frees;
+  }
+
+  double allocations_per_call() const {
+    return calls > 0 ? static_cast<double>(total.allocations) / calls : 0;
+  }
+
+  double retained_per_call() const {
+    return calls > 0 ? (static_cast<double>(total.allocations) -
+                        static_cast<double>(total.frees)) /
+                           calls
+                     : 0;
+  }
+
+  // Appends "@name": {...} to @json and the reasons it failed to @failures.
+  void check(GString *json, const gchar *name, double max_retained,
+             const Options &options, GPtrArray *failures) const {
+    g_string_append_printf(
+        json,
+        "    \"%s\": {\"calls\": %d, \"errors\": %d, "
+        "\"allocations_per_call\": %.3f, \"first_round_per_call\": %.3f, "
+        "\"last_round_per_call\": %.3f, \"retained_per_call\": %.4f}",
+        name, calls, errors, allocations_per_call(), first, last,
+        retained_per_call());
+    if (retained_per_call() > max_retained) {
+      g_ptr_array_add(failures,
+                      g_strdup_printf("%s retains %.4f allocations per call",
+                                      name, retained_per_call()));
+    }
+    if (last > first * (1 + options.max_growth) + 1) {
+      g_ptr_array_add(failures, g_strdup_printf(
+                                    "%s allocations per call grew from "
+                                    "%.3f to %.3f",
+                                    name, first, last));
+    }
+  }
+};
+
+// Calls counts are kept even, so the alternating calls end on the default.
+int even(int count) { return MAX(count - count % 2, 2); }
+
+Rounds soak_call(WaylandLayerShellPlugin *plugin, const SoakCall &call,
+                 const Options &options) {
+  int divisor = call.divisor > 0 ? call.divisor : 1;
+  int per_round = even(options.calls / divisor / kRounds);
+  int warmup = even(MIN(per_round, 1000));
+  for (int i = 0; i < warmup; i++) {
+    run_soak_call(plugin, call, i);
+  }
+
+  Rounds rounds;
+  for (int round = 0; round < kRounds; round++) {
+    Count start = read_count();
+    for (int i = 0; i < per_round; i++) {
+      if (!run_soak_call(plugin, call, i)) {
+        rounds.errors++;
+      }
+    }
+    rounds.add_round(since(start), per_round, round);
+  }
+  return rounds;
+}
+
+// Iterates the main context, counting its allocations, until *@counter
+// exceeds @target. Returns FALSE on timeout.
+gboolean wait_for(const int *counter, int target) {
+  gint64 deadline = g_get_monotonic_time() + kWaitTimeoutUs;
+  while (*counter <= target) {
+    if (g_get_monotonic_time() > deadline) {
+      return FALSE;
+    }
+    g_main_context_iteration(nullptr, FALSE);
+  }
+  return TRUE;
+}
+
+gboolean count_configure_cb(GtkWidget *widget, GdkEvent *event,
+                            gpointer user_data) {
+  (*static_cast<int *>(user_data))++;
+  return FALSE;
+}
+
+// A window with a plugin instance managing it, set up as a layer surface.
+struct Fixture {
+  GtkWindow *window = nullptr;
+  WaylandLayerShellPlugin *plugin = nullptr;
+  int configures = 0;
+
+  gboolean open() {
+    window = GTK_WINDOW(gtk_window_new(GTK_WINDOW_TOPLEVEL));
+    gtk_window_set_default_size(window, 400, 300);
+    g_signal_connect(window, "configure-event",
+                     G_CALLBACK(count_configure_cb), &configures);
+    plugin = wayland_layer_shell_plugin_new_for_window(window);
+    gtk_widget_show_all(GTK_WIDGET(window));
+    if (!wait_for(&configures, 0)) {
+      return FALSE;
+    }
+    g_autoptr(FlValue) args = int_list({400, 300});
+    fl_value_append_take(args, fl_value_new_null());
+    g_autoptr(FlMethodResponse) response =
+        wayland_layer_shell_plugin_invoke(plugin, "initialize", args);
+    return FL_IS_METHOD_SUCCESS_RESPONSE(response);
+  }
+
+  void close() {
+    g_clear_object(&plugin);
+    gtk_widget_destroy(GTK_WIDGET(window));
+    window = nullptr;
+    drain_main_loop();
+  }
+};
+
+// Creates, initializes and destroys a window with its own plugin instance,
+// counting everything including the compositor round trips.
+Rounds soak_windows(const Options &options) {
+  int per_round = MAX(options.window_cycles / kRounds, 1);
+  for (int i = 0; i < MIN(per_round, 10); i++) {
+    Fixture fixture;
+    fixture.open();
+    fixture.close();
+  }
+
+  Rounds rounds;
+  for (int round = 0; round < kRounds; round++) {
+    Count start = read_count();
+    for (int i = 0; i < per_round; i++) {
+      Fixture fixture;
+      counting = true;
+      if (!fixture.open()) {
+        rounds.errors++;
+      }
+      fixture.close();
+      counting = false;
+    }
+    rounds.add_round(since(start), per_round, round);
+  }
+  return rounds;
+}
+
+// Runs swaymsg against the compositor's IPC socket and returns its output,
+// or nullptr if it failed. Not counted; the allocations are the test's own.
+gchar *swaymsg(const gchar *ipc, std::initializer_list<const gchar *> args) {
+  std::vector<const gchar *> argv = {"swaymsg", "-s", ipc};
+  argv.insert(argv.end(), args);
+  argv.push_back(nullptr);
+  gchar *output = nullptr;
+  gint status = 0;
+  if (!g_spawn_sync(nullptr, const_cast<gchar **>(argv.data()), nullptr,
+                    G_SPAWN_SEARCH_PATH, nullptr, nullptr, &output, nullptr,
+                    &status, nullptr) ||
+      !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    g_free(output);
+    return nullptr;
+  }
+  return output;
+}
+
+// Returns the name of the newest headless output, e.g. "HEADLESS-5", from
+// `swaymsg -t get_outputs`, which lists them as "Output <name> '...'".
+gchar *newest_output(const gchar *ipc) {
+  g_autofree gchar *outputs = swaymsg(ipc, {"-t", "get_outputs"});
+  if (outputs == nullptr) {
+    return nullptr;
+  }
+  gint64 newest = -1;
+  for (const gchar *line = strstr(outputs, "Output HEADLESS-");
+       line != nullptr; line = strstr(line + 1, "Output HEADLESS-")) {
+    newest = MAX(newest, g_ascii_strtoll(line + strlen("Output HEADLESS-"),
+                                         nullptr, 10));
+  }
+  return newest >= 0 ? g_strdup_printf("HEADLESS-%" G_GINT64_FORMAT, newest)
+                     : nullptr;
+}
+
+// Counts the monitors GDK (and with it the plugin's monitor registry)
+// knows of, until it reaches @target.
+gboolean wait_for_monitors(GdkDisplay *display, int target) {
+  gint64 deadline = g_get_monotonic_time() + kWaitTimeoutUs;
+  while (gdk_display_get_n_monitors(display) != target) {
+    if (g_get_monotonic_time() > deadline) {
+      return FALSE;
+    }
+    g_main_context_iteration(nullptr, FALSE);
+  }
+  return TRUE;
+}
+
+// Plugs an output in and out again, counting what the plugin and GDK do to
+// follow it. Needs sway's IPC socket in SWAYSOCK.
+gboolean soak_hotplug(const Options &options, Rounds *rounds) {
+  const gchar *ipc = g_getenv("SWAYSOCK");
+  if (ipc == nullptr || options.hotplug_cycles <= 0) {
+    return FALSE;
+  }
+  GdkDisplay *display = gdk_display_get_default();
+  int monitors = gdk_display_get_n_monitors(display);
+  int per_round = MAX(options.hotplug_cycles / kRounds, 1);
+  for (int round = 0; round < kRounds; round++) {
+    Count start = read_count();
+    for (int i = 0; i < per_round; i++) {
+      g_autofree gchar *created = swaymsg(ipc, {"create_output"});
+      counting = true;
+      gboolean added = wait_for_monitors(display, monitors + 1);
+      counting = false;
+      g_autofree gchar *name = newest_output(ipc);
+      g_autofree gchar *removed =
+          name != nullptr ? swaymsg(ipc, {"output", name, "unplug"})
+                          : nullptr;
+      counting = true;
+      if (!added || removed == nullptr ||
+          !wait_for_monitors(display, monitors)) {
+        rounds->errors++;
+      }
+      drain_main_loop();
+      counting = false;
+    }
+    rounds->add_round(since(start), per_round, round);
+  }
+  return TRUE;
+}
+
+// Fails for generated methods kCalls forgets, so new handlers get soaked.
+void check_coverage(GPtrArray *failures) {
+  for (size_t method = 0; method < channel_api::kMethodCount; method++) {
+    const gchar *name = channel_api::kMethodNames[method];
+    gboolean found = FALSE;
+    for (const SoakCall &call : kCalls) {
+      found = found || strcmp(call.method, name) == 0;
+    }
+    if (!found) {
+      g_ptr_array_add(failures, g_strdup_printf("%s is not soaked", name));
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // Before GLib 2.76 GSlice keeps freed blocks in per-thread magazines,
+  // which would look like retained memory. It reads G_SLICE when the library
+  // loads, so set it and start over.
+  if (g_getenv("G_SLICE") == nullptr) {
+    g_setenv("G_SLICE", "always-malloc", TRUE);
+    execv("/proc/self/exe", argv);
+  }
+
+  Options options;
+  GOptionEntry entries[] = {
+      {"json", 'o', 0, G_OPTION_ARG_FILENAME, &options.json_path,
+       "Write results to FILE instead of stdout", "FILE"},
+      {"calls", 0, 0, G_OPTION_ARG_INT, &options.calls,
+       "Calls per method handler", "N"},
+      {"window-cycles", 0, 0, G_OPTION_ARG_INT, &options.window_cycles,
+       "Windows to create and destroy", "N"},
+      {"hotplug-cycles", 0, 0, G_OPTION_ARG_INT, &options.hotplug_cycles,
+       "Outputs to plug in and out (needs SWAYSOCK)", "N"},
+      {"expected-outputs", 0, 0, G_OPTION_ARG_INT, &options.expected_outputs,
+       "Fail unless the compositor has N outputs", "N"},
+      {"max-retained-per-call", 0, 0, G_OPTION_ARG_DOUBLE,
+       &options.max_retained_per_call,
+       "Allocations a method call may leave behind on average", "N"},
+      {"max-retained-per-cycle", 0, 0, G_OPTION_ARG_DOUBLE,
+       &options.max_retained_per_cycle,
+       "Allocations a window or hotplug cycle may leave behind", "N"},
+      {"max-rss-growth-kb", 0, 0, G_OPTION_ARG_INT,
+       &options.max_rss_growth_kb, "Allowed resident set growth", "KB"},
+      {nullptr}};
+  g_autoptr(GError) error = nullptr;
+  if (!gtk_init_with_args(&argc, &argv, nullptr, entries, nullptr, &error)) {
+    g_printerr("%s\n", error != nullptr ? error->message : "No display");
+    return 1;
+  }
+  if (!gtk_layer_is_supported()) {
+    g_printerr("The compositor does not support layer shell\n");
+    return 77;
+  }
+
+  g_autoptr(GPtrArray) failures = g_ptr_array_new_with_free_func(g_free);
+  GdkDisplay *display = gdk_display_get_default();
+  if (options.expected_outputs > 0 &&
+      gdk_display_get_n_monitors(display) != options.expected_outputs) {
+    g_ptr_array_add(failures,
+                    g_strdup_printf("Expected %d outputs, found %d",
+                                    options.expected_outputs,
+                                    gdk_display_get_n_monitors(display)));
+  }
+  check_coverage(failures);
+
+  Fixture fixture;
+  if (!fixture.open()) {
+    g_printerr("Could not set up the layer surface\n");
+    return 1;
+  }
+  trace_path = g_strdup_printf("%s/wayland_layer_shell_soak-%d.json",
+                               g_get_tmp_dir(), getpid());
+  socket_path = g_strdup_printf("%s/wayland_layer_shell_soak-%d.sock",
+                                g_get_user_runtime_dir(), getpid());
+  {
+    g_autoptr(FlValue) no_args = fl_value_new_null();
+    g_autoptr(FlMethodResponse) response = wayland_layer_shell_plugin_invoke(
+        fixture.plugin, "getMonitorList", no_args);
+    FlValue *list = fl_method_success_response_get_result(
+        FL_METHOD_SUCCESS_RESPONSE(response));
+    if (fl_value_get_length(list) > 0) {
+      monitor_id = fl_value_get_int(fl_value_lookup_string(
+          fl_value_get_list_value(list, 0), "id"));
+    }
+  }
+
+  // One short pass first, so lazily created state and GTK's caches exist
+  // before the resident set is measured.
+  for (const SoakCall &call : kCalls) {
+    for (int i = 0; i < 100; i++) {
+      run_soak_call(fixture.plugin, call, i);
+    }
+  }
+  long rss_start = resident_kb();
+
+  g_autoptr(GString) json = g_string_new("{\n  \"methods\": {\n");
+  for (size_t i = 0; i < G_N_ELEMENTS(kCalls); i++) {
+    Rounds rounds = soak_call(fixture.plugin, kCalls[i], options);
+    rounds.check(json, kCalls[i].method, options.max_retained_per_call,
+                 options, failures);
+    g_string_append(json, i + 1 < G_N_ELEMENTS(kCalls) ? ",\n" : "\n");
+    g_printerr("%s: %.3f allocations per call\n", kCalls[i].method,
+               rounds.allocations_per_call());
+  }
+  g_string_append(json, "  },\n  \"cycles\": {\n");
+
+  soak_windows(options).check(json, "window", options.max_retained_per_cycle,
+                              options, failures);
+  Rounds hotplug;
+  if (soak_hotplug(options, &hotplug)) {
+    g_string_append(json, ",\n");
+    hotplug.check(json, "hotplug", options.max_retained_per_cycle, options,
+                  failures);
+  } else {
+    g_printerr("SWAYSOCK not set, skipping output hotplug\n");
+  }
+  fixture.close();
+  drain_main_loop();
+
+  long rss_end = resident_kb();
+  if (rss_end - rss_start > options.max_rss_growth_kb) {
+    g_ptr_array_add(failures,
+                    g_strdup_printf("Resident set grew by %ld KB",
+                                    rss_end - rss_start));
+  }
+  g_string_append_printf(json,
+                         "\n  },\n  \"rss_start_kb\": %ld,\n"
+                         "  \"rss_end_kb\": %ld,\n  \"failures\": [",
+                         rss_start, rss_end);
+  for (guint i = 0; i < failures->len; i++) {
+    g_string_append_printf(json, "%s\"%s\"", i > 0 ? ", " : "",
+                           static_cast<const gchar *>(failures->pdata[i]));
+    g_printerr("FAIL: %s\n", static_cast<const gchar *>(failures->pdata[i]));
+  }
+  g_string_append(json, "]\n}\n");
+  g_unlink(trace_path);
+  g_free(trace_path);
+  g_free(socket_path);
+
+  if (options.json_path != nullptr) {
+    if (!g_file_set_contents(options.json_path, json->str, json->len,
+                             &error)) {
+      g_printerr("%s\n", error->message);
+      return 1;
+    }
+  } else {
+    fputs(json->str, stdout);
+  }
+  return failures->len == 0 ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+// Sends a command to the control socket of an app using wayland_layer_shell,
+// e.g. from a compositor keybinding:
+//
+//   wayland_layer_shell_ctl toggle exclusive
+//   wayland_layer_shell_ctl applyConfig layer=overlay margins=0,0,40,0
+//
+// The socket is taken from -s or from WAYLAND_LAYER_SHELL_CONTROL_SOCKET.
+// With --bench N the command is sent N times and the round trip latency,
+// from writing the command until the reply that follows its commit, is
+// printed in microseconds.
+//
+// Plain C and POSIX only, so it starts fast and builds without GLib:
+//   cc -O2 -o wayland_layer_shell_ctl wayland_layer_shell_ctl.c
+//
+// Exits with 0 if the command succeeded, 1 if the app replied with an error
+// and 2 if the command could not be sent.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_REQUEST 4096
+#define MAX_REPLY 4096
+
+static void usage(void) {
+  fprintf(stderr,
+          "Usage: wayland_layer_shell_ctl [-s SOCKET] [--bench N] COMMAND "
+          "[ARG...]\n"
+          "Commands: show [exclusive], hide, toggle [exclusive], "
+          "setLayer LAYER,\n"
+          "  setMonitor ID, setKeyboardMode MODE, "
+          "applyConfig KEY=VALUE..., ping\n");
+}
+
+static int connect_to(const char *path) {
+  struct sockaddr_un address;
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Socket path too long: %s\n", path);
+    return -1;
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 ||
+      connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+    fprintf(stderr, "Could not connect to %s: %s\n", path, strerror(errno));
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  return fd;
+}
+
+// Appends @word to @line, single-quoted if it needs to be so the app splits
+// the line back into the same words. Returns the new length, or -1 if the
+// line would not fit.
+static int append_word(char *line, int length, const char *word) {
+  int quote = word[0] == '\0' || strpbrk(word, " \t\n'\"\\#") != NULL;
+  char *end = line + MAX_REQUEST - 2;  // Room for '\n' and '\0'.
+  char *out = line + length;
+  if (length > 0) {
+    if (out >= end) {
+      return -1;
+    }
+    *out++ = ' ';
+  }
+  if (quote && out < end) {
+    *out++ = '\'';
+  }
+  for (const char *in = word; *in != '\0'; in++) {
+    // A quote ends the quoted part, is escaped, and starts a new one.
+    const char *piece = *in == '\'' && quote ? "'\\''" : NULL;
+    size_t piece_length = piece != NULL ? strlen(piece) : 1;
+    if (out + piece_length > end) {
+      return -1;
+    }
+    if (piece != NULL) {
+      memcpy(out, piece, piece_length);
+    } else {
+      *out = *in;
+    }
+    out += piece_length;
+  }
+  if (quote) {
+    if (out >= end) {
+      return -1;
+    }
+    *out++ = '\'';
+  }
+  *out = '\0';
+  return (int)(out - line);
+}
+
+static int write_all(int fd, const char *data, size_t length) {
+  while (length > 0) {
+    ssize_t written = write(fd, data, length);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return -1;
+    }
+    data += written;
+    length -= (size_t)written;
+  }
+  return 0;
+}
+
+// Reads one reply line into @reply, without the newline.
+static int read_reply(int fd, char *reply) {
+  size_t length = 0;
+  while (length < MAX_REPLY - 1) {
+    ssize_t count = read(fd, reply + length, 1);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      return -1;
+    }
+    if (reply[length] == '\n') {
+      break;
+    }
+    length++;
+  }
+  reply[length] = '\0';
+  return 0;
+}
+
+static double now_us(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double difference = *(const double *)a - *(const double *)b;
+  return (difference > 0) - (difference < 0);
+}
+
+int main(int argc, char **argv) {
+  const char *path = getenv("WAYLAND_LAYER_SHELL_CONTROL_SOCKET");
+  long iterations = 0;
+  int arg = 1;
+  for (; arg < argc && argv[arg][0] == '-'; arg++) {
+    if (strcmp(argv[arg], "-s") == 0 && arg + 1 < argc) {
+      path = argv[++arg];
+    } else if (strcmp(argv[arg], "--bench") == 0 && arg + 1 < argc) {
+      iterations = strtol(argv[++arg], NULL, 10);
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (arg >= argc || iterations < 0) {
+    usage();
+    return 2;
+  }
+  if (path == NULL || path[0] == '\0') {
+    fprintf(stderr, "No socket: pass -s or set "
+                    "WAYLAND_LAYER_SHELL_CONTROL_SOCKET\n");
+    return 2;
+  }
+
+  char request[MAX_REQUEST];
+  int length = 0;
+  request[0] = '\0';
+  for (; arg < argc; arg++) {
+    length = append_word(request, length, argv[arg]);
+    if (length < 0) {
+      fprintf(stderr, "Command too long\n");
+      return 2;
+    }
+  }
+  request[length++] = '\n';
+  request[length] = '\0';
+
+  int fd = connect_to(path);
+  if (fd < 0) {
+    return 2;
+  }
+
+  long count = iterations > 0 ? iterations : 1;
+  double *samples = malloc(sizeof(double) * (size_t)count);
+  if (samples == NULL) {
+    close(fd);
+    return 2;
+  }
+  char reply[MAX_REPLY];
+  int status = 0;
+  for (long i = 0; i < count; i++) {
+    double start = now_us();
+    if (write_all(fd, request, (size_t)length) != 0 ||
+        read_reply(fd, reply) != 0) {
+      fprintf(stderr, "Connection lost: %s\n", strerror(errno));
+      status = 2;
+      break;
+    }
+    samples[i] = now_us() - start;
+    if (strcmp(reply, "ok") != 0) {
+      fprintf(stderr, "%s\n", reply);
+      status = 1;
+      break;
+    }
+  }
+  close(fd);
+
+  if (iterations > 0 && status == 0) {
+    qsort(samples, (size_t)count, sizeof(double), compare_doubles);
+    double sum = 0;
+    for (long i = 0; i < count; i++) {
+      sum += samples[i];
+    }
+    printf("{\"samples\": %ld, \"mean_us\": %.3f, \"min_us\": %.3f, "
+           "\"p50_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f}\n",
+           count, sum / count, samples[0], samples[count / 2],
+           samples[(long)(0.99 * (count - 1) + 0.5)], samples[count - 1]);
+  }
+  free(samples);
+  return status;
+}
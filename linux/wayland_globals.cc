@@ -0,0 +1,122 @@
+#include "wayland_globals.h"
+
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+#include <gdk/gdkwayland.h>
+#include <wayland-client.h>
+
+#include <cstring>
+
+#include "fractional-scale-v1-client-protocol.h"
+#include "plugin_log.h"
+#include "presentation-time-client-protocol.h"
+#include "viewporter-client-protocol.h"
+#include "wlr-foreign-toplevel-management-unstable-v1-client-protocol.h"
+
+// Bound once per process.
+static gboolean probed;
+static WaylandGlobals globals;
+
+static void presentation_clock_id_cb(void *data,
+                                     struct wp_presentation *presentation,
+                                     uint32_t clock_id) {
+  globals.presentation_clock = static_cast<clockid_t>(clock_id);
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+    presentation_clock_id_cb,
+};
+
+static void registry_global_cb(void *data, struct wl_registry *registry,
+                               uint32_t name, const char *interface,
+                               uint32_t version) {
+  if (strcmp(interface, wp_fractional_scale_manager_v1_interface.name) == 0) {
+    globals.fractional_scale_manager =
+        static_cast<struct wp_fractional_scale_manager_v1 *>(wl_registry_bind(
+            registry, name, &wp_fractional_scale_manager_v1_interface, 1));
+  } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
+    globals.viewporter = static_cast<struct wp_viewporter *>(
+        wl_registry_bind(registry, name, &wp_viewporter_interface, 1));
+  } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+    globals.presentation = static_cast<struct wp_presentation *>(
+        wl_registry_bind(registry, name, &wp_presentation_interface, 1));
+    wp_presentation_add_listener(globals.presentation, &presentation_listener,
+                                 nullptr);
+  } else if (strcmp(interface,
+                    zwlr_foreign_toplevel_manager_v1_interface.name) == 0) {
+    globals.foreign_toplevel_name = name;
+    globals.foreign_toplevel_version = version;
+  }
+}
+
+static void registry_global_remove_cb(void *data,
+                                      struct wl_registry *registry,
+                                      uint32_t name) {}
+
+static const struct wl_registry_listener registry_listener = {
+    registry_global_cb,
+    registry_global_remove_cb,
+};
+
+// Moves a proxy bound on the private queue over to GTK's.
+static void hand_over(void *proxy) {
+  if (proxy != nullptr) {
+    wl_proxy_set_queue(static_cast<struct wl_proxy *>(proxy), nullptr);
+  }
+}
+
+// Binds the globals on a private queue, so the roundtrips do not dispatch
+// any of GTK's events, then hands the bound objects over to GTK's queue
+// where the events of the objects created from them get dispatched.
+const WaylandGlobals *wayland_globals_get(GdkDisplay *display) {
+  if (probed) {
+    return &globals;
+  }
+  probed = TRUE;
+  globals.presentation_clock = CLOCK_MONOTONIC;
+  if (!GDK_IS_WAYLAND_DISPLAY(display)) {
+    return &globals;
+  }
+
+  struct wl_display *wl_display = gdk_wayland_display_get_wl_display(display);
+  struct wl_event_queue *queue = wl_display_create_queue(wl_display);
+  struct wl_display *wrapper =
+      static_cast<struct wl_display *>(wl_proxy_create_wrapper(wl_display));
+  wl_proxy_set_queue(reinterpret_cast<struct wl_proxy *>(wrapper), queue);
+  struct wl_registry *registry = wl_display_get_registry(wrapper);
+  wl_proxy_wrapper_destroy(wrapper);
+  wl_registry_add_listener(registry, &registry_listener, nullptr);
+  wl_display_roundtrip_queue(wl_display, queue);
+  wl_registry_destroy(registry);
+  // wp_presentation announces its clock right after the bind.
+  if (globals.presentation != nullptr) {
+    wl_display_roundtrip_queue(wl_display, queue);
+  }
+
+  hand_over(globals.fractional_scale_manager);
+  hand_over(globals.viewporter);
+  hand_over(globals.presentation);
+  wl_event_queue_destroy(queue);
+
+  PLUGIN_LOG_I("wp_fractional_scale_manager_v1 %s, wp_viewporter %s, "
+               "wp_presentation %s, zwlr_foreign_toplevel_manager_v1 %s",
+               globals.fractional_scale_manager != nullptr ? "available"
+                                                           : "missing",
+               globals.viewporter != nullptr ? "available" : "missing",
+               globals.presentation != nullptr ? "available" : "missing",
+               globals.foreign_toplevel_name != 0 ? "available" : "missing");
+  return &globals;
+}
+
+// Global names belong to the display, not to a registry, so a short-lived
+// registry on GTK's queue can bind a global found earlier. The registry's
+// own events are dropped along with it.
+void *wayland_globals_bind(GdkDisplay *display, uint32_t name,
+                           const struct wl_interface *interface,
+                           uint32_t version) {
+  struct wl_display *wl_display = gdk_wayland_display_get_wl_display(display);
+  struct wl_registry *registry = wl_display_get_registry(wl_display);
+  void *proxy = wl_registry_bind(registry, name, interface, version);
+  wl_registry_destroy(registry);
+  return proxy;
+}
+#endif  // WAYLAND_LAYER_SHELL_PROTOCOLS
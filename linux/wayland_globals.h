@@ -0,0 +1,41 @@
+#ifndef WAYLAND_LAYER_SHELL_WAYLAND_GLOBALS_H_
+#define WAYLAND_LAYER_SHELL_WAYLAND_GLOBALS_H_
+
+#include <gtk/gtk.h>
+
+#if WAYLAND_LAYER_SHELL_PROTOCOLS
+#include <stdint.h>
+#include <time.h>
+
+struct wp_fractional_scale_manager_v1;
+struct wp_presentation;
+struct wp_viewporter;
+struct wl_interface;
+
+// Wayland globals the plugin binds itself, on the display GTK is connected
+// to. Each is nullptr if the compositor does not offer it.
+typedef struct {
+  struct wp_fractional_scale_manager_v1 *fractional_scale_manager;
+  struct wp_viewporter *viewporter;
+  struct wp_presentation *presentation;
+  // Clock of the wp_presentation timestamps, usually CLOCK_MONOTONIC.
+  clockid_t presentation_clock;
+  // zwlr_foreign_toplevel_manager_v1 starts sending events as soon as it is
+  // bound, so it is only looked up here and bound with wayland_globals_bind()
+  // by whoever listens to it. 0 if the compositor does not offer it.
+  uint32_t foreign_toplevel_name;
+  uint32_t foreign_toplevel_version;
+} WaylandGlobals;
+
+// Returns the globals of @display, binding them on first use. Their events
+// are dispatched by GTK along with its own. All nullptr if @display is not a
+// Wayland display.
+const WaylandGlobals *wayland_globals_get(GdkDisplay *display);
+
+// Binds the global @name of @display at @version, on GTK's event queue.
+void *wayland_globals_bind(GdkDisplay *display, uint32_t name,
+                           const struct wl_interface *interface,
+                           uint32_t version);
+#endif
+
+#endif  // WAYLAND_LAYER_SHELL_WAYLAND_GLOBALS_H_
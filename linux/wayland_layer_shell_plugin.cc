@@ -4,11 +4,28 @@
 #include <gtk/gtk.h>
 #include <sys/utsname.h>
 
+#include <cmath>
 #include <cstring>
-#include <iostream>
-#include <map>
 #include <string>
 
+#include "auto_hide.h"
+#include "channel_api.g.h"
+#include "control_socket.h"
+#include "foreign_toplevels.h"
+#include "fractional_scale.h"
+#include "frame_presentation.h"
+#include "frame_governor.h"
+#include "layer_animator.h"
+#include "layer_presenter.h"
+#include "layer_shell_caps.h"
+#include "layer_shell_ffi.h"
+#include "layer_shell_setup.h"
+#include "layer_surface_queue.h"
+#include "layer_window_state.h"
+#include "monitor_registry.h"
+#include "plugin_log.h"
+#include "plugin_stats.h"
+#include "plugin_trace.h"
 #include "wayland_layer_shell_plugin_private.h"
 
 #include <gtk-layer-shell/gtk-layer-shell.h>
@@ -17,19 +34,324 @@
   (G_TYPE_CHECK_INSTANCE_CAST((obj), wayland_layer_shell_plugin_get_type(),    \
                               WaylandLayerShellPlugin))
 
-// Global map to track initialized windows
-static std::map<GtkWindow *, bool> initialized_windows;
+typedef struct _PendingInitialize PendingInitialize;
 
 struct _WaylandLayerShellPlugin {
   GObject parent_instance;
   FlPluginRegistrar *registrar;
   GtkWindow
       *target_window; // Store the specific window this plugin instance manages
+  // The signal handlers on target_window all take the plugin as their data
+  // and are disconnected together.
+  gboolean window_handlers_connected;
+  // Listeners on the window's layer surface queue.
+  gulong queue_changed_id;
+  gulong queue_remap_id;
+  // Last size reported in a "configured" event.
+  int configured_width;
+  int configured_height;
+  PendingInitialize *pending_initialize;
+  LayerAnimator animator; // Native margin/size animations for target_window
+  AutoHide auto_hide;      // Edge-triggered auto-hide of target_window
+  LayerPresenter presenter; // Off-screen prepared state of target_window
+  FractionalScale *fractional_scale; // Preferred scale of target_window
+  FramePresentation *presentation;   // Presentation times of target_window
+  FlEventChannel *event_channel;
+  gboolean events_listening;
+  MonitorRegistry *monitors;
+  FlEventChannel *monitor_channel;
+  gboolean monitors_listening;
+  FlEventChannel *surface_channel;
+  gboolean surface_listening;
+  FlEventChannel *presentation_channel;
+  gboolean presentation_listening;
+  // Windows of all apps, tracked while Dart listens on toplevel_channel.
+  ForeignToplevels *toplevels;
+  FlEventChannel *toplevel_channel;
+  // Last layer surface state sent in a "state" event.
+  LayerSurfaceState surface_state;
+  gboolean surface_state_sent;
+  // Listener for commands from other processes, if enabled.
+  ControlSocket *control_socket;
+  // Response of an asynchronous handler run by
+  // wayland_layer_shell_plugin_invoke().
+  FlMethodResponse *invoke_response;
+#if WAYLAND_LAYER_SHELL_STATS
+  PluginStats *stats;
+#endif
+  // Counter values at the last resetStats call.
+  guint64 commits_at_reset;
+  guint64 enumerations_at_reset;
 };
 
 G_DEFINE_TYPE(WaylandLayerShellPlugin, wayland_layer_shell_plugin,
               g_object_get_type())
 
+// Sends @event (a map with an "event" key naming its kind) to Dart on the
+// wayland_layer_shell/events channel. Takes ownership of @event.
+static void send_event(WaylandLayerShellPlugin *self, FlValue *event) {
+  g_autoptr(FlValue) value = event;
+  if (self->event_channel == nullptr || !self->events_listening) {
+    return;
+  }
+  fl_event_channel_send(self->event_channel, value, nullptr, nullptr);
+}
+
+static void animation_done_cb(gint64 id, gboolean cancelled,
+                              gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  FlValue *event = fl_value_new_map();
+  fl_value_set_string_take(event, "event",
+                           fl_value_new_string("animationDone"));
+  fl_value_set_string_take(event, "id", fl_value_new_int(id));
+  fl_value_set_string_take(event, "cancelled", fl_value_new_bool(cancelled));
+  send_event(self, event);
+}
+
+static void scale_changed_cb(double scale, gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  FlValue *event = fl_value_new_map();
+  fl_value_set_string_take(event, "event", fl_value_new_string("scaleChanged"));
+  fl_value_set_string_take(event, "scale", fl_value_new_float(scale));
+  send_event(self, event);
+}
+
+static void frame_presented_cb(const PresentedFrame *frame,
+                               gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  if (self->presentation_channel == nullptr || !self->presentation_listening) {
+    return;
+  }
+  const MonitorInfo *info =
+      frame->monitor != nullptr && self->monitors != nullptr
+          ? monitor_registry_find(self->monitors, frame->monitor)
+          : nullptr;
+  g_autoptr(FlValue) event = fl_value_new_map();
+  fl_value_set_string_take(event, "presented",
+                           fl_value_new_bool(frame->presented));
+  fl_value_set_string_take(event, "time_us", fl_value_new_int(frame->time_us));
+  fl_value_set_string_take(event, "latency_us",
+                           fl_value_new_int(frame->latency_us));
+  fl_value_set_string_take(event, "refresh_ns",
+                           fl_value_new_int(frame->refresh_ns));
+  fl_value_set_string_take(event, "sequence",
+                           fl_value_new_int(frame->sequence));
+  fl_value_set_string_take(event, "flags", fl_value_new_int(frame->flags));
+  fl_value_set_string_take(event, "monitor",
+                           fl_value_new_int(info != nullptr ? info->id : -1));
+  fl_event_channel_send(self->presentation_channel, event, nullptr, nullptr);
+}
+
+static void fail_initialize(WaylandLayerShellPlugin *self, const gchar *code,
+                            const gchar *message);
+
+// The animator drives the window's frame clock and its per-window queue, so it
+// has to stop before either goes away. A pending initialize can't finish
+// anymore either.
+static void window_destroy_cb(GtkWidget *widget, gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  layer_animator_clear(&self->animator);
+  auto_hide_clear(&self->auto_hide);
+  layer_presenter_clear(&self->presenter);
+  g_clear_pointer(&self->fractional_scale, fractional_scale_free);
+  g_clear_pointer(&self->presentation, frame_presentation_free);
+  if (self->pending_initialize != nullptr) {
+    fail_initialize(self, "no_window", "Window was destroyed");
+  }
+  LayerWindowState *window_state = layer_window_state_peek(GTK_WINDOW(widget));
+  if (window_state != nullptr && self->queue_changed_id != 0) {
+    layer_surface_queue_remove_changed_func(&window_state->queue,
+                                            self->queue_changed_id);
+    layer_surface_queue_remove_remap_func(&window_state->queue,
+                                          self->queue_remap_id);
+  }
+  self->queue_changed_id = 0;
+  self->queue_remap_id = 0;
+  self->window_handlers_connected = FALSE;
+  self->pending_initialize = nullptr;
+}
+
+// Whether Dart listens to the wayland_layer_shell/surface channel. Checked
+// before building an event.
+static gboolean surface_events_wanted(WaylandLayerShellPlugin *self) {
+  return self->surface_channel != nullptr && self->surface_listening;
+}
+
+// Sends a surface event named @name on the wayland_layer_shell/surface
+// channel, with the fields of @fields (a map, or nullptr for none) and the
+// g_get_monotonic_time() it was sent at. Takes ownership of @fields.
+static void send_surface_event(WaylandLayerShellPlugin *self,
+                               const gchar *name, FlValue *fields) {
+  g_autoptr(FlValue) event =
+      fields != nullptr ? fields : fl_value_new_map();
+  fl_value_set_string_take(event, "event", fl_value_new_string(name));
+  fl_value_set_string_take(event, "time_us",
+                           fl_value_new_int(g_get_monotonic_time()));
+  fl_event_channel_send(self->surface_channel, event, nullptr, nullptr);
+}
+
+static gboolean same_surface_state(const LayerSurfaceState *a,
+                                   const LayerSurfaceState *b) {
+  return a->layer == b->layer && a->monitor == b->monitor &&
+         a->exclusive_zone == b->exclusive_zone &&
+         a->auto_exclusive_zone == b->auto_exclusive_zone &&
+         a->keyboard_mode == b->keyboard_mode;
+}
+
+// Sends a "state" event if the layer, monitor, exclusive zone or keyboard
+// mode differ from the last one sent, covering changes from the method
+// channel, dart:ffi and the native bootstrap alike.
+static void send_surface_state(WaylandLayerShellPlugin *self) {
+  if (!surface_events_wanted(self) || self->target_window == nullptr) {
+    return;
+  }
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(
+      &layer_window_state_get(self->target_window)->queue, &state);
+  if (self->surface_state_sent &&
+      same_surface_state(&state, &self->surface_state)) {
+    return;
+  }
+  self->surface_state = state;
+  self->surface_state_sent = TRUE;
+
+  const MonitorInfo *monitor =
+      state.monitor != nullptr && self->monitors != nullptr
+          ? monitor_registry_find(self->monitors, state.monitor)
+          : nullptr;
+  FlValue *fields = fl_value_new_map();
+  fl_value_set_string_take(fields, "layer", fl_value_new_int(state.layer));
+  fl_value_set_string_take(
+      fields, "monitor",
+      fl_value_new_int(monitor != nullptr ? monitor->id : -1));
+  fl_value_set_string_take(fields, "exclusive_zone",
+                           fl_value_new_int(state.exclusive_zone));
+  fl_value_set_string_take(fields, "auto_exclusive_zone",
+                           fl_value_new_bool(state.auto_exclusive_zone));
+  fl_value_set_string_take(fields, "keyboard_mode",
+                           fl_value_new_int(state.keyboard_mode));
+  send_surface_event(self, "state", fields);
+}
+
+static void queue_changed_cb(gpointer user_data) {
+  send_surface_state(WAYLAND_LAYER_SHELL_PLUGIN(user_data));
+}
+
+// Tells Dart the surface was remapped, and for which changes, so apps can
+// tell a cheap commit from a remap.
+static void queue_remap_cb(guint fields, gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  if (!surface_events_wanted(self)) {
+    return;
+  }
+  FlValue *reasons = fl_value_new_list();
+  if (fields & LAYER_FIELD_LAYER) {
+    fl_value_append_take(reasons, fl_value_new_string("layer"));
+  }
+  if (fields & LAYER_FIELD_MONITOR) {
+    fl_value_append_take(reasons, fl_value_new_string("monitor"));
+  }
+  FlValue *event_fields = fl_value_new_map();
+  fl_value_set_string_take(event_fields, "reasons", reasons);
+  send_surface_event(self, "remapped", event_fields);
+}
+
+// Reports the size the compositor configured the window with: every configure
+// as a surface event, and once per distinct size on the events channel, so
+// Dart can lay out at the final size.
+static gboolean window_configure_cb(GtkWidget *widget, GdkEvent *event,
+                                    gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  GdkEventConfigure *configure = reinterpret_cast<GdkEventConfigure *>(event);
+  PLUGIN_TRACE_INSTANT("configure", "width", configure->width, "height",
+                       configure->height);
+  if (surface_events_wanted(self)) {
+    // Lets Dart measure how long the compositor took to answer a commit.
+    const LayerSurfaceQueue *queue =
+        &layer_window_state_get(GTK_WINDOW(widget))->queue;
+    FlValue *fields = fl_value_new_map();
+    fl_value_set_string_take(fields, "width",
+                             fl_value_new_int(configure->width));
+    fl_value_set_string_take(fields, "height",
+                             fl_value_new_int(configure->height));
+    fl_value_set_string_take(fields, "last_commit_us",
+                             fl_value_new_int(queue->last_commit_time));
+    send_surface_event(self, "configured", fields);
+  }
+  if (configure->width == self->configured_width &&
+      configure->height == self->configured_height) {
+    return FALSE;
+  }
+  self->configured_width = configure->width;
+  self->configured_height = configure->height;
+
+  FlValue *value = fl_value_new_map();
+  fl_value_set_string_take(value, "event", fl_value_new_string("configured"));
+  fl_value_set_string_take(value, "width", fl_value_new_int(configure->width));
+  fl_value_set_string_take(value, "height",
+                           fl_value_new_int(configure->height));
+  send_event(self, value);
+  return FALSE;
+}
+
+static void window_map_cb(GtkWidget *widget, gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  PLUGIN_TRACE_INSTANT("map");
+  if (surface_events_wanted(self)) {
+    send_surface_event(self, "mapped", nullptr);
+  }
+}
+
+static void window_unmap_cb(GtkWidget *widget, gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  PLUGIN_TRACE_INSTANT("unmap");
+  if (surface_events_wanted(self)) {
+    send_surface_event(self, "unmapped", nullptr);
+  }
+}
+
+// gtk-layer-shell closes the window when the compositor sends
+// zwlr_layer_surface_v1.closed, e.g. because the output went away. This only
+// reports it: GTK then destroys the window as for any other close request.
+static gboolean window_delete_cb(GtkWidget *widget, GdkEvent *event,
+                                 gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  PLUGIN_TRACE_INSTANT("closed");
+  if (surface_events_wanted(self)) {
+    send_surface_event(self, "closed", nullptr);
+  }
+  return FALSE;
+}
+
+static gboolean window_focus_cb(GtkWidget *widget, GdkEvent *event,
+                                gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  gboolean focused = reinterpret_cast<GdkEventFocus *>(event)->in;
+  PLUGIN_TRACE_INSTANT(focused ? "focus_in" : "focus_out");
+  if (surface_events_wanted(self)) {
+    send_surface_event(self, focused ? "focusGained" : "focusLost", nullptr);
+  }
+  return FALSE;
+}
+
+static void auto_hide_changed_cb(gboolean hidden, gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  // A size animation in flight would keep overwriting the strip size. It
+  // stops, and the surface is revealed at the size it was heading for.
+  if (hidden && self->animator.size.id != 0) {
+    int width = static_cast<int>(lround(self->animator.size.to[0]));
+    int height = static_cast<int>(lround(self->animator.size.to[1]));
+    layer_animator_cancel_size(&self->animator);
+    auto_hide_set_size(&self->auto_hide, width, height);
+  }
+  if (surface_events_wanted(self)) {
+    send_surface_event(self, hidden ? "hidden" : "revealed", nullptr);
+  }
+}
+
+static void set_target_window(WaylandLayerShellPlugin *self,
+                              GtkWindow *window);
+
 GtkWindow *get_window(WaylandLayerShellPlugin *self) {
   // If we have a cached target window, use it
   if (self->target_window != nullptr) {
@@ -42,11 +364,66 @@ GtkWindow *get_window(WaylandLayerShellPlugin *self) {
     return nullptr;
 
   GtkWindow *window = GTK_WINDOW(gtk_widget_get_toplevel(GTK_WIDGET(view)));
+  set_target_window(self, window);
+  return window;
+}
+
+// Makes @window the window this plugin instance manages.
+// Lets the C API resolve monitor ids through the plugin's registry if @window
+// is the window it acts on.
+static void share_monitors_with_ffi(WaylandLayerShellPlugin *self,
+                                    GtkWindow *window) {
+  if (self->monitors != nullptr && layer_shell_ffi_is_attached_to(window)) {
+    layer_shell_ffi_set_monitors(self->monitors);
+  }
+}
 
-  // Cache this window for this plugin instance
+static void set_target_window(WaylandLayerShellPlugin *self,
+                              GtkWindow *window) {
+  // Cache this window for this plugin instance. The weak pointer clears the
+  // cache if the window is destroyed before the plugin.
   self->target_window = window;
+  g_object_add_weak_pointer(G_OBJECT(window),
+                            reinterpret_cast<gpointer *>(&self->target_window));
+  g_signal_connect(window, "destroy", G_CALLBACK(window_destroy_cb), self);
+  g_signal_connect(window, "configure-event", G_CALLBACK(window_configure_cb),
+                   self);
+  g_signal_connect(window, "map", G_CALLBACK(window_map_cb), self);
+  g_signal_connect(window, "unmap", G_CALLBACK(window_unmap_cb), self);
+  g_signal_connect(window, "delete-event", G_CALLBACK(window_delete_cb), self);
+  g_signal_connect(window, "focus-in-event", G_CALLBACK(window_focus_cb), self);
+  g_signal_connect(window, "focus-out-event", G_CALLBACK(window_focus_cb),
+                   self);
+  self->window_handlers_connected = TRUE;
+  self->queue_changed_id = layer_surface_queue_add_changed_func(
+      &layer_window_state_get(window)->queue, queue_changed_cb, self);
+  self->queue_remap_id = layer_surface_queue_add_remap_func(
+      &layer_window_state_get(window)->queue, queue_remap_cb, self);
+  layer_animator_init(&self->animator, window,
+                      &layer_window_state_get(window)->queue,
+                      animation_done_cb, self);
+  auto_hide_init(&self->auto_hide, window, layer_window_state_get(window),
+                 auto_hide_changed_cb, self);
+  layer_presenter_init(&self->presenter, window,
+                       layer_window_state_get(window));
+  self->fractional_scale =
+      fractional_scale_new(window, scale_changed_cb, self);
+  self->presentation =
+      frame_presentation_new(window, frame_presented_cb, self);
+  frame_presentation_set_enabled(self->presentation,
+                                 self->presentation_listening);
+  layer_shell_ffi_attach(window);
+  share_monitors_with_ffi(self, window);
+}
 
-  return window;
+// Returns the layer surface queue of the plugin's window, or nullptr if there
+// is no window.
+static LayerSurfaceQueue *get_queue(WaylandLayerShellPlugin *self) {
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    return nullptr;
+  }
+  return &layer_window_state_get(window)->queue;
 }
 
 static FlMethodResponse *is_supported(WaylandLayerShellPlugin *self) {
@@ -54,135 +431,427 @@ static FlMethodResponse *is_supported(WaylandLayerShellPlugin *self) {
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-static FlMethodResponse *initialize(WaylandLayerShellPlugin *self,
-                                    FlValue *args) {
-  GtkWindow *gtk_window = get_window(self);
+// Whether the C API acts on this instance's window, so Dart may read its
+// state through dart:ffi. It only serves one window per process.
+static FlMethodResponse *is_ffi_window(WaylandLayerShellPlugin *self) {
+  g_autoptr(FlValue) result =
+      fl_value_new_bool(layer_shell_ffi_is_attached_to(get_window(self)));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
 
-  if (gtk_window == nullptr) {
-    std::cout << "ERROR: Could not get GTK window" << std::endl;
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+// Returns what gtk-layer-shell and the compositor support, and so which
+// changes are cheap.
+static FlMethodResponse *get_capabilities() {
+  const LayerShellCaps *caps = layer_shell_caps_get();
+  g_autoptr(FlValue) result = fl_value_new_map();
+  g_autofree gchar *library_version =
+      g_strdup_printf("%u.%u.%u", caps->library_major, caps->library_minor,
+                      caps->library_micro);
+  fl_value_set_string_take(result, "library_version",
+                           fl_value_new_string(library_version));
+  fl_value_set_string_take(result, "protocol_version",
+                           fl_value_new_int(caps->protocol_version));
+  fl_value_set_string_take(result, "layer_change_in_place",
+                           fl_value_new_bool(caps->layer_change_in_place));
+  fl_value_set_string_take(result, "exclusive_edge",
+                           fl_value_new_bool(caps->exclusive_edge));
+  FlValue *keyboard_modes = fl_value_new_list();
+  fl_value_append_take(keyboard_modes,
+                       fl_value_new_int(GTK_LAYER_SHELL_KEYBOARD_MODE_NONE));
+  fl_value_append_take(
+      keyboard_modes,
+      fl_value_new_int(GTK_LAYER_SHELL_KEYBOARD_MODE_EXCLUSIVE));
+  if (caps->on_demand_keyboard) {
+    fl_value_append_take(
+        keyboard_modes,
+        fl_value_new_int(GTK_LAYER_SHELL_KEYBOARD_MODE_ON_DEMAND));
   }
+  fl_value_set_string_take(result, "keyboard_modes", keyboard_modes);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
 
-  if (gtk_layer_is_supported() == 0) {
-    std::cout << "ERROR: Layer shell not supported" << std::endl;
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+// Parses a monitor argument from Dart: either a registry id or the
+// "id:model" string produced by Monitor.toString(). Returns -1 ("let the
+// compositor decide") for -1 and 0 for anything that can't be parsed.
+static gint64 parse_monitor_id(FlValue *value) {
+  switch (fl_value_get_type(value)) {
+  case FL_VALUE_TYPE_INT:
+    return fl_value_get_int(value);
+  case FL_VALUE_TYPE_STRING:
+    return g_ascii_strtoll(fl_value_get_string(value), nullptr, 10);
+  default:
+    return 0;
   }
+}
 
-  // Check if this window is already initialized
-  if (initialized_windows.find(gtk_window) != initialized_windows.end() &&
-      initialized_windows[gtk_window]) {
-    std::cout << "Window already initialized for layer shell" << std::endl;
-    g_autoptr(FlValue) result = fl_value_new_bool(true);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+static const MonitorInfo *lookup_monitor(WaylandLayerShellPlugin *self,
+                                         gint64 monitor_id) {
+  if (self->monitors == nullptr || monitor_id <= 0 || monitor_id > G_MAXUINT) {
+    return nullptr;
   }
+  return monitor_registry_lookup(self->monitors,
+                                 static_cast<guint>(monitor_id));
+}
 
-  // Hide the window first if it's already shown
-  if (gtk_widget_get_mapped(GTK_WIDGET(gtk_window))) {
-    std::cout << "Window already mapped, hiding before layer shell init"
-              << std::endl;
-    gtk_widget_hide(GTK_WIDGET(gtk_window));
-
-    // Wait for the hide to take effect
-    while (gtk_widget_get_mapped(GTK_WIDGET(gtk_window))) {
-      gtk_main_iteration_do(FALSE);
-    }
-  }
-
-  int width = fl_value_get_int(fl_value_lookup_string(args, "width"));
-  int height = fl_value_get_int(fl_value_lookup_string(args, "height"));
-
-  gtk_widget_set_size_request(GTK_WIDGET(gtk_window), width, height);
-
-  // Remove decorations for layer shell
-  gtk_window_set_decorated(gtk_window, FALSE);
-
-  // Initialize layer shell for this specific window
-  gtk_layer_init_for_window(gtk_window);
-
-  // Set layer shell properties IMMEDIATELY after initialization
-  gtk_layer_set_layer(gtk_window, GTK_LAYER_SHELL_LAYER_TOP);
-  gtk_layer_set_anchor(gtk_window, GTK_LAYER_SHELL_EDGE_BOTTOM, TRUE);
-  gtk_layer_set_anchor(gtk_window, GTK_LAYER_SHELL_EDGE_LEFT, TRUE);
-  gtk_layer_set_anchor(gtk_window, GTK_LAYER_SHELL_EDGE_RIGHT, TRUE);
-  gtk_layer_set_anchor(gtk_window, GTK_LAYER_SHELL_EDGE_TOP, FALSE);
-
-  // Set margins to 0
-  gtk_layer_set_margin(gtk_window, GTK_LAYER_SHELL_EDGE_BOTTOM, 0);
-  gtk_layer_set_margin(gtk_window, GTK_LAYER_SHELL_EDGE_LEFT, 0);
-  gtk_layer_set_margin(gtk_window, GTK_LAYER_SHELL_EDGE_RIGHT, 0);
-
-  // Enable auto exclusive zone
-  gtk_layer_auto_exclusive_zone_enable(gtk_window);
-
-  // Set keyboard mode
-  gtk_layer_set_keyboard_mode(gtk_window,
-                              GTK_LAYER_SHELL_KEYBOARD_MODE_ON_DEMAND);
-
-  // FIXED: Try to set monitor from args if provided
-  FlValue *monitor_value = fl_value_lookup_string(args, "monitor");
-  if (monitor_value != nullptr) {
-    // Check if it's a string (old format) or a Monitor object (new format)
-    if (fl_value_get_type(monitor_value) == FL_VALUE_TYPE_STRING) {
-      // Handle string format: "0:24G1WG4"
-      const gchar *monitor_str = fl_value_get_string(monitor_value);
-      std::cout << "Monitor string provided: " << monitor_str << std::endl;
-      
-      // Parse monitor_str (e.g., "0:24G1WG4") to extract index
-      gchar **parts = g_strsplit(monitor_str, ":", 2);
-      if (parts != nullptr && parts[0] != nullptr) {
-        gint monitor_index = g_ascii_strtoll(parts[0], nullptr, 10);
-        std::cout << "Parsed monitor index: " << monitor_index << std::endl;
-        g_strfreev(parts);
-        
-        // Use monitor_index to set the monitor
-        GdkDisplay *display = gdk_display_get_default();
-        if (monitor_index >= 0 &&
-            monitor_index < gdk_display_get_n_monitors(display)) {
-          GdkMonitor *monitor = gdk_display_get_monitor(display, monitor_index);
-          gtk_layer_set_monitor(gtk_window, monitor);
-          std::cout << "Set monitor " << monitor_index << " during initialization" << std::endl;
-        } else {
-          std::cout << "Invalid monitor index: " << monitor_index << std::endl;
-        }
-      } else {
-        std::cout << "Failed to parse monitor string: " << monitor_str << std::endl;
-      }
-    } else {
-      // For non-string monitor values, try to handle them appropriately
-      std::cout << "Monitor parameter is not a string, type: " << fl_value_get_type(monitor_value) << std::endl;
-      
-      // If it's an int, treat it as a monitor index
-      if (fl_value_get_type(monitor_value) == FL_VALUE_TYPE_INT) {
-        gint monitor_index = fl_value_get_int(monitor_value);
-        std::cout << "Monitor index provided: " << monitor_index << std::endl;
-        
-        GdkDisplay *display = gdk_display_get_default();
-        if (monitor_index >= 0 &&
-            monitor_index < gdk_display_get_n_monitors(display)) {
-          GdkMonitor *monitor = gdk_display_get_monitor(display, monitor_index);
-          gtk_layer_set_monitor(gtk_window, monitor);
-          std::cout << "Set monitor " << monitor_index << " during initialization" << std::endl;
-        } else {
-          std::cout << "Invalid monitor index: " << monitor_index << std::endl;
+static FlValue *rectangle_to_value(const GdkRectangle *rectangle) {
+  int32_t values[] = {rectangle->x, rectangle->y, rectangle->width,
+                      rectangle->height};
+  return fl_value_new_int32_list(values, G_N_ELEMENTS(values));
+}
+
+static FlValue *monitor_info_to_value(const MonitorInfo *info) {
+  FlValue *value = fl_value_new_map();
+  fl_value_set_string_take(value, "id", fl_value_new_int(info->id));
+  fl_value_set_string_take(value, "manufacturer",
+                           fl_value_new_string(info->manufacturer.c_str()));
+  fl_value_set_string_take(value, "model",
+                           fl_value_new_string(info->model.c_str()));
+  fl_value_set_string_take(value, "geometry",
+                           rectangle_to_value(&info->geometry));
+  fl_value_set_string_take(value, "workarea",
+                           rectangle_to_value(&info->workarea));
+  fl_value_set_string_take(value, "scale_factor",
+                           fl_value_new_int(info->scale_factor));
+  fl_value_set_string_take(value, "refresh_rate",
+                           fl_value_new_int(info->refresh_rate));
+  fl_value_set_string_take(value, "width_mm", fl_value_new_int(info->width_mm));
+  fl_value_set_string_take(value, "height_mm",
+                           fl_value_new_int(info->height_mm));
+  return value;
+}
+
+// Pushes monitor registry changes to Dart on wayland_layer_shell/monitors.
+static void monitor_changed_cb(MonitorChange change, const MonitorInfo *info,
+                               gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  static const gchar *trace_names[] = {"monitor_added", "monitor_changed",
+                                       "monitor_removed"};
+  PLUGIN_TRACE_INSTANT(trace_names[change], "id", info->id);
+  LayerSurfaceQueue *queue = get_queue(self);
+  if (change == MONITOR_REMOVED && queue != nullptr) {
+    layer_surface_queue_forget_monitor(queue, info->monitor);
+  }
+  if (self->monitor_channel == nullptr || !self->monitors_listening) {
+    return;
+  }
+
+  static const gchar *names[] = {"added", "changed", "removed"};
+  g_autoptr(FlValue) event = fl_value_new_map();
+  fl_value_set_string_take(event, "event", fl_value_new_string(names[change]));
+  fl_value_set_string_take(event, "id", fl_value_new_int(info->id));
+  if (change != MONITOR_REMOVED) {
+    fl_value_set_string_take(event, "monitor", monitor_info_to_value(info));
+  }
+  fl_event_channel_send(self->monitor_channel, event, nullptr, nullptr);
+}
+
+// Sends one batch of toplevel changes as a list of maps, each with an
+// "event" key ("added", "changed" or "closed"), the "id", and the fields that
+// changed.
+static void toplevels_changed_cb(const ToplevelUpdate *updates,
+                                 size_t n_updates, gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  static const gchar *names[] = {"added", "changed", "closed"};
+  g_autoptr(FlValue) batch = fl_value_new_list();
+  for (size_t i = 0; i < n_updates; i++) {
+    const ToplevelUpdate *update = &updates[i];
+    const ToplevelInfo *info = update->info;
+    FlValue *event = fl_value_new_map();
+    fl_value_set_string_take(event, "event",
+                             fl_value_new_string(names[update->change]));
+    fl_value_set_string_take(event, "id", fl_value_new_int(info->id));
+    if (update->fields & TOPLEVEL_FIELD_APP_ID) {
+      fl_value_set_string_take(event, "app_id",
+                               fl_value_new_string(info->app_id.c_str()));
+    }
+    if (update->fields & TOPLEVEL_FIELD_TITLE) {
+      fl_value_set_string_take(event, "title",
+                               fl_value_new_string(info->title.c_str()));
+    }
+    if (update->fields & TOPLEVEL_FIELD_STATE) {
+      fl_value_set_string_take(event, "state", fl_value_new_int(info->state));
+    }
+    if (update->fields & TOPLEVEL_FIELD_MONITORS) {
+      FlValue *monitors = fl_value_new_list();
+      for (GdkMonitor *monitor : info->monitors) {
+        const MonitorInfo *monitor_info =
+            self->monitors != nullptr
+                ? monitor_registry_find(self->monitors, monitor)
+                : nullptr;
+        if (monitor_info != nullptr) {
+          fl_value_append_take(monitors, fl_value_new_int(monitor_info->id));
         }
       }
+      fl_value_set_string_take(event, "monitors", monitors);
     }
-  } else {
-    std::cout << "No monitor parameter provided" << std::endl;
+    if (update->fields & TOPLEVEL_FIELD_PARENT) {
+      fl_value_set_string_take(event, "parent",
+                               fl_value_new_int(info->parent_id));
+    }
+    fl_value_append_take(batch, event);
   }
+  fl_event_channel_send(self->toplevel_channel, batch, nullptr, nullptr);
+}
 
-  // Mark this window as initialized
-  initialized_windows[gtk_window] = true;
+// How long initialize waits for the window to unmap, and then for the first
+// configure of the new layer surface, before it gives up.
+static constexpr guint kInitializeTimeoutMs = 2000;
+
+// An initialize call that is waiting for the window, see initialize().
+struct _PendingInitialize {
+  // nullptr for calls made through wayland_layer_shell_plugin_invoke().
+  FlMethodCall *method_call;
+  FlValue *args;
+  // Whether the window was mapped when initialize was called. It is then
+  // hidden for the layer shell setup and shown again afterwards.
+  gboolean was_mapped;
+  // Start of the current phase, and how long the finished phases took, in
+  // microseconds. -1 for phases that did not run (yet).
+  gint64 phase_start;
+  gint64 hide_us;
+  gint64 init_us;
+  gint64 configure_us;
+  gulong unmap_handler_id;
+  gulong configure_handler_id;
+  guint idle_id;
+  guint timeout_id;
+};
 
-  std::cout << "Initialized layer shell for window: " << gtk_window
-            << std::endl;
+// Returns the timings of @pending, in the shape initialize reports them.
+static FlValue *initialize_timings_to_value(const PendingInitialize *pending) {
+  FlValue *value = fl_value_new_map();
+  if (pending->hide_us >= 0) {
+    fl_value_set_string_take(value, "hide_us",
+                             fl_value_new_int(pending->hide_us));
+  }
+  if (pending->init_us >= 0) {
+    fl_value_set_string_take(value, "init_us",
+                             fl_value_new_int(pending->init_us));
+  }
+  if (pending->configure_us >= 0) {
+    fl_value_set_string_take(value, "configure_us",
+                             fl_value_new_int(pending->configure_us));
+  }
+  return value;
+}
 
-  g_autoptr(FlValue) result = fl_value_new_bool(true);
+static FlMethodResponse *initialize_result(gboolean initialized,
+                                           const PendingInitialize *pending) {
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "initialized",
+                           fl_value_new_bool(initialized));
+  if (pending != nullptr) {
+    fl_value_set_string_take(result, "timings",
+                             initialize_timings_to_value(pending));
+  }
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
+// Drops the pending initialize call without responding to it.
+static void pending_initialize_free(WaylandLayerShellPlugin *self) {
+  PendingInitialize *pending = self->pending_initialize;
+  if (pending == nullptr) {
+    return;
+  }
+  self->pending_initialize = nullptr;
+
+  if (self->target_window != nullptr) {
+    if (pending->unmap_handler_id != 0) {
+      g_signal_handler_disconnect(self->target_window,
+                                  pending->unmap_handler_id);
+    }
+    if (pending->configure_handler_id != 0) {
+      g_signal_handler_disconnect(self->target_window,
+                                  pending->configure_handler_id);
+    }
+  }
+  if (pending->idle_id != 0) {
+    g_source_remove(pending->idle_id);
+  }
+  if (pending->timeout_id != 0) {
+    g_source_remove(pending->timeout_id);
+  }
+  g_clear_object(&pending->method_call);
+  fl_value_unref(pending->args);
+  g_free(pending);
+}
+
+// Answers the pending initialize call with @response and forgets about it.
+static void finish_initialize(WaylandLayerShellPlugin *self,
+                              FlMethodResponse *response) {
+  g_autoptr(FlMethodResponse) owned_response = response;
+  FlMethodCall *method_call = self->pending_initialize->method_call;
+  if (method_call == nullptr) {
+    self->invoke_response = FL_METHOD_RESPONSE(g_object_ref(response));
+    pending_initialize_free(self);
+    return;
+  }
+
+  g_object_ref(method_call);
+  pending_initialize_free(self);
+  fl_method_call_respond(method_call, owned_response, nullptr);
+  g_object_unref(method_call);
+}
+
+// Fails the pending initialize call with @code, reporting how far it got.
+static void fail_initialize(WaylandLayerShellPlugin *self, const gchar *code,
+                            const gchar *message) {
+  g_autoptr(FlValue) details =
+      initialize_timings_to_value(self->pending_initialize);
+  finish_initialize(self, FL_METHOD_RESPONSE(fl_method_error_response_new(
+                              code, message, details)));
+}
+
+// Turns @window into a layer surface with the plugin's defaults.
+static void init_layer_surface(WaylandLayerShellPlugin *self,
+                               GtkWindow *gtk_window, FlValue *args) {
+  WaylandLayerShellConfig config;
+  wayland_layer_shell_config_init(&config);
+  config.width = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::initialize::kWidth));
+  config.height = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::initialize::kHeight));
+
+  // Place the surface on the requested monitor, if any
+  GdkMonitor *monitor = nullptr;
+  FlValue *monitor_value =
+      fl_value_get_list_value(args, channel_api::initialize::kMonitor);
+  if (fl_value_get_type(monitor_value) != FL_VALUE_TYPE_NULL) {
+    gint64 monitor_id = parse_monitor_id(monitor_value);
+    const MonitorInfo *info = lookup_monitor(self, monitor_id);
+    if (info != nullptr) {
+      monitor = info->monitor;
+      PLUGIN_LOG_D("Set monitor %" G_GINT64_FORMAT " during initialization",
+                   monitor_id);
+    } else {
+      PLUGIN_LOG_W("Invalid monitor id: %" G_GINT64_FORMAT, monitor_id);
+    }
+  }
+
+  layer_shell_setup(gtk_window, &config, monitor);
+  wayland_layer_shell_config_clear(&config);
+}
+
+static gboolean initialize_configure_cb(GtkWidget *widget, GdkEvent *event,
+                                        gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  PendingInitialize *pending = self->pending_initialize;
+  pending->configure_us = g_get_monotonic_time() - pending->phase_start;
+  finish_initialize(self, initialize_result(TRUE, pending));
+  return FALSE;
+}
+
+// Runs once the window is unmapped: sets up the layer surface and, if the
+// window was visible before, shows it again and waits for its first
+// configure.
+static void initialize_unmapped(WaylandLayerShellPlugin *self) {
+  PendingInitialize *pending = self->pending_initialize;
+  GtkWindow *window = self->target_window;
+
+  pending->phase_start = g_get_monotonic_time();
+  init_layer_surface(self, window, pending->args);
+  pending->init_us = g_get_monotonic_time() - pending->phase_start;
+
+  if (!pending->was_mapped) {
+    // The surface gets configured whenever the app shows the window.
+    finish_initialize(self, initialize_result(TRUE, pending));
+    return;
+  }
+
+  pending->phase_start = g_get_monotonic_time();
+  pending->configure_handler_id =
+      g_signal_connect(window, "configure-event",
+                       G_CALLBACK(initialize_configure_cb), self);
+  gtk_widget_show(GTK_WIDGET(window));
+}
+
+static gboolean initialize_idle_cb(gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  self->pending_initialize->idle_id = 0;
+  initialize_unmapped(self);
+  return G_SOURCE_REMOVE;
+}
+
+// The layer surface is set up from an idle callback rather than from inside
+// GTK's unmap handling.
+static void initialize_unmap_cb(GtkWidget *widget, gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  PendingInitialize *pending = self->pending_initialize;
+  pending->hide_us = g_get_monotonic_time() - pending->phase_start;
+  g_signal_handler_disconnect(widget, pending->unmap_handler_id);
+  pending->unmap_handler_id = 0;
+  pending->idle_id = g_idle_add(initialize_idle_cb, self);
+}
+
+static gboolean initialize_timeout_cb(gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  self->pending_initialize->timeout_id = 0;
+  fail_initialize(self, "timeout",
+                  self->pending_initialize->init_us < 0
+                      ? "Window did not unmap"
+                      : "Layer surface was not configured");
+  return G_SOURCE_REMOVE;
+}
+
+// Turns the plugin's window into a layer surface.
+//
+// A mapped window has to be hidden first. Rather than spinning the main loop
+// until it is gone, the call is held and answered once the window has been
+// unmapped, set up and shown again, or with a "timeout" error if that takes
+// longer than kInitializeTimeoutMs. Returns nullptr in that case; the
+// response is sent later.
+static FlMethodResponse *initialize(WaylandLayerShellPlugin *self,
+                                    FlMethodCall *method_call, FlValue *args) {
+  GtkWindow *gtk_window = get_window(self);
+
+  if (gtk_window == nullptr) {
+    PLUGIN_LOG_E("Could not get GTK window");
+    return initialize_result(FALSE, nullptr);
+  }
+
+  if (gtk_layer_is_supported() == 0) {
+    PLUGIN_LOG_E("Layer shell not supported");
+    return initialize_result(FALSE, nullptr);
+  }
+
+  // Check if this window is already initialized
+  if (layer_window_state_get(gtk_window)->initialized) {
+    PLUGIN_LOG_D("Window already initialized for layer shell");
+    return initialize_result(TRUE, nullptr);
+  }
+
+  if (self->pending_initialize != nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "in_progress", "initialize is already in progress", nullptr));
+  }
+
+  PendingInitialize *pending = g_new0(PendingInitialize, 1);
+  pending->method_call =
+      method_call != nullptr ? FL_METHOD_CALL(g_object_ref(method_call))
+                             : nullptr;
+  pending->args = fl_value_ref(args);
+  pending->was_mapped = gtk_widget_get_mapped(GTK_WIDGET(gtk_window));
+  pending->hide_us = -1;
+  pending->init_us = -1;
+  pending->configure_us = -1;
+  pending->timeout_id =
+      g_timeout_add(kInitializeTimeoutMs, initialize_timeout_cb, self);
+  self->pending_initialize = pending;
+
+  if (!pending->was_mapped) {
+    initialize_unmapped(self);
+    return nullptr;
+  }
+
+  // Hide the window first; initialization continues once it is unmapped
+  PLUGIN_LOG_D("Window already mapped, hiding before layer shell init");
+  pending->phase_start = g_get_monotonic_time();
+  pending->unmap_handler_id = g_signal_connect(
+      gtk_window, "unmap", G_CALLBACK(initialize_unmap_cb), self);
+  gtk_widget_hide(GTK_WIDGET(gtk_window));
+  return nullptr;
+}
+
 static FlMethodResponse *show_window(WaylandLayerShellPlugin *self) {
   GtkWindow *gtk_window = get_window(self);
   if (gtk_window == nullptr) {
@@ -195,16 +864,76 @@ static FlMethodResponse *show_window(WaylandLayerShellPlugin *self) {
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
+// Maps the layer surface out of sight, see layer_presenter.h.
+static FlMethodResponse *prepare(WaylandLayerShellPlugin *self) {
+  GtkWindow *window = get_window(self);
+  gboolean prepared = window != nullptr &&
+                      layer_window_state_get(window)->initialized &&
+                      layer_presenter_prepare(&self->presenter);
+  if (!prepared) {
+    PLUGIN_LOG_W("Only an initialized layer surface can be prepared");
+  }
+  g_autoptr(FlValue) result = fl_value_new_bool(prepared);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse *present(WaylandLayerShellPlugin *self,
+                                 FlValue *args) {
+  gboolean exclusive_keyboard = fl_value_get_bool(
+      fl_value_get_list_value(args, channel_api::present::kExclusiveKeyboard));
+  g_autoptr(FlValue) result = fl_value_new_bool(
+      get_window(self) != nullptr &&
+      layer_presenter_present(&self->presenter, exclusive_keyboard));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse *dismiss(WaylandLayerShellPlugin *self) {
+  g_autoptr(FlValue) result =
+      fl_value_new_bool(get_window(self) != nullptr &&
+                        layer_presenter_dismiss(&self->presenter));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Range checks for the enum values Dart sends as ints. gtk-layer-shell rejects
+// out of range values itself, but the queue would store them in its shadow
+// state and index its per-edge arrays with them.
+static gboolean valid_edge(gint64 edge) {
+  return edge >= 0 && edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER;
+}
+
+static gboolean valid_layer(gint64 layer) {
+  return layer >= 0 && layer < GTK_LAYER_SHELL_LAYER_ENTRY_NUMBER;
+}
+
+static gboolean valid_keyboard_mode(gint64 keyboard_mode) {
+  return keyboard_mode >= 0 &&
+         keyboard_mode < GTK_LAYER_SHELL_KEYBOARD_MODE_ENTRY_NUMBER;
+}
+
+static gboolean valid_easing(gint64 easing) {
+  return easing >= LAYER_EASING_LINEAR && easing <= LAYER_EASING_EASE_IN_OUT;
+}
+
+static FlMethodResponse *bad_args_response(const gchar *message) {
+  return FL_METHOD_RESPONSE(
+      fl_method_error_response_new("bad_args", message, nullptr));
+}
+
 static FlMethodResponse *set_layer(WaylandLayerShellPlugin *self,
                                    FlValue *args) {
+  gint64 layer = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_layer::kLayer));
+  if (!valid_layer(layer)) {
+    return bad_args_response("Invalid layer");
+  }
   GtkWindow *window = get_window(self);
   if (window == nullptr) {
     g_autoptr(FlValue) result = fl_value_new_bool(false);
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  int layer = fl_value_get_int(fl_value_lookup_string(args, "layer"));
-  gtk_layer_set_layer(window, static_cast<GtkLayerShellLayer>(layer));
+  layer_surface_queue_set_layer(get_queue(self),
+                                static_cast<GtkLayerShellLayer>(layer));
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
@@ -216,17 +945,19 @@ static FlMethodResponse *get_layer(WaylandLayerShellPlugin *self) {
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  g_autoptr(FlValue) result = fl_value_new_int(gtk_layer_get_layer(window));
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(get_queue(self), &state);
+  g_autoptr(FlValue) result = fl_value_new_int(state.layer);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
+// Returns the cached monitors; the display is not re-enumerated.
 static FlMethodResponse *get_monitor_list(WaylandLayerShellPlugin *self) {
-  GdkDisplay *display = gdk_display_get_default();
   g_autoptr(FlValue) result = fl_value_new_list();
-  for (int i = 0; i < gdk_display_get_n_monitors(display); i++) {
-    GdkMonitor *monitor = gdk_display_get_monitor(display, i);
-    gchar *val = g_strdup_printf("%i:%s", i, gdk_monitor_get_model(monitor));
-    fl_value_append_take(result, fl_value_new_string(val));
+  if (self->monitors != nullptr) {
+    for (const MonitorInfo &info : self->monitors->monitors) {
+      fl_value_append_take(result, monitor_info_to_value(&info));
+    }
   }
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
@@ -239,52 +970,22 @@ static FlMethodResponse *set_monitor(WaylandLayerShellPlugin *self,
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  // FIXED: Handle different monitor parameter types
-  FlValue *monitor_value = fl_value_lookup_string(args, "id");
-  if (monitor_value == nullptr) {
-    std::cout << "No monitor ID provided" << std::endl;
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
-  }
-
-  gint monitor_index = -1;
-  
-  if (fl_value_get_type(monitor_value) == FL_VALUE_TYPE_STRING) {
-    // Handle string format: "0:24G1WG4"
-    const gchar *monitor_str = fl_value_get_string(monitor_value);
-    std::cout << "Monitor string: " << monitor_str << std::endl;
-    
-    // Parse the monitor string (format: "index:name")
-    gchar **parts = g_strsplit(monitor_str, ":", 2);
-    if (parts != nullptr && parts[0] != nullptr) {
-      monitor_index = g_ascii_strtoll(parts[0], nullptr, 10);
-      g_strfreev(parts);
-    }
-  } else if (fl_value_get_type(monitor_value) == FL_VALUE_TYPE_INT) {
-    // Handle integer format
-    monitor_index = fl_value_get_int(monitor_value);
-    std::cout << "Monitor index: " << monitor_index << std::endl;
-  } else {
-    std::cout << "ERROR: Monitor parameter type not supported: " << fl_value_get_type(monitor_value) << std::endl;
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
-  }
+  gint64 monitor_id = parse_monitor_id(
+      fl_value_get_list_value(args, channel_api::set_monitor::kId));
 
-  GdkDisplay *display = gdk_display_get_default();
-
-  if (monitor_index == -1) {
-    gtk_layer_set_monitor(window, NULL);
-    std::cout << "Set monitor to NULL for window: " << window << std::endl;
-  } else if (monitor_index >= 0 &&
-             monitor_index < gdk_display_get_n_monitors(display)) {
-    GdkMonitor *monitor = gdk_display_get_monitor(display, monitor_index);
-    gtk_layer_set_monitor(window, monitor);
-    std::cout << "Set monitor " << monitor_index << " for window: " << window
-              << std::endl;
+  if (monitor_id == -1) {
+    layer_surface_queue_set_monitor(get_queue(self), nullptr);
+    PLUGIN_LOG_D("Set monitor to NULL for window %p", window);
   } else {
-    std::cout << "Invalid monitor index: " << monitor_index << std::endl;
-    g_autoptr(FlValue) result = fl_value_new_bool(false);
-    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+    const MonitorInfo *info = lookup_monitor(self, monitor_id);
+    if (info == nullptr) {
+      PLUGIN_LOG_W("Invalid monitor id: %" G_GINT64_FORMAT, monitor_id);
+      g_autoptr(FlValue) result = fl_value_new_bool(false);
+      return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+    }
+    layer_surface_queue_set_monitor(get_queue(self), info->monitor);
+    PLUGIN_LOG_D("Set monitor %" G_GINT64_FORMAT " for window %p", monitor_id,
+                 window);
   }
 
   g_autoptr(FlValue) result = fl_value_new_bool(true);
@@ -293,65 +994,83 @@ static FlMethodResponse *set_monitor(WaylandLayerShellPlugin *self,
 
 static FlMethodResponse *set_anchor(WaylandLayerShellPlugin *self,
                                     FlValue *args) {
+  gint64 edge = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_anchor::kEdge));
+  if (!valid_edge(edge)) {
+    return bad_args_response("Invalid edge");
+  }
   GtkWindow *window = get_window(self);
   if (window == nullptr) {
     g_autoptr(FlValue) result = fl_value_new_bool(false);
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  int edge = fl_value_get_int(fl_value_lookup_string(args, "edge"));
-  gboolean anchor_to_edge =
-      fl_value_get_bool(fl_value_lookup_string(args, "anchor_to_edge"));
+  gboolean anchor_to_edge = fl_value_get_bool(
+      fl_value_get_list_value(args, channel_api::set_anchor::kAnchorToEdge));
 
-  gtk_layer_set_anchor(window, static_cast<GtkLayerShellEdge>(edge),
-                       anchor_to_edge);
+  layer_surface_queue_set_anchor(
+      get_queue(self), static_cast<GtkLayerShellEdge>(edge), anchor_to_edge);
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
 static FlMethodResponse *get_anchor(WaylandLayerShellPlugin *self,
                                     FlValue *args) {
+  gint64 edge = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::get_anchor::kEdge));
+  if (!valid_edge(edge)) {
+    return bad_args_response("Invalid edge");
+  }
   GtkWindow *window = get_window(self);
   if (window == nullptr) {
     g_autoptr(FlValue) result = fl_value_new_bool(false);
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  int edge = fl_value_get_int(fl_value_lookup_string(args, "edge"));
-  g_autoptr(FlValue) result = fl_value_new_bool(
-      gtk_layer_get_anchor(window, static_cast<GtkLayerShellEdge>(edge)));
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(get_queue(self), &state);
+  g_autoptr(FlValue) result = fl_value_new_bool(state.anchors[edge]);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
 static FlMethodResponse *set_margin(WaylandLayerShellPlugin *self,
                                     FlValue *args) {
+  gint64 edge = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_margin::kEdge));
+  if (!valid_edge(edge)) {
+    return bad_args_response("Invalid edge");
+  }
   GtkWindow *window = get_window(self);
   if (window == nullptr) {
     g_autoptr(FlValue) result = fl_value_new_bool(false);
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  int edge = fl_value_get_int(fl_value_lookup_string(args, "edge"));
-  int margin_size =
-      fl_value_get_int(fl_value_lookup_string(args, "margin_size"));
+  int margin_size = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_margin::kMarginSize));
 
-  gtk_layer_set_margin(window, static_cast<GtkLayerShellEdge>(edge),
-                       margin_size);
+  layer_surface_queue_set_margin(
+      get_queue(self), static_cast<GtkLayerShellEdge>(edge), margin_size);
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
 static FlMethodResponse *get_margin(WaylandLayerShellPlugin *self,
                                     FlValue *args) {
+  gint64 edge = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::get_margin::kEdge));
+  if (!valid_edge(edge)) {
+    return bad_args_response("Invalid edge");
+  }
   GtkWindow *window = get_window(self);
   if (window == nullptr) {
     g_autoptr(FlValue) result = fl_value_new_int(0);
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  int edge = fl_value_get_int(fl_value_lookup_string(args, "edge"));
-  g_autoptr(FlValue) result = fl_value_new_int(
-      gtk_layer_get_margin(window, static_cast<GtkLayerShellEdge>(edge)));
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(get_queue(self), &state);
+  g_autoptr(FlValue) result = fl_value_new_int(state.margins[edge]);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
@@ -363,9 +1082,9 @@ static FlMethodResponse *set_exclusive_zone(WaylandLayerShellPlugin *self,
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  int exclusive_zone =
-      fl_value_get_int(fl_value_lookup_string(args, "exclusive_zone"));
-  gtk_layer_set_exclusive_zone(window, exclusive_zone);
+  int exclusive_zone = fl_value_get_int(fl_value_get_list_value(
+      args, channel_api::set_exclusive_zone::kExclusiveZone));
+  layer_surface_queue_set_exclusive_zone(get_queue(self), exclusive_zone);
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
@@ -377,8 +1096,9 @@ static FlMethodResponse *get_exclusive_zone(WaylandLayerShellPlugin *self) {
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  g_autoptr(FlValue) result =
-      fl_value_new_int(gtk_layer_get_exclusive_zone(window));
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(get_queue(self), &state);
+  g_autoptr(FlValue) result = fl_value_new_int(state.exclusive_zone);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
@@ -390,7 +1110,7 @@ enable_auto_exclusive_zone(WaylandLayerShellPlugin *self) {
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  gtk_layer_auto_exclusive_zone_enable(window);
+  layer_surface_queue_enable_auto_exclusive_zone(get_queue(self));
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
@@ -403,23 +1123,27 @@ is_auto_exclusive_zone_enabled(WaylandLayerShellPlugin *self) {
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  g_autoptr(FlValue) result =
-      fl_value_new_bool(gtk_layer_auto_exclusive_zone_is_enabled(window));
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(get_queue(self), &state);
+  g_autoptr(FlValue) result = fl_value_new_bool(state.auto_exclusive_zone);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
 static FlMethodResponse *set_keyboard_mode(WaylandLayerShellPlugin *self,
                                            FlValue *args) {
+  gint64 keyboard_mode = fl_value_get_int(fl_value_get_list_value(
+      args, channel_api::set_keyboard_mode::kKeyboardMode));
+  if (!valid_keyboard_mode(keyboard_mode)) {
+    return bad_args_response("Invalid keyboard mode");
+  }
   GtkWindow *window = get_window(self);
   if (window == nullptr) {
     g_autoptr(FlValue) result = fl_value_new_bool(false);
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  int keyboard_mode =
-      fl_value_get_int(fl_value_lookup_string(args, "keyboard_mode"));
-  gtk_layer_set_keyboard_mode(
-      window, static_cast<GtkLayerShellKeyboardMode>(keyboard_mode));
+  layer_surface_queue_set_keyboard_mode(
+      get_queue(self), static_cast<GtkLayerShellKeyboardMode>(keyboard_mode));
   g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
@@ -431,90 +1155,1305 @@ static FlMethodResponse *get_keyboard_mode(WaylandLayerShellPlugin *self) {
     return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  g_autoptr(FlValue) result =
-      fl_value_new_int(gtk_layer_get_keyboard_mode(window));
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(get_queue(self), &state);
+  g_autoptr(FlValue) result = fl_value_new_int(state.keyboard_mode);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-// Called when a method call is received from Flutter.
-static void
-wayland_layer_shell_plugin_handle_method_call(WaylandLayerShellPlugin *self,
-                                              FlMethodCall *method_call) {
-  g_autoptr(FlMethodResponse) response = nullptr;
-
-  const gchar *method = fl_method_call_get_name(method_call);
-  FlValue *args = fl_method_call_get_args(method_call);
-
-  if (strcmp(method, "getPlatformVersion") == 0) {
-    response = get_platform_version();
-  } else if (strcmp(method, "isSupported") == 0) {
-    response = is_supported(self);
-  } else if (strcmp(method, "initialize") == 0) {
-    response = initialize(self, args);
-  } else if (strcmp(method, "showWindow") == 0) {
-    response = show_window(self);
-  } else if (strcmp(method, "setLayer") == 0) {
-    response = set_layer(self, args);
-  } else if (strcmp(method, "getLayer") == 0) {
-    response = get_layer(self);
-  } else if (strcmp(method, "getMonitorList") == 0) {
-    response = get_monitor_list(self);
-  } else if (strcmp(method, "setMonitor") == 0) {
-    response = set_monitor(self, args);
-  } else if (strcmp(method, "setAnchor") == 0) {
-    response = set_anchor(self, args);
-  } else if (strcmp(method, "getAnchor") == 0) {
-    response = get_anchor(self, args);
-  } else if (strcmp(method, "setMargin") == 0) {
-    response = set_margin(self, args);
-  } else if (strcmp(method, "getMargin") == 0) {
-    response = get_margin(self, args);
-  } else if (strcmp(method, "setExclusiveZone") == 0) {
-    response = set_exclusive_zone(self, args);
-  } else if (strcmp(method, "getExclusiveZone") == 0) {
-    response = get_exclusive_zone(self);
-  } else if (strcmp(method, "enableAutoExclusiveZone") == 0) {
-    response = enable_auto_exclusive_zone(self);
-  } else if (strcmp(method, "isAutoExclusiveZoneEnabled") == 0) {
-    response = is_auto_exclusive_zone_enabled(self);
-  } else if (strcmp(method, "setKeyboardMode") == 0) {
-    response = set_keyboard_mode(self, args);
-  } else if (strcmp(method, "getKeyboardMode") == 0) {
-    response = get_keyboard_mode(self);
-  } else {
-    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+// Changes the size request of the window. Non-positive dimensions are left to
+// the compositor (when anchored to both opposite edges) or to the content.
+// Like the other setters the change is applied with the next frame, so a
+// burst of resizes turns into one.
+static FlMethodResponse *set_size(WaylandLayerShellPlugin *self,
+                                  FlValue *args) {
+  LayerSurfaceQueue *queue = get_queue(self);
+  if (queue == nullptr) {
+    g_autoptr(FlValue) result = fl_value_new_bool(false);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
   }
 
-  fl_method_call_respond(method_call, response, nullptr);
-}
-
-FlMethodResponse *get_platform_version() {
-  struct utsname uname_data = {};
-  uname(&uname_data);
-  g_autofree gchar *version = g_strdup_printf("Linux %s", uname_data.version);
-  g_autoptr(FlValue) result = fl_value_new_string(version);
+  int width = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_size::kWidth));
+  int height = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_size::kHeight));
+  // A hidden surface takes the size when it is revealed.
+  if (auto_hide_set_size(&self->auto_hide, width, height)) {
+    g_autoptr(FlValue) result = fl_value_new_bool(true);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+  layer_surface_queue_set_size(queue, width > 0 ? width : -1,
+                               height > 0 ? height : -1);
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
   return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
 }
 
-static void wayland_layer_shell_plugin_dispose(GObject *object) {
-  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(object);
+// Returns @state as a map, in the same shape that apply_config accepts.
+static FlValue *layer_state_to_value(const LayerSurfaceState *state) {
+  FlValue *value = fl_value_new_map();
+  fl_value_set_string_take(value, "layer", fl_value_new_int(state->layer));
 
-  // Clean up our window tracking
-  if (self->target_window != nullptr) {
-    initialized_windows.erase(self->target_window);
-    self->target_window = nullptr;
+  FlValue *anchors = fl_value_new_list();
+  FlValue *margins = fl_value_new_list();
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    fl_value_append_take(anchors, fl_value_new_bool(state->anchors[edge]));
+    fl_value_append_take(margins, fl_value_new_int(state->margins[edge]));
   }
-
-  G_OBJECT_CLASS(wayland_layer_shell_plugin_parent_class)->dispose(object);
+  fl_value_set_string_take(value, "anchors", anchors);
+  fl_value_set_string_take(value, "margins", margins);
+
+  fl_value_set_string_take(value, "exclusive_zone",
+                           fl_value_new_int(state->exclusive_zone));
+  fl_value_set_string_take(value, "auto_exclusive_zone",
+                           fl_value_new_bool(state->auto_exclusive_zone));
+  fl_value_set_string_take(value, "keyboard_mode",
+                           fl_value_new_int(state->keyboard_mode));
+  return value;
 }
 
-static void
-wayland_layer_shell_plugin_class_init(WaylandLayerShellPluginClass *klass) {
+// Applies every layer surface property present in @args at once. Null
+// arguments (and null list entries for per-edge values) are left unchanged.
+//
+// The changes are queued together with anything already pending and flushed
+// right away, so they reach the compositor in a single surface commit.
+static FlMethodResponse *apply_config(WaylandLayerShellPlugin *self,
+                                      FlValue *args) {
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "no_window", "Could not get GTK window", nullptr));
+  }
+
+  // Checked up front, so a bad config changes nothing.
+  FlValue *layer =
+      fl_value_get_list_value(args, channel_api::apply_config::kLayer);
+  FlValue *keyboard_mode =
+      fl_value_get_list_value(args, channel_api::apply_config::kKeyboardMode);
+  if (fl_value_get_type(layer) == FL_VALUE_TYPE_INT &&
+      !valid_layer(fl_value_get_int(layer))) {
+    return bad_args_response("Invalid layer");
+  }
+  if (fl_value_get_type(keyboard_mode) == FL_VALUE_TYPE_INT &&
+      !valid_keyboard_mode(fl_value_get_int(keyboard_mode))) {
+    return bad_args_response("Invalid keyboard mode");
+  }
+
+  LayerSurfaceQueue *queue = get_queue(self);
+
+  if (fl_value_get_type(layer) == FL_VALUE_TYPE_INT) {
+    layer_surface_queue_set_layer(
+        queue, static_cast<GtkLayerShellLayer>(fl_value_get_int(layer)));
+  }
+
+  FlValue *anchors =
+      fl_value_get_list_value(args, channel_api::apply_config::kAnchors);
+  FlValue *margins =
+      fl_value_get_list_value(args, channel_api::apply_config::kMargins);
+  for (int edge = 0; edge < GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER; edge++) {
+    if (fl_value_get_type(anchors) == FL_VALUE_TYPE_LIST &&
+        static_cast<size_t>(edge) < fl_value_get_length(anchors)) {
+      FlValue *anchor = fl_value_get_list_value(anchors, edge);
+      if (fl_value_get_type(anchor) == FL_VALUE_TYPE_BOOL) {
+        layer_surface_queue_set_anchor(queue,
+                                       static_cast<GtkLayerShellEdge>(edge),
+                                       fl_value_get_bool(anchor));
+      }
+    }
+    if (fl_value_get_type(margins) == FL_VALUE_TYPE_LIST &&
+        static_cast<size_t>(edge) < fl_value_get_length(margins)) {
+      FlValue *margin = fl_value_get_list_value(margins, edge);
+      if (fl_value_get_type(margin) == FL_VALUE_TYPE_INT) {
+        layer_surface_queue_set_margin(queue,
+                                       static_cast<GtkLayerShellEdge>(edge),
+                                       fl_value_get_int(margin));
+      }
+    }
+  }
+
+  // An explicit exclusive zone disables the automatic one, so only enable
+  // auto exclusive zone when no fixed value was given.
+  FlValue *exclusive_zone =
+      fl_value_get_list_value(args, channel_api::apply_config::kExclusiveZone);
+  FlValue *auto_exclusive_zone = fl_value_get_list_value(
+      args, channel_api::apply_config::kAutoExclusiveZone);
+  if (fl_value_get_type(exclusive_zone) == FL_VALUE_TYPE_INT) {
+    layer_surface_queue_set_exclusive_zone(queue,
+                                           fl_value_get_int(exclusive_zone));
+  } else if (fl_value_get_type(auto_exclusive_zone) == FL_VALUE_TYPE_BOOL &&
+             fl_value_get_bool(auto_exclusive_zone)) {
+    layer_surface_queue_enable_auto_exclusive_zone(queue);
+  }
+
+  if (fl_value_get_type(keyboard_mode) == FL_VALUE_TYPE_INT) {
+    layer_surface_queue_set_keyboard_mode(
+        queue, static_cast<GtkLayerShellKeyboardMode>(
+                   fl_value_get_int(keyboard_mode)));
+  }
+
+  layer_surface_queue_flush(queue);
+
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(queue, &state);
+  g_autoptr(FlValue) result = layer_state_to_value(&state);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Applies any layer surface changes still waiting for the next frame.
+static FlMethodResponse *flush(WaylandLayerShellPlugin *self) {
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    g_autoptr(FlValue) result = fl_value_new_bool(false);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+
+  layer_surface_queue_flush(get_queue(self));
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Returns how many setter calls were received, how many of them changed
+// nothing and how many surface commits the rest turned into, remaps
+// included.
+static FlMethodResponse *get_commit_stats(WaylandLayerShellPlugin *self) {
+  g_autoptr(FlValue) result = fl_value_new_map();
+  guint64 setter_calls = 0;
+  guint64 elided_calls = 0;
+  guint64 commits = 0;
+  guint64 remaps = 0;
+  guint64 region_updates = 0;
+  guint64 elided_region_updates = 0;
+  GtkWindow *window = get_window(self);
+  if (window != nullptr) {
+    LayerWindowState *window_state = layer_window_state_get(window);
+    setter_calls = window_state->queue.setter_calls;
+    elided_calls = window_state->queue.elided_calls;
+    commits = window_state->queue.commits;
+    remaps = window_state->queue.remaps;
+    region_updates = window_state->regions.updates;
+    elided_region_updates = window_state->regions.elided_updates;
+  }
+  fl_value_set_string_take(result, "setter_calls",
+                           fl_value_new_int(setter_calls));
+  fl_value_set_string_take(result, "elided_calls",
+                           fl_value_new_int(elided_calls));
+  fl_value_set_string_take(result, "commits", fl_value_new_int(commits));
+  fl_value_set_string_take(result, "remaps", fl_value_new_int(remaps));
+  fl_value_set_string_take(result, "region_updates",
+                           fl_value_new_int(region_updates));
+  fl_value_set_string_take(result, "elided_region_updates",
+                           fl_value_new_int(elided_region_updates));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Reads a region sent as a flat list of x, y, width, height quadruples into
+// *@region. A null @value gives nullptr. Returns FALSE if the list is
+// malformed.
+static gboolean read_region(FlValue *value, cairo_region_t **region) {
+  *region = nullptr;
+  if (fl_value_get_type(value) == FL_VALUE_TYPE_NULL) {
+    return TRUE;
+  }
+  if (fl_value_get_type(value) != FL_VALUE_TYPE_LIST ||
+      fl_value_get_length(value) % 4 != 0) {
+    return FALSE;
+  }
+
+  *region = cairo_region_create();
+  for (size_t i = 0; i < fl_value_get_length(value); i += 4) {
+    int values[4];
+    for (size_t j = 0; j < 4; j++) {
+      FlValue *item = fl_value_get_list_value(value, i + j);
+      if (fl_value_get_type(item) != FL_VALUE_TYPE_INT) {
+        g_clear_pointer(region, cairo_region_destroy);
+        return FALSE;
+      }
+      values[j] = fl_value_get_int(item);
+    }
+    if (values[2] <= 0 || values[3] <= 0) {
+      continue;
+    }
+    cairo_rectangle_int_t rectangle = {values[0], values[1], values[2],
+                                       values[3]};
+    cairo_region_union_rectangle(*region, &rectangle);
+  }
+  return TRUE;
+}
+
+// Shared by setInputRegion and setOpaqueRegion.
+static FlMethodResponse *
+set_region(WaylandLayerShellPlugin *self, FlValue *value,
+           gboolean (*setter)(SurfaceRegions *, const cairo_region_t *)) {
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    g_autoptr(FlValue) result = fl_value_new_bool(false);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+
+  cairo_region_t *region = nullptr;
+  if (!read_region(value, &region)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "invalid_region", "Expected x, y, width, height quadruples", nullptr));
+  }
+  if (!setter(&layer_window_state_get(window)->regions, region)) {
+    PLUGIN_LOG_D("Region unchanged, not resending");
+  }
+  g_clear_pointer(&region, cairo_region_destroy);
+
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Restricts input to the given rectangles; null means the whole surface.
+static FlMethodResponse *set_input_region(WaylandLayerShellPlugin *self,
+                                          FlValue *args) {
+  return set_region(
+      self,
+      fl_value_get_list_value(args, channel_api::set_input_region::kRects),
+      surface_regions_set_input);
+}
+
+// Marks the given rectangles opaque; null hands the region back to GTK.
+static FlMethodResponse *set_opaque_region(WaylandLayerShellPlugin *self,
+                                           FlValue *args) {
+  return set_region(
+      self,
+      fl_value_get_list_value(args, channel_api::set_opaque_region::kRects),
+      surface_regions_set_opaque);
+}
+
+// Reads up to @count ints from @list into @values. Returns a mask with bit
+// (1 << i) set for each entry present; missing and null entries are stored
+// as 0.
+static guint read_int_list(FlValue *list, int *values, size_t count) {
+  guint present = 0;
+  for (size_t i = 0; i < count; i++) {
+    values[i] = 0;
+    if (fl_value_get_type(list) == FL_VALUE_TYPE_LIST &&
+        i < fl_value_get_length(list)) {
+      FlValue *value = fl_value_get_list_value(list, i);
+      if (fl_value_get_type(value) == FL_VALUE_TYPE_INT) {
+        values[i] = fl_value_get_int(value);
+        present |= 1u << i;
+      }
+    }
+  }
+  return present;
+}
+
+// Starts a native margin animation and returns its id. Completion is posted
+// as an "animationDone" event.
+static FlMethodResponse *animate_margins(WaylandLayerShellPlugin *self,
+                                         FlValue *args) {
+  gint64 duration_ms = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::animate_margins::kDurationMs));
+  gint64 easing = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::animate_margins::kEasing));
+  if (duration_ms < 0) {
+    return bad_args_response("Invalid duration");
+  }
+  if (!valid_easing(easing)) {
+    return bad_args_response("Invalid easing");
+  }
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "no_window", "Could not get GTK window", nullptr));
+  }
+
+  int from[GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER];
+  int to[GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER];
+  guint from_mask = read_int_list(
+      fl_value_get_list_value(args, channel_api::animate_margins::kFrom), from,
+      GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER);
+  guint to_mask = read_int_list(
+      fl_value_get_list_value(args, channel_api::animate_margins::kTo), to,
+      GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER);
+
+  gint64 id = layer_animator_animate_margins(
+      &self->animator, from, from_mask, to, to_mask, duration_ms,
+      static_cast<LayerEasing>(easing));
+  g_autoptr(FlValue) result = fl_value_new_int(id);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Starts a native size request animation and returns its id. Completion is
+// posted as an "animationDone" event.
+static FlMethodResponse *animate_size(WaylandLayerShellPlugin *self,
+                                      FlValue *args) {
+  gint64 duration_ms = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::animate_size::kDurationMs));
+  gint64 easing = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::animate_size::kEasing));
+  if (duration_ms < 0) {
+    return bad_args_response("Invalid duration");
+  }
+  if (!valid_easing(easing)) {
+    return bad_args_response("Invalid easing");
+  }
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "no_window", "Could not get GTK window", nullptr));
+  }
+
+  int from[2];
+  int to[2];
+  guint from_mask = read_int_list(
+      fl_value_get_list_value(args, channel_api::animate_size::kFrom), from, 2);
+  read_int_list(fl_value_get_list_value(args, channel_api::animate_size::kTo),
+                to, 2);
+
+  gint64 id = layer_animator_animate_size(
+      &self->animator, from_mask == 0x3 ? from : nullptr, to, duration_ms,
+      static_cast<LayerEasing>(easing));
+  g_autoptr(FlValue) result = fl_value_new_int(id);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Stops running animations at their current values.
+static FlMethodResponse *cancel_animations(WaylandLayerShellPlugin *self) {
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    g_autoptr(FlValue) result = fl_value_new_bool(false);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+
+  layer_animator_cancel(&self->animator);
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse *
+apply_render_policy(WaylandLayerShellPlugin *self, int policy, int fps_cap) {
+  if (policy < FRAME_POLICY_CONTINUOUS || policy > FRAME_POLICY_ON_DEMAND ||
+      (policy == FRAME_POLICY_CAPPED && fps_cap <= 0)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "invalid_policy", "Unknown render policy or invalid frame rate cap",
+        nullptr));
+  }
+
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    g_autoptr(FlValue) result = fl_value_new_bool(false);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+
+  frame_governor_set_policy(&layer_window_state_get(window)->governor,
+                            static_cast<FramePolicy>(policy), fps_cap);
+  PLUGIN_LOG_D("Render policy %d, frame rate cap %d", policy, fps_cap);
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Selects how often the window may present frames.
+static FlMethodResponse *set_render_policy(WaylandLayerShellPlugin *self,
+                                           FlValue *args) {
+  int policy = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_render_policy::kPolicy));
+  FlValue *fps_cap_value =
+      fl_value_get_list_value(args, channel_api::set_render_policy::kFpsCap);
+  int fps_cap = fl_value_get_type(fps_cap_value) == FL_VALUE_TYPE_INT
+                    ? fl_value_get_int(fps_cap_value)
+                    : 0;
+  return apply_render_policy(self, policy, fps_cap);
+}
+
+// Caps the frame rate at @fps; 0 removes the cap.
+static FlMethodResponse *set_frame_rate_cap(WaylandLayerShellPlugin *self,
+                                            FlValue *args) {
+  int fps = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_frame_rate_cap::kFps));
+  if (fps == 0) {
+    return apply_render_policy(self, FRAME_POLICY_CONTINUOUS, 0);
+  }
+  return apply_render_policy(self, FRAME_POLICY_CAPPED, fps);
+}
+
+// Enables or disables auto-hide, see auto_hide.h.
+static FlMethodResponse *set_auto_hide(WaylandLayerShellPlugin *self,
+                                       FlValue *args) {
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    g_autoptr(FlValue) result = fl_value_new_bool(false);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+
+  gboolean enabled = fl_value_get_bool(
+      fl_value_get_list_value(args, channel_api::set_auto_hide::kEnabled));
+  int edge = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_auto_hide::kEdge));
+  int strip_size = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_auto_hide::kStripSize));
+  int reveal_delay_ms = fl_value_get_int(fl_value_get_list_value(
+      args, channel_api::set_auto_hide::kRevealDelayMs));
+  int hide_delay_ms = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_auto_hide::kHideDelayMs));
+  if (edge < 0 || edge >= GTK_LAYER_SHELL_EDGE_ENTRY_NUMBER ||
+      strip_size < 1 || strip_size > 32 || reveal_delay_ms < 0 ||
+      hide_delay_ms < 0) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "invalid_auto_hide", "Invalid edge, strip size (1-32) or delay",
+        nullptr));
+  }
+
+  auto_hide_configure(&self->auto_hide, enabled,
+                      static_cast<GtkLayerShellEdge>(edge), strip_size,
+                      reveal_delay_ms, hide_delay_ms);
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Lets one frame through while rendering on demand.
+static FlMethodResponse *request_frame(WaylandLayerShellPlugin *self) {
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    g_autoptr(FlValue) result = fl_value_new_bool(false);
+    return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+  }
+
+  frame_governor_request_frame(&layer_window_state_get(window)->governor);
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Returns the render policy with the requested and achieved frame rates.
+static FlMethodResponse *get_frame_stats(WaylandLayerShellPlugin *self) {
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "no_window", "Could not get GTK window", nullptr));
+  }
+
+  const FrameGovernor *governor = &layer_window_state_get(window)->governor;
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "policy",
+                           fl_value_new_int(governor->policy));
+  fl_value_set_string_take(result, "requested_fps",
+                           fl_value_new_int(governor->fps_cap));
+  fl_value_set_string_take(
+      result, "achieved_fps",
+      fl_value_new_float(frame_governor_achieved_fps(governor)));
+  fl_value_set_string_take(result, "frames",
+                           fl_value_new_int(governor->frames));
+  fl_value_set_string_take(result, "held_frames",
+                           fl_value_new_int(governor->held_frames));
+  fl_value_set_string_take(
+      result, "elapsed_us",
+      fl_value_new_int(g_get_monotonic_time() - governor->stats_start));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Returns the preferred fractional scale of the surface next to the integer
+// scale GTK renders at, and how many pixels that costs per frame.
+static FlMethodResponse *get_scale_info(WaylandLayerShellPlugin *self) {
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "no_window", "Could not get GTK window", nullptr));
+  }
+
+  GtkWidget *widget = GTK_WIDGET(window);
+  gint64 width = gtk_widget_get_allocated_width(widget);
+  gint64 height = gtk_widget_get_allocated_height(widget);
+  int buffer_scale = gtk_widget_get_scale_factor(widget);
+  double preferred = fractional_scale_get_preferred(self->fractional_scale);
+  double exact_scale = preferred > 0 ? preferred : buffer_scale;
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(
+      result, "fractional_scale_supported",
+      fl_value_new_bool(fractional_scale_is_supported(self->fractional_scale)));
+  fl_value_set_string_take(result, "viewporter_supported",
+                           fl_value_new_bool(fractional_scale_has_viewporter(
+                               self->fractional_scale)));
+  fl_value_set_string_take(result, "preferred_scale",
+                           fl_value_new_float(preferred));
+  fl_value_set_string_take(result, "buffer_scale",
+                           fl_value_new_int(buffer_scale));
+  fl_value_set_string_take(result, "width", fl_value_new_int(width));
+  fl_value_set_string_take(result, "height", fl_value_new_int(height));
+  // What GTK rasterizes per frame, and what the exact scale would need.
+  fl_value_set_string_take(
+      result, "rendered_pixels",
+      fl_value_new_int(width * buffer_scale * height * buffer_scale));
+  fl_value_set_string_take(
+      result, "exact_pixels",
+      fl_value_new_int(static_cast<gint64>(ceil(width * exact_scale)) *
+                       static_cast<gint64>(ceil(height * exact_scale))));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse *
+is_presentation_supported(WaylandLayerShellPlugin *self) {
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "no_window", "Could not get GTK window", nullptr));
+  }
+  g_autoptr(FlValue) result = fl_value_new_bool(
+      frame_presentation_is_supported(self->presentation));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Changes the runtime log level.
+static FlMethodResponse *set_log_level(FlValue *args) {
+  int level = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_log_level::kLevel));
+  plugin_log_set_level(level);
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Returns the most recent records of the log ring, oldest first, whether or
+// not they have been written to stderr yet.
+static FlMethodResponse *get_log_records(FlValue *args) {
+  FlValue *max_value =
+      fl_value_get_list_value(args, channel_api::get_log_records::kMaxRecords);
+  size_t max_records = kPluginLogCapacity;
+  if (fl_value_get_type(max_value) == FL_VALUE_TYPE_INT) {
+    max_records = CLAMP(fl_value_get_int(max_value), 0,
+                        static_cast<gint64>(kPluginLogCapacity));
+  }
+
+  g_autofree PluginLogRecord *records = g_new(PluginLogRecord, max_records);
+  size_t count = plugin_log_snapshot(records, max_records);
+
+  g_autoptr(FlValue) result = fl_value_new_list();
+  for (size_t i = 0; i < count; i++) {
+    FlValue *record = fl_value_new_map();
+    fl_value_set_string_take(record, "time_us",
+                             fl_value_new_int(records[i].time));
+    fl_value_set_string_take(record, "level",
+                             fl_value_new_int(records[i].level));
+    fl_value_set_string_take(record, "message",
+                             fl_value_new_string(records[i].message));
+    fl_value_append_take(result, record);
+  }
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlValue *method_stats_to_value(const MethodStats *method_stats) {
+  FlValue *value = fl_value_new_map();
+  fl_value_set_string_take(value, "calls",
+                           fl_value_new_int(method_stats->calls));
+  fl_value_set_string_take(value, "errors",
+                           fl_value_new_int(method_stats->errors));
+  fl_value_set_string_take(value, "total_ns",
+                           fl_value_new_int(method_stats->total_ns));
+  fl_value_set_string_take(value, "max_ns",
+                           fl_value_new_int(method_stats->max_ns));
+  fl_value_set_string_take(
+      value, "p50_ns",
+      fl_value_new_int(plugin_stats_percentile(method_stats, 50)));
+  fl_value_set_string_take(
+      value, "p90_ns",
+      fl_value_new_int(plugin_stats_percentile(method_stats, 90)));
+  fl_value_set_string_take(
+      value, "p99_ns",
+      fl_value_new_int(plugin_stats_percentile(method_stats, 99)));
+
+  // Non-empty buckets only, keyed by the smallest latency they hold.
+  FlValue *histogram = fl_value_new_map();
+  for (int bucket = 0; bucket < kStatsBuckets; bucket++) {
+    if (method_stats->buckets[bucket] != 0) {
+      fl_value_set_take(histogram,
+                        fl_value_new_int(plugin_stats_bucket_start(bucket)),
+                        fl_value_new_int(method_stats->buckets[bucket]));
+    }
+  }
+  fl_value_set_string_take(value, "histogram", histogram);
+  return value;
+}
+
+static guint64 commit_count(WaylandLayerShellPlugin *self) {
+  LayerSurfaceQueue *queue = get_queue(self);
+  return queue != nullptr ? queue->commits : 0;
+}
+
+static guint64 enumeration_count(WaylandLayerShellPlugin *self) {
+  return self->monitors != nullptr ? self->monitors->enumerations : 0;
+}
+
+// Returns per-method call statistics plus surface commit and monitor
+// enumeration counts, all since the last resetStats.
+static FlMethodResponse *get_stats(WaylandLayerShellPlugin *self) {
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "enabled",
+                           fl_value_new_bool(WAYLAND_LAYER_SHELL_STATS));
+
+  FlValue *methods = fl_value_new_map();
+#if WAYLAND_LAYER_SHELL_STATS
+  for (size_t i = 0; i < channel_api::kMethodCount; i++) {
+    if (self->stats->methods[i].calls != 0) {
+      fl_value_set_string_take(methods, channel_api::kMethodNames[i],
+                               method_stats_to_value(&self->stats->methods[i]));
+    }
+  }
+#endif
+  fl_value_set_string_take(result, "methods", methods);
+
+  fl_value_set_string_take(
+      result, "commits",
+      fl_value_new_int(commit_count(self) - self->commits_at_reset));
+  fl_value_set_string_take(
+      result, "monitor_enumerations",
+      fl_value_new_int(enumeration_count(self) - self->enumerations_at_reset));
+
+  AutoHideStats auto_hide;
+  auto_hide_get_stats(&self->auto_hide, &auto_hide);
+  FlValue *auto_hide_value = fl_value_new_map();
+  fl_value_set_string_take(auto_hide_value, "hides",
+                           fl_value_new_int(auto_hide.hides));
+  fl_value_set_string_take(auto_hide_value, "reveals",
+                           fl_value_new_int(auto_hide.reveals));
+  fl_value_set_string_take(auto_hide_value, "last_reveal_us",
+                           fl_value_new_int(auto_hide.reveal_latency_last_us));
+  fl_value_set_string_take(auto_hide_value, "max_reveal_us",
+                           fl_value_new_int(auto_hide.reveal_latency_max_us));
+  fl_value_set_string_take(
+      auto_hide_value, "mean_reveal_us",
+      fl_value_new_int(auto_hide.reveals != 0
+                           ? auto_hide.reveal_latency_total_us /
+                                 auto_hide.reveals
+                           : 0));
+  fl_value_set_string_take(auto_hide_value, "hidden_us",
+                           fl_value_new_int(auto_hide.hidden_us));
+  fl_value_set_string_take(auto_hide_value, "hidden_cpu_us",
+                           fl_value_new_int(auto_hide.hidden_cpu_us));
+  fl_value_set_string_take(result, "auto_hide", auto_hide_value);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse *reset_stats(WaylandLayerShellPlugin *self) {
+#if WAYLAND_LAYER_SHELL_STATS
+  plugin_stats_reset(self->stats);
+#endif
+  self->commits_at_reset = commit_count(self);
+  self->enumerations_at_reset = enumeration_count(self);
+  auto_hide_reset_stats(&self->auto_hide);
+  g_autoptr(FlValue) result = fl_value_new_bool(true);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Starts recording trace events, see plugin_trace.h.
+static FlMethodResponse *start_tracing(FlValue *args) {
+  FlValue *path_value =
+      fl_value_get_list_value(args, channel_api::start_tracing::kPath);
+  const gchar *path = fl_value_get_type(path_value) == FL_VALUE_TYPE_STRING
+                          ? fl_value_get_string(path_value)
+                          : nullptr;
+  g_autoptr(FlValue) result = fl_value_new_bool(plugin_trace_start(path));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Stops recording and writes the trace file.
+static FlMethodResponse *stop_tracing() {
+  size_t events = 0;
+  guint64 dropped = 0;
+  g_autoptr(GError) error = nullptr;
+  g_autofree gchar *path = plugin_trace_stop(&events, &dropped, &error);
+  if (path == nullptr) {
+    return FL_METHOD_RESPONSE(
+        fl_method_error_response_new("trace_failed", error->message, nullptr));
+  }
+
+  g_autoptr(FlValue) result = fl_value_new_map();
+  fl_value_set_string_take(result, "path", fl_value_new_string(path));
+  fl_value_set_string_take(result, "events", fl_value_new_int(events));
+  fl_value_set_string_take(result, "dropped_events",
+                           fl_value_new_int(dropped));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Shows the surface: presents it if prepared, maps the window otherwise.
+static void control_show(WaylandLayerShellPlugin *self, GtkWindow *window,
+                         gboolean exclusive_keyboard) {
+  if (layer_presenter_present(&self->presenter, exclusive_keyboard)) {
+    return;
+  }
+  if (exclusive_keyboard) {
+    layer_surface_queue_set_keyboard_mode(
+        get_queue(self), GTK_LAYER_SHELL_KEYBOARD_MODE_EXCLUSIVE);
+  }
+  gtk_widget_show(GTK_WIDGET(window));
+}
+
+// Hides the surface: back to the prepared state if it was ever prepared,
+// unmapped otherwise.
+static void control_hide(WaylandLayerShellPlugin *self, GtkWindow *window) {
+  if (self->presenter.was_prepared &&
+      layer_presenter_dismiss(&self->presenter)) {
+    return;
+  }
+  if (!self->presenter.prepared) {
+    gtk_widget_hide(GTK_WIDGET(window));
+  }
+}
+
+static gboolean control_usage(GError **error, const gchar *usage) {
+  g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Usage: %s",
+              usage);
+  return FALSE;
+}
+
+// Reads the optional "exclusive" argument of show and toggle.
+static gboolean control_exclusive_arg(gchar **argv, guint argc,
+                                      gboolean *exclusive_keyboard) {
+  *exclusive_keyboard = argc == 2 && strcmp(argv[1], "exclusive") == 0;
+  return argc == 1 || *exclusive_keyboard;
+}
+
+// Runs one command from the control socket on @window. The commands mirror
+// the method channel methods of the same name, with values spelled as in
+// the config file (see wayland_layer_shell_config_load_file()).
+static gboolean run_control_command(WaylandLayerShellPlugin *self,
+                                    GtkWindow *window, gchar **argv,
+                                    GError **error) {
+  const gchar *command = argv[0];
+  guint argc = g_strv_length(argv);
+  LayerSurfaceQueue *queue = get_queue(self);
+  gboolean exclusive_keyboard = FALSE;
+
+  if (strcmp(command, "show") == 0) {
+    if (!control_exclusive_arg(argv, argc, &exclusive_keyboard)) {
+      return control_usage(error, "show [exclusive]");
+    }
+    control_show(self, window, exclusive_keyboard);
+    return TRUE;
+  }
+  if (strcmp(command, "hide") == 0) {
+    if (argc != 1) {
+      return control_usage(error, "hide");
+    }
+    control_hide(self, window);
+    return TRUE;
+  }
+  if (strcmp(command, "toggle") == 0) {
+    if (!control_exclusive_arg(argv, argc, &exclusive_keyboard)) {
+      return control_usage(error, "toggle [exclusive]");
+    }
+    if (gtk_widget_get_mapped(GTK_WIDGET(window)) &&
+        !self->presenter.prepared) {
+      control_hide(self, window);
+    } else {
+      control_show(self, window, exclusive_keyboard);
+    }
+    return TRUE;
+  }
+  if (strcmp(command, "setMonitor") == 0) {
+    if (argc != 2) {
+      return control_usage(error, "setMonitor <id|-1>");
+    }
+    gint64 monitor_id = g_ascii_strtoll(argv[1], nullptr, 10);
+    if (monitor_id == -1) {
+      layer_surface_queue_set_monitor(queue, nullptr);
+      return TRUE;
+    }
+    const MonitorInfo *info = lookup_monitor(self, monitor_id);
+    if (info == nullptr) {
+      g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+                  "Unknown monitor: %s", argv[1]);
+      return FALSE;
+    }
+    layer_surface_queue_set_monitor(queue, info->monitor);
+    return TRUE;
+  }
+
+  // The rest edit the layer surface state like the config file does.
+  const gchar *key = nullptr;
+  if (strcmp(command, "setLayer") == 0) {
+    key = "layer";
+  } else if (strcmp(command, "setKeyboardMode") == 0) {
+    key = "keyboard-mode";
+  } else if (strcmp(command, "applyConfig") != 0) {
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                "Unknown command: %s", command);
+    return FALSE;
+  }
+
+  LayerSurfaceState state;
+  layer_surface_queue_get_state(queue, &state);
+  WaylandLayerShellConfig config;
+  layer_shell_config_from_state(&config, &state);
+  if (key != nullptr) {
+    if (argc != 2) {
+      return control_usage(error, strcmp(key, "layer") == 0
+                                      ? "setLayer <layer>"
+                                      : "setKeyboardMode <mode>");
+    }
+    if (!layer_shell_config_set(&config, key, argv[1], error)) {
+      return FALSE;
+    }
+  } else {
+    if (argc < 2) {
+      return control_usage(error, "applyConfig <key>=<value>...");
+    }
+    for (guint i = 1; i < argc; i++) {
+      g_auto(GStrv) option = g_strsplit(argv[i], "=", 2);
+      if (option[1] == nullptr || strcmp(option[0], "monitor") == 0) {
+        return control_usage(error, "applyConfig <key>=<value>..., "
+                                    "without monitor (use setMonitor)");
+      }
+      if (!layer_shell_config_set(&config, option[0], option[1], error)) {
+        return FALSE;
+      }
+    }
+  }
+  layer_shell_config_queue(queue, &config);
+  return TRUE;
+}
+
+// Runs a command from the control socket, commits the result right away and
+// tells Dart about it afterwards.
+static gboolean control_command_cb(gchar **argv, GError **error,
+                                   gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  // A cheap way for clients to measure the socket round trip.
+  if (strcmp(argv[0], "ping") == 0) {
+    return TRUE;
+  }
+  GtkWindow *window = get_window(self);
+  if (window == nullptr) {
+    g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_INITIALIZED, "No window");
+    return FALSE;
+  }
+  if (!run_control_command(self, window, argv, error)) {
+    return FALSE;
+  }
+  layer_surface_queue_flush(get_queue(self));
+
+  FlValue *event = fl_value_new_map();
+  fl_value_set_string_take(event, "event",
+                           fl_value_new_string("controlCommand"));
+  fl_value_set_string_take(event, "command", fl_value_new_string(argv[0]));
+  FlValue *args = fl_value_new_list();
+  for (gchar **arg = argv + 1; *arg != nullptr; arg++) {
+    fl_value_append_take(args, fl_value_new_string(*arg));
+  }
+  fl_value_set_string_take(event, "args", args);
+  send_event(self, event);
+  return TRUE;
+}
+
+// Starts listening for control commands on @path, or on a socket in the
+// runtime directory if @path is nullptr. Replaces a socket listened on
+// before.
+static gboolean start_control_socket(WaylandLayerShellPlugin *self,
+                                     const gchar *path, GError **error) {
+  g_clear_pointer(&self->control_socket, control_socket_free);
+  self->control_socket =
+      control_socket_new(path, control_command_cb, self, error);
+  return self->control_socket != nullptr;
+}
+
+// Returns the path of the control socket now listening.
+static FlMethodResponse *listen_control_socket(WaylandLayerShellPlugin *self,
+                                               FlValue *args) {
+  FlValue *path_value =
+      fl_value_get_list_value(args, channel_api::listen_control_socket::kPath);
+  const gchar *path = fl_value_get_type(path_value) == FL_VALUE_TYPE_STRING
+                          ? fl_value_get_string(path_value)
+                          : nullptr;
+  g_autoptr(GError) error = nullptr;
+  if (!start_control_socket(self, path, &error)) {
+    return FL_METHOD_RESPONSE(fl_method_error_response_new(
+        "control_socket_failed", error->message, nullptr));
+  }
+  g_autoptr(FlValue) result =
+      fl_value_new_string(control_socket_get_path(self->control_socket));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse *close_control_socket(WaylandLayerShellPlugin *self) {
+  g_autoptr(FlValue) result =
+      fl_value_new_bool(self->control_socket != nullptr);
+  g_clear_pointer(&self->control_socket, control_socket_free);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse *activate_toplevel(WaylandLayerShellPlugin *self,
+                                           FlValue *args) {
+  gint64 id = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::activate_toplevel::kId));
+  g_autoptr(FlValue) result =
+      fl_value_new_bool(self->toplevels != nullptr &&
+                        foreign_toplevels_activate(self->toplevels, id));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse *set_toplevel_minimized(WaylandLayerShellPlugin *self,
+                                                FlValue *args) {
+  gint64 id = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::set_toplevel_minimized::kId));
+  gboolean minimized = fl_value_get_bool(fl_value_get_list_value(
+      args, channel_api::set_toplevel_minimized::kMinimized));
+  g_autoptr(FlValue) result = fl_value_new_bool(
+      self->toplevels != nullptr &&
+      foreign_toplevels_set_minimized(self->toplevels, id, minimized));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static FlMethodResponse *close_toplevel(WaylandLayerShellPlugin *self,
+                                        FlValue *args) {
+  gint64 id = fl_value_get_int(
+      fl_value_get_list_value(args, channel_api::close_toplevel::kId));
+  g_autoptr(FlValue) result =
+      fl_value_new_bool(self->toplevels != nullptr &&
+                        foreign_toplevels_close(self->toplevels, id));
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+// Returns whether @args is the positional argument list @method expects.
+static bool has_expected_args(channel_api::Method method, FlValue *args) {
+  size_t count = channel_api::kArgCounts[static_cast<size_t>(method)];
+  if (count == 0) {
+    return true;
+  }
+  return args != nullptr && fl_value_get_type(args) == FL_VALUE_TYPE_LIST &&
+         fl_value_get_length(args) == count;
+}
+
+// Runs the handler for @method. Handlers that answer asynchronously return
+// nullptr. @method_call is nullptr for wayland_layer_shell_plugin_invoke().
+static FlMethodResponse *dispatch(WaylandLayerShellPlugin *self,
+                                  channel_api::Method method,
+                                  FlMethodCall *method_call, FlValue *args) {
+  FlMethodResponse *response = nullptr;
+
+  if (!has_expected_args(method, args)) {
+    g_autofree gchar *message = g_strdup_printf(
+        "%s expects %zu positional arguments",
+        channel_api::kMethodNames[static_cast<size_t>(method)],
+        channel_api::kArgCounts[static_cast<size_t>(method)]);
+    return FL_METHOD_RESPONSE(
+        fl_method_error_response_new("bad_args", message, nullptr));
+  }
+
+  guint64 trace_start = PLUGIN_TRACE_BEGIN();
+  switch (method) {
+  case channel_api::Method::kGetPlatformVersion:
+    response = get_platform_version();
+    break;
+  case channel_api::Method::kIsSupported:
+    response = is_supported(self);
+    break;
+  case channel_api::Method::kGetCapabilities:
+    response = get_capabilities();
+    break;
+  case channel_api::Method::kIsFfiWindow:
+    response = is_ffi_window(self);
+    break;
+  case channel_api::Method::kInitialize:
+    response = initialize(self, method_call, args);
+    break;
+  case channel_api::Method::kShowWindow:
+    response = show_window(self);
+    break;
+  case channel_api::Method::kPrepare:
+    response = prepare(self);
+    break;
+  case channel_api::Method::kPresent:
+    response = present(self, args);
+    break;
+  case channel_api::Method::kDismiss:
+    response = dismiss(self);
+    break;
+  case channel_api::Method::kSetLayer:
+    response = set_layer(self, args);
+    break;
+  case channel_api::Method::kGetLayer:
+    response = get_layer(self);
+    break;
+  case channel_api::Method::kGetMonitorList:
+    response = get_monitor_list(self);
+    break;
+  case channel_api::Method::kSetMonitor:
+    response = set_monitor(self, args);
+    break;
+  case channel_api::Method::kSetAnchor:
+    response = set_anchor(self, args);
+    break;
+  case channel_api::Method::kGetAnchor:
+    response = get_anchor(self, args);
+    break;
+  case channel_api::Method::kSetMargin:
+    response = set_margin(self, args);
+    break;
+  case channel_api::Method::kGetMargin:
+    response = get_margin(self, args);
+    break;
+  case channel_api::Method::kSetExclusiveZone:
+    response = set_exclusive_zone(self, args);
+    break;
+  case channel_api::Method::kGetExclusiveZone:
+    response = get_exclusive_zone(self);
+    break;
+  case channel_api::Method::kEnableAutoExclusiveZone:
+    response = enable_auto_exclusive_zone(self);
+    break;
+  case channel_api::Method::kIsAutoExclusiveZoneEnabled:
+    response = is_auto_exclusive_zone_enabled(self);
+    break;
+  case channel_api::Method::kSetKeyboardMode:
+    response = set_keyboard_mode(self, args);
+    break;
+  case channel_api::Method::kGetKeyboardMode:
+    response = get_keyboard_mode(self);
+    break;
+  case channel_api::Method::kSetSize:
+    response = set_size(self, args);
+    break;
+  case channel_api::Method::kApplyConfig:
+    response = apply_config(self, args);
+    break;
+  case channel_api::Method::kFlush:
+    response = flush(self);
+    break;
+  case channel_api::Method::kGetCommitStats:
+    response = get_commit_stats(self);
+    break;
+  case channel_api::Method::kSetInputRegion:
+    response = set_input_region(self, args);
+    break;
+  case channel_api::Method::kSetOpaqueRegion:
+    response = set_opaque_region(self, args);
+    break;
+  case channel_api::Method::kAnimateMargins:
+    response = animate_margins(self, args);
+    break;
+  case channel_api::Method::kAnimateSize:
+    response = animate_size(self, args);
+    break;
+  case channel_api::Method::kCancelAnimations:
+    response = cancel_animations(self);
+    break;
+  case channel_api::Method::kSetRenderPolicy:
+    response = set_render_policy(self, args);
+    break;
+  case channel_api::Method::kSetFrameRateCap:
+    response = set_frame_rate_cap(self, args);
+    break;
+  case channel_api::Method::kSetAutoHide:
+    response = set_auto_hide(self, args);
+    break;
+  case channel_api::Method::kRequestFrame:
+    response = request_frame(self);
+    break;
+  case channel_api::Method::kGetFrameStats:
+    response = get_frame_stats(self);
+    break;
+  case channel_api::Method::kGetScaleInfo:
+    response = get_scale_info(self);
+    break;
+  case channel_api::Method::kIsPresentationSupported:
+    response = is_presentation_supported(self);
+    break;
+  case channel_api::Method::kSetLogLevel:
+    response = set_log_level(args);
+    break;
+  case channel_api::Method::kGetLogRecords:
+    response = get_log_records(args);
+    break;
+  case channel_api::Method::kGetStats:
+    response = get_stats(self);
+    break;
+  case channel_api::Method::kResetStats:
+    response = reset_stats(self);
+    break;
+  case channel_api::Method::kStartTracing:
+    response = start_tracing(args);
+    break;
+  case channel_api::Method::kStopTracing:
+    response = stop_tracing();
+    break;
+  case channel_api::Method::kListenControlSocket:
+    response = listen_control_socket(self, args);
+    break;
+  case channel_api::Method::kCloseControlSocket:
+    response = close_control_socket(self);
+    break;
+  case channel_api::Method::kActivateToplevel:
+    response = activate_toplevel(self, args);
+    break;
+  case channel_api::Method::kSetToplevelMinimized:
+    response = set_toplevel_minimized(self, args);
+    break;
+  case channel_api::Method::kCloseToplevel:
+    response = close_toplevel(self, args);
+    break;
+  case channel_api::Method::kUnknown:
+    response = FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+    break;
+  }
+  // Asynchronous handlers are traced until they return, not until they
+  // answer.
+  PLUGIN_TRACE_END(trace_start,
+                   channel_api::kMethodNames[static_cast<size_t>(method)]);
+  return response;
+}
+
+// Called when a method call is received from Flutter.
+static void
+wayland_layer_shell_plugin_handle_method_call(WaylandLayerShellPlugin *self,
+                                              FlMethodCall *method_call) {
+  channel_api::Method method =
+      channel_api::lookup_method(fl_method_call_get_name(method_call));
+  if (method == channel_api::Method::kUnknown) {
+    g_autoptr(FlMethodResponse) response =
+        FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+    fl_method_call_respond(method_call, response, nullptr);
+    return;
+  }
+
+#if WAYLAND_LAYER_SHELL_STATS
+  guint64 start_ns = plugin_stats_now();
+#endif
+  g_autoptr(FlMethodResponse) response = dispatch(
+      self, method, method_call, fl_method_call_get_args(method_call));
+#if WAYLAND_LAYER_SHELL_STATS
+  // Asynchronous handlers are timed until they return, not until they answer.
+  plugin_stats_record(self->stats, method, start_ns,
+                      response != nullptr &&
+                          FL_IS_METHOD_ERROR_RESPONSE(response));
+#endif
+
+  if (response != nullptr) {
+    fl_method_call_respond(method_call, response, nullptr);
+  }
+}
+
+FlMethodResponse *wayland_layer_shell_plugin_invoke(
+    WaylandLayerShellPlugin *self, const gchar *method_name, FlValue *args) {
+  channel_api::Method method = channel_api::lookup_method(method_name);
+  if (method == channel_api::Method::kUnknown) {
+    return FL_METHOD_RESPONSE(fl_method_not_implemented_response_new());
+  }
+
+  FlMethodResponse *response = dispatch(self, method, nullptr, args);
+  if (response != nullptr) {
+    return response;
+  }
+  while (self->invoke_response == nullptr) {
+    g_main_context_iteration(nullptr, TRUE);
+  }
+  response = self->invoke_response;
+  self->invoke_response = nullptr;
+  return response;
+}
+
+FlMethodResponse *get_platform_version() {
+  struct utsname uname_data = {};
+  uname(&uname_data);
+  g_autofree gchar *version = g_strdup_printf("Linux %s", uname_data.version);
+  g_autoptr(FlValue) result = fl_value_new_string(version);
+  return FL_METHOD_RESPONSE(fl_method_success_response_new(result));
+}
+
+static void wayland_layer_shell_plugin_dispose(GObject *object) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(object);
+
+  pending_initialize_free(self);
+
+  // Clean up our window tracking. The window's own state stays attached to
+  // it and goes away with the window.
+  if (self->target_window != nullptr) {
+    layer_animator_clear(&self->animator);
+    // The window outlives the plugin here, so it must not stay hidden.
+    auto_hide_configure(&self->auto_hide, FALSE, GTK_LAYER_SHELL_EDGE_TOP, 0,
+                        0, 0);
+    auto_hide_clear(&self->auto_hide);
+    layer_presenter_clear(&self->presenter);
+    g_clear_pointer(&self->fractional_scale, fractional_scale_free);
+    g_clear_pointer(&self->presentation, frame_presentation_free);
+    if (self->window_handlers_connected) {
+      g_signal_handlers_disconnect_by_data(self->target_window, self);
+      self->window_handlers_connected = FALSE;
+    }
+    LayerWindowState *window_state =
+        layer_window_state_peek(self->target_window);
+    if (window_state != nullptr && self->queue_changed_id != 0) {
+      layer_surface_queue_remove_changed_func(&window_state->queue,
+                                              self->queue_changed_id);
+      layer_surface_queue_remove_remap_func(&window_state->queue,
+                                            self->queue_remap_id);
+      self->queue_changed_id = 0;
+      self->queue_remap_id = 0;
+    }
+    g_object_remove_weak_pointer(
+        G_OBJECT(self->target_window),
+        reinterpret_cast<gpointer *>(&self->target_window));
+    self->target_window = nullptr;
+  }
+  if (self->event_channel != nullptr) {
+    fl_event_channel_set_stream_handlers(self->event_channel, nullptr, nullptr,
+                                         nullptr, nullptr);
+    g_clear_object(&self->event_channel);
+  }
+  if (self->surface_channel != nullptr) {
+    fl_event_channel_set_stream_handlers(self->surface_channel, nullptr,
+                                         nullptr, nullptr, nullptr);
+    g_clear_object(&self->surface_channel);
+  }
+  if (self->presentation_channel != nullptr) {
+    fl_event_channel_set_stream_handlers(self->presentation_channel, nullptr,
+                                         nullptr, nullptr, nullptr);
+    g_clear_object(&self->presentation_channel);
+  }
+  g_clear_pointer(&self->toplevels, foreign_toplevels_free);
+  if (self->toplevel_channel != nullptr) {
+    fl_event_channel_set_stream_handlers(self->toplevel_channel, nullptr,
+                                         nullptr, nullptr, nullptr);
+    g_clear_object(&self->toplevel_channel);
+  }
+  if (self->monitor_channel != nullptr) {
+    fl_event_channel_set_stream_handlers(self->monitor_channel, nullptr,
+                                         nullptr, nullptr, nullptr);
+    g_clear_object(&self->monitor_channel);
+  }
+  if (self->monitors != nullptr) {
+    layer_shell_ffi_drop_monitors(self->monitors);
+  }
+  g_clear_pointer(&self->monitors, monitor_registry_free);
+  g_clear_pointer(&self->control_socket, control_socket_free);
+#if WAYLAND_LAYER_SHELL_STATS
+  g_clear_pointer(&self->stats, g_free);
+#endif
+
+  // The idle drain may not run again; write out what is still queued.
+  plugin_log_drain();
+
+  G_OBJECT_CLASS(wayland_layer_shell_plugin_parent_class)->dispose(object);
+}
+
+static void
+wayland_layer_shell_plugin_class_init(WaylandLayerShellPluginClass *klass) {
   G_OBJECT_CLASS(klass)->dispose = wayland_layer_shell_plugin_dispose;
 }
 
 static void wayland_layer_shell_plugin_init(WaylandLayerShellPlugin *self) {
   self->target_window = nullptr;
+  self->window_handlers_connected = FALSE;
+  self->queue_changed_id = 0;
+  self->queue_remap_id = 0;
+  self->animator = {};
+  self->event_channel = nullptr;
+  self->events_listening = FALSE;
+  self->monitors = nullptr;
+  self->monitor_channel = nullptr;
+  self->monitors_listening = FALSE;
+  self->surface_channel = nullptr;
+  self->surface_listening = FALSE;
+  self->surface_state_sent = FALSE;
+  self->presentation_channel = nullptr;
+  self->presentation_listening = FALSE;
+  self->toplevels = nullptr;
+  self->toplevel_channel = nullptr;
+  self->invoke_response = nullptr;
+#if WAYLAND_LAYER_SHELL_STATS
+  self->stats = g_new0(PluginStats, 1);
+#endif
+  self->commits_at_reset = 0;
+  self->enumerations_at_reset = 0;
 }
 
 static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
@@ -523,13 +2462,140 @@ static void method_call_cb(FlMethodChannel *channel, FlMethodCall *method_call,
   wayland_layer_shell_plugin_handle_method_call(plugin, method_call);
 }
 
+static FlMethodErrorResponse *events_listen_cb(FlEventChannel *channel,
+                                               FlValue *args,
+                                               gpointer user_data) {
+  WAYLAND_LAYER_SHELL_PLUGIN(user_data)->events_listening = TRUE;
+  return nullptr;
+}
+
+static FlMethodErrorResponse *events_cancel_cb(FlEventChannel *channel,
+                                               FlValue *args,
+                                               gpointer user_data) {
+  WAYLAND_LAYER_SHELL_PLUGIN(user_data)->events_listening = FALSE;
+  return nullptr;
+}
+
+static FlMethodErrorResponse *monitors_listen_cb(FlEventChannel *channel,
+                                                 FlValue *args,
+                                                 gpointer user_data) {
+  WAYLAND_LAYER_SHELL_PLUGIN(user_data)->monitors_listening = TRUE;
+  return nullptr;
+}
+
+static FlMethodErrorResponse *monitors_cancel_cb(FlEventChannel *channel,
+                                                 FlValue *args,
+                                                 gpointer user_data) {
+  WAYLAND_LAYER_SHELL_PLUGIN(user_data)->monitors_listening = FALSE;
+  return nullptr;
+}
+
+// Starts with the current state, so Dart does not have to fetch it first.
+static FlMethodErrorResponse *surface_listen_cb(FlEventChannel *channel,
+                                                FlValue *args,
+                                                gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  self->surface_listening = TRUE;
+  self->surface_state_sent = FALSE;
+  get_window(self);
+  send_surface_state(self);
+  return nullptr;
+}
+
+static FlMethodErrorResponse *surface_cancel_cb(FlEventChannel *channel,
+                                                FlValue *args,
+                                                gpointer user_data) {
+  WAYLAND_LAYER_SHELL_PLUGIN(user_data)->surface_listening = FALSE;
+  return nullptr;
+}
+
+static FlMethodErrorResponse *presentation_listen_cb(FlEventChannel *channel,
+                                                     FlValue *args,
+                                                     gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  self->presentation_listening = TRUE;
+  get_window(self);
+  if (self->presentation != nullptr) {
+    frame_presentation_set_enabled(self->presentation, TRUE);
+  }
+  return nullptr;
+}
+
+static FlMethodErrorResponse *presentation_cancel_cb(FlEventChannel *channel,
+                                                     FlValue *args,
+                                                     gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  self->presentation_listening = FALSE;
+  if (self->presentation != nullptr) {
+    frame_presentation_set_enabled(self->presentation, FALSE);
+  }
+  return nullptr;
+}
+
+// Tracking starts with every existing window, reported as "added" in the
+// first batch.
+static FlMethodErrorResponse *toplevels_listen_cb(FlEventChannel *channel,
+                                                  FlValue *args,
+                                                  gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  GdkDisplay *display = gdk_display_get_default();
+  if (self->toplevels == nullptr && display != nullptr) {
+    self->toplevels =
+        foreign_toplevels_new(display, toplevels_changed_cb, self);
+  }
+  if (self->toplevels == nullptr) {
+    return fl_method_error_response_new(
+        "no_foreign_toplevel",
+        "The compositor does not support zwlr_foreign_toplevel_manager_v1",
+        nullptr);
+  }
+  return nullptr;
+}
+
+static FlMethodErrorResponse *toplevels_cancel_cb(FlEventChannel *channel,
+                                                  FlValue *args,
+                                                  gpointer user_data) {
+  WaylandLayerShellPlugin *self = WAYLAND_LAYER_SHELL_PLUGIN(user_data);
+  g_clear_pointer(&self->toplevels, foreign_toplevels_free);
+  return nullptr;
+}
+
+WaylandLayerShellPlugin *
+wayland_layer_shell_plugin_new_for_window(GtkWindow *window) {
+  plugin_log_init();
+  plugin_trace_init();
+
+  WaylandLayerShellPlugin *plugin = WAYLAND_LAYER_SHELL_PLUGIN(
+      g_object_new(wayland_layer_shell_plugin_get_type(), nullptr));
+  set_target_window(plugin, window);
+  GdkDisplay *display = gtk_widget_get_display(GTK_WIDGET(window));
+  plugin->monitors = monitor_registry_new(display, monitor_changed_cb, plugin);
+  share_monitors_with_ffi(plugin, window);
+  return plugin;
+}
+
 void wayland_layer_shell_plugin_register_with_registrar(
     FlPluginRegistrar *registrar) {
+  plugin_log_init();
+  plugin_trace_init();
+
   WaylandLayerShellPlugin *plugin = WAYLAND_LAYER_SHELL_PLUGIN(
       g_object_new(wayland_layer_shell_plugin_get_type(), nullptr));
 
   plugin->registrar = FL_PLUGIN_REGISTRAR(g_object_ref(registrar));
 
+  // The C API has no plugin instance to resolve the window lazily through,
+  // so attach it to the view's window right away.
+  GtkWindow *view_window = nullptr;
+  FlView *view = fl_plugin_registrar_get_view(registrar);
+  if (view != nullptr) {
+    GtkWidget *toplevel = gtk_widget_get_toplevel(GTK_WIDGET(view));
+    if (GTK_IS_WINDOW(toplevel)) {
+      view_window = GTK_WINDOW(toplevel);
+      layer_shell_ffi_attach(view_window);
+    }
+  }
+
   g_autoptr(FlStandardMethodCodec) codec = fl_standard_method_codec_new();
   g_autoptr(FlMethodChannel) channel =
       fl_method_channel_new(fl_plugin_registrar_get_messenger(registrar),
@@ -537,5 +2603,55 @@ void wayland_layer_shell_plugin_register_with_registrar(
   fl_method_channel_set_method_call_handler(
       channel, method_call_cb, g_object_ref(plugin), g_object_unref);
 
+  // The plugin keeps the event channel alive; the handlers only hold a plain
+  // pointer back to the plugin so the two don't keep each other alive.
+  plugin->event_channel = fl_event_channel_new(
+      fl_plugin_registrar_get_messenger(registrar),
+      "wayland_layer_shell/events", FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(plugin->event_channel, events_listen_cb,
+                                       events_cancel_cb, plugin, nullptr);
+
+  GdkDisplay *display = gdk_display_get_default();
+  if (display != nullptr) {
+    plugin->monitors =
+        monitor_registry_new(display, monitor_changed_cb, plugin);
+    share_monitors_with_ffi(plugin, view_window);
+  }
+  plugin->monitor_channel = fl_event_channel_new(
+      fl_plugin_registrar_get_messenger(registrar),
+      "wayland_layer_shell/monitors", FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(plugin->monitor_channel,
+                                       monitors_listen_cb, monitors_cancel_cb,
+                                       plugin, nullptr);
+  plugin->surface_channel = fl_event_channel_new(
+      fl_plugin_registrar_get_messenger(registrar),
+      "wayland_layer_shell/surface", FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(plugin->surface_channel,
+                                       surface_listen_cb, surface_cancel_cb,
+                                       plugin, nullptr);
+  plugin->presentation_channel = fl_event_channel_new(
+      fl_plugin_registrar_get_messenger(registrar),
+      "wayland_layer_shell/presentation", FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(
+      plugin->presentation_channel, presentation_listen_cb,
+      presentation_cancel_cb, plugin, nullptr);
+  plugin->toplevel_channel = fl_event_channel_new(
+      fl_plugin_registrar_get_messenger(registrar),
+      "wayland_layer_shell/toplevels", FL_METHOD_CODEC(codec));
+  fl_event_channel_set_stream_handlers(plugin->toplevel_channel,
+                                       toplevels_listen_cb,
+                                       toplevels_cancel_cb, plugin, nullptr);
+
+  // Keybinding helpers may need the control socket before Dart gets to
+  // listenControlSocket.
+  const gchar *control_path = g_getenv("WAYLAND_LAYER_SHELL_CONTROL_SOCKET");
+  if (control_path != nullptr && control_path[0] != '\0') {
+    g_autoptr(GError) error = nullptr;
+    if (!start_control_socket(plugin, control_path, &error)) {
+      PLUGIN_LOG_E("Could not listen on %s: %s", control_path,
+                   error->message);
+    }
+  }
+
   g_object_unref(plugin);
 }
\ No newline at end of file
@@ -8,3 +8,14 @@
 
 // Handles the getPlatformVersion method call.
 FlMethodResponse *get_platform_version();
+
+// Creates a plugin instance that manages @window without being registered on
+// a messenger, so it can be driven by wayland_layer_shell_plugin_invoke().
+WaylandLayerShellPlugin *
+wayland_layer_shell_plugin_new_for_window(GtkWindow *window);
+
+// Runs the handler of method channel method @method with the positional
+// arguments @args, as if it had been called from Dart. Handlers that answer
+// asynchronously are waited for by iterating the default main context.
+FlMethodResponse *wayland_layer_shell_plugin_invoke(
+    WaylandLayerShellPlugin *self, const gchar *method, FlValue *args);
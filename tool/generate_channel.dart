@@ -0,0 +1,161 @@
+// Generates the Dart client and the native dispatch table for the
+// `wayland_layer_shell` method channel from tool/channel_schema.json.
+//
+// Run from the package root after editing the schema:
+//
+//   dart run tool/generate_channel.dart
+//
+// Both sides agree on method names and on the position of every argument, so
+// arguments travel as plain lists and the native side resolves a call with a
+// single hash lookup instead of comparing against every method name.
+import 'dart:convert';
+import 'dart:io';
+
+const _schemaPath = 'tool/channel_schema.json';
+const _dartOutput = 'lib/src/channel.g.dart';
+const _nativeOutput = 'linux/channel_api.g.h';
+
+const _header = '// GENERATED CODE - DO NOT MODIFY BY HAND.\n'
+    '// Generated by tool/generate_channel.dart from tool/channel_schema.json.\n';
+
+class _Arg {
+  final String name;
+  final String type;
+
+  _Arg(this.name, this.type);
+}
+
+class _Method {
+  final String name;
+  final List<_Arg> args;
+  final String returns;
+
+  _Method(this.name, this.args, this.returns);
+}
+
+void main() {
+  final schema = jsonDecode(File(_schemaPath).readAsStringSync()) as Map<String, dynamic>;
+  final channel = schema['channel'] as String;
+  final methods = [
+    for (final method in schema['methods'] as List<dynamic>)
+      _Method(
+        method['name'] as String,
+        [
+          for (final arg in (method['args'] as List<dynamic>?) ?? const [])
+            _Arg(arg['name'] as String, arg['type'] as String),
+        ],
+        (method['returns'] as String?) ?? 'void',
+      ),
+  ];
+
+  File(_dartOutput).writeAsStringSync(_generateDart(channel, methods));
+  File(_nativeOutput).writeAsStringSync(_generateNative(channel, methods));
+}
+
+String _generateDart(String channel, List<_Method> methods) {
+  final out = StringBuffer(_header);
+  out.writeln();
+  out.writeln("import 'package:flutter/services.dart';");
+  out.writeln();
+  out.writeln('/// Typed client for the `$channel` method channel. Arguments are sent');
+  out.writeln('/// positionally, in schema order.');
+  out.writeln('class LayerShellChannel {');
+  out.writeln('  const LayerShellChannel(this.methodChannel);');
+  out.writeln();
+  out.writeln('  final MethodChannel methodChannel;');
+  for (final method in methods) {
+    final params = method.args.map((arg) => '${arg.type} ${arg.name}').join(', ');
+    final resultType = method.returns == 'void' ? 'void' : '${method.returns}?';
+    final args = method.args.isEmpty ? '' : ', <Object?>[${method.args.map((arg) => arg.name).join(', ')}]';
+    out.writeln();
+    out.writeln('  Future<$resultType> ${method.name}($params) {');
+    out.writeln("    return methodChannel.invokeMethod<${method.returns}>('${method.name}'$args);");
+    out.writeln('  }');
+  }
+  out.writeln('}');
+  return out.toString();
+}
+
+String _generateNative(String channel, List<_Method> methods) {
+  final out = StringBuffer(_header);
+  out.writeln();
+  out.writeln('#ifndef WAYLAND_LAYER_SHELL_CHANNEL_API_G_H_');
+  out.writeln('#define WAYLAND_LAYER_SHELL_CHANNEL_API_G_H_');
+  out.writeln();
+  out.writeln('#include <cstddef>');
+  out.writeln('#include <cstdint>');
+  out.writeln('#include <cstring>');
+  out.writeln();
+  out.writeln('// Method table for the "$channel" method channel.');
+  out.writeln('namespace channel_api {');
+  out.writeln();
+  out.writeln('// 32-bit FNV-1a, also evaluated at compile time for the case labels in');
+  out.writeln('// lookup_method().');
+  out.writeln('constexpr uint32_t method_hash(const char *name) {');
+  out.writeln('  uint32_t hash = 2166136261u;');
+  out.writeln("  while (*name != '\\0') {");
+  out.writeln('    hash = (hash ^ static_cast<uint8_t>(*name++)) * 16777619u;');
+  out.writeln('  }');
+  out.writeln('  return hash;');
+  out.writeln('}');
+  out.writeln();
+  out.writeln('enum class Method {');
+  for (final method in methods) {
+    out.writeln('  ${_constant(method.name)},');
+  }
+  out.writeln('  kUnknown,');
+  out.writeln('};');
+  out.writeln();
+  out.writeln('constexpr size_t kMethodCount = ${methods.length};');
+  out.writeln();
+  out.writeln('// Method names, indexed by Method.');
+  out.writeln('constexpr const char *kMethodNames[kMethodCount] = {');
+  for (final method in methods) {
+    out.writeln('    "${method.name}",');
+  }
+  out.writeln('};');
+  out.writeln();
+  out.writeln('// Number of positional arguments of each method, indexed by Method.');
+  out.writeln('constexpr size_t kArgCounts[kMethodCount] = {');
+  for (final method in methods) {
+    out.writeln('    ${method.args.length},');
+  }
+  out.writeln('};');
+  for (final method in methods.where((method) => method.args.isNotEmpty)) {
+    out.writeln();
+    out.writeln('// ${method.name}(${method.args.map((arg) => '${arg.type} ${arg.name}').join(', ')})');
+    out.writeln('namespace ${_snakeCase(method.name)} {');
+    for (var i = 0; i < method.args.length; i++) {
+      out.writeln('constexpr size_t ${_constant(method.args[i].name)} = $i;');
+    }
+    out.writeln('}  // namespace ${_snakeCase(method.name)}');
+  }
+  out.writeln();
+  out.writeln('// Resolves a method name with one hash and a switch. Colliding names would');
+  out.writeln('// produce duplicate case labels and fail to compile.');
+  out.writeln('inline Method lookup_method(const char *name) {');
+  out.writeln('  Method method;');
+  out.writeln('  switch (method_hash(name)) {');
+  for (final method in methods) {
+    out.writeln('    case method_hash("${method.name}"):');
+    out.writeln('      method = Method::${_constant(method.name)};');
+    out.writeln('      break;');
+  }
+  out.writeln('    default:');
+  out.writeln('      return Method::kUnknown;');
+  out.writeln('  }');
+  out.writeln('  return strcmp(name, kMethodNames[static_cast<size_t>(method)]) == 0');
+  out.writeln('             ? method');
+  out.writeln('             : Method::kUnknown;');
+  out.writeln('}');
+  out.writeln();
+  out.writeln('}  // namespace channel_api');
+  out.writeln();
+  out.writeln('#endif  // WAYLAND_LAYER_SHELL_CHANNEL_API_G_H_');
+  return out.toString();
+}
+
+String _constant(String name) => 'k${name[0].toUpperCase()}${name.substring(1)}';
+
+String _snakeCase(String name) =>
+    name.replaceAllMapped(RegExp('[A-Z]'), (match) => '_${match[0]!.toLowerCase()}');